@@ -13,12 +13,21 @@
 #include <VCL/Lex/Lexer.hpp>
 #include <VCL/Lex/TokenStream.hpp>
 #include <VCL/AST/ASTContext.hpp>
+#include <VCL/AST/TypePrinter.hpp>
 #include <VCL/Sema/Sema.hpp>
 #include <VCL/Parse/Parser.hpp>
 #include <VCL/CodeGen/CodeGenModule.hpp>
+#include <VCL/CodeGen/Reflection.hpp>
+
+#include <VCL/Core/Target.hpp>
 
 #include <llvm/IR/LLVMContext.h>
 #include <llvm/IR/Module.h>
+#include <llvm/Object/ArchiveWriter.h>
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/Support/Path.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/TargetParser/Triple.h>
 
 #include <iostream>
 #include <fstream>
@@ -27,6 +36,10 @@
 #include <vector>
 #include <cstring>
 #include <filesystem>
+#include <algorithm>
+#include <cctype>
+#include <map>
+#include <set>
 
 
 struct Options {
@@ -35,6 +48,14 @@ struct Options {
     bool generateDebugInformation = false;
     std::string dumpIrFilename{};
     std::string dumpObjFilename{};
+    std::string emitLibFilename{};
+    std::string emitHeaderFilename{};
+    std::string triple{};
+    std::string cpu{};
+    std::string features{};
+    bool multiversion = false;
+    VCL::MathAccuracy mathAccuracy = VCL::MathAccuracy::High;
+    VCL::VectorLibrary vectorLibrary = VCL::VectorLibrary::None;
     std::string entryPoint = "Main";
 };
 
@@ -52,9 +73,17 @@ bool GetOptions(int argc, const char** argv, Options& options) {
             "\n-i, --input <filename>: input source file for pre compilation." 
             "\n-e, --entry-point <name>: name of the program entry point (default is \"Main\")."
             "\n--dump-ir <dir>: dump input file(s) module(s) readable ir into this directory."
-            /*"\n--dump-obj <file>: dump object to disk."
+            "\n--dump-obj <file>: compile ahead of time and write the relocatable object to disk."
+            "\n--emit-lib <file>: compile ahead of time and write a static library along with its symbol manifest (<file>.manifest)."
+            "\n--emit-header <file>: write a C++ header declaring the layout of every in/out variable and a typed invoke function per entry point."
+            "\n--triple <triple>: target triple used for ahead of time compilation (default is the host)."
+            "\n--cpu <name>: target cpu used for ahead of time compilation (default is the host)."
+            "\n--features <features>: target features used for ahead of time compilation, e.g. \"+avx2,+fma\" (default is the host)."
+            "\n--multiversion: compile entry points for SSE2, AVX2 and AVX-512 and select one at runtime from the running cpu (x86-64 only)."
+            "\n--math-accuracy <libm|high|fast>: accuracy of the math functions on vectors of float32, libm call the C library for each lane (default is high)."
+            "\n--vector-library <none|libmvec>: vector math library the optimizer may call, libmvec is glibc's on x86-64 (default is none)."
             "\n--no-optimization: disable any optimization on the ir." 
-            "\n-g: generate debug information." */<< std::endl;
+            /*"\n-g: generate debug information." */<< std::endl;
             return false;
         }
 
@@ -98,7 +127,7 @@ bool GetOptions(int argc, const char** argv, Options& options) {
         }
 
 
-        /*if (strcmp(argv[idx], "--dump-obj") == 0) {
+        if (strcmp(argv[idx], "--dump-obj") == 0) {
             ++idx;
             if (idx >= argc) {
                 std::cout << "Missing filename for --dump-obj." << std::endl;
@@ -109,11 +138,106 @@ bool GetOptions(int argc, const char** argv, Options& options) {
             continue;
         }
 
+        if (strcmp(argv[idx], "--emit-lib") == 0) {
+            ++idx;
+            if (idx >= argc) {
+                std::cout << "Missing filename for --emit-lib." << std::endl;
+                return false;
+            }
+            options.emitLibFilename = argv[idx];
+            ++idx;
+            continue;
+        }
+
+        if (strcmp(argv[idx], "--emit-header") == 0) {
+            ++idx;
+            if (idx >= argc) {
+                std::cout << "Missing filename for --emit-header." << std::endl;
+                return false;
+            }
+            options.emitHeaderFilename = argv[idx];
+            ++idx;
+            continue;
+        }
+
+        if (strcmp(argv[idx], "--triple") == 0) {
+            ++idx;
+            if (idx >= argc) {
+                std::cout << "Missing triple for --triple." << std::endl;
+                return false;
+            }
+            options.triple = argv[idx];
+            ++idx;
+            continue;
+        }
+
+        if (strcmp(argv[idx], "--cpu") == 0) {
+            ++idx;
+            if (idx >= argc) {
+                std::cout << "Missing name for --cpu." << std::endl;
+                return false;
+            }
+            options.cpu = argv[idx];
+            ++idx;
+            continue;
+        }
+
+        if (strcmp(argv[idx], "--features") == 0) {
+            ++idx;
+            if (idx >= argc) {
+                std::cout << "Missing features for --features." << std::endl;
+                return false;
+            }
+            options.features = argv[idx];
+            ++idx;
+            continue;
+        }
+
+        if (strcmp(argv[idx], "--multiversion") == 0) {
+            options.multiversion = true;
+            ++idx;
+            continue;
+        }
+
+        if (strcmp(argv[idx], "--math-accuracy") == 0) {
+            ++idx;
+            if (idx >= argc) {
+                std::cout << "Missing accuracy for --math-accuracy." << std::endl;
+                return false;
+            }
+            std::optional<VCL::MathAccuracy> mathAccuracy = VCL::GetMathAccuracyFromName(argv[idx]);
+            if (!mathAccuracy) {
+                std::cout << "Unknown accuracy \"" << argv[idx] << "\" for --math-accuracy." << std::endl;
+                return false;
+            }
+            options.mathAccuracy = *mathAccuracy;
+            ++idx;
+            continue;
+        }
+
+        if (strcmp(argv[idx], "--vector-library") == 0) {
+            ++idx;
+            if (idx >= argc) {
+                std::cout << "Missing library for --vector-library." << std::endl;
+                return false;
+            }
+            if (strcmp(argv[idx], "none") == 0) {
+                options.vectorLibrary = VCL::VectorLibrary::None;
+            } else if (strcmp(argv[idx], "libmvec") == 0) {
+                options.vectorLibrary = VCL::VectorLibrary::Libmvec;
+            } else {
+                std::cout << "Unknown library \"" << argv[idx] << "\" for --vector-library." << std::endl;
+                return false;
+            }
+            ++idx;
+            continue;
+        }
+
         if (strcmp(argv[idx], "--no-optimization") == 0) {
             options.optimize = false;
             ++idx;
             continue;
-        }*/
+        }
 
         std::cout << "Wrong argument \"" << argv[idx] << "\". This argument does not exist." << std::endl;
         return false;
@@ -123,6 +247,252 @@ bool GetOptions(int argc, const char** argv, Options& options) {
 }
 
 
+/**
+ * Write the symbol manifest of an ahead of time compiled module, one "<kind> <name>" per line.
+ * entry and function are defined by the object, output are out variables defined by the object,
+ * input are in variables the host must define and import are external functions (e.g. libm) the host must link.
+ */
+bool WriteSymbolManifest(llvm::Module& module, const std::string& entryPoint, const std::string& filename) {
+    std::ofstream out{ filename, std::ios::trunc };
+    if (!out.is_open())
+        return false;
+
+    for (llvm::Function& function : module.functions()) {
+        if (function.isIntrinsic() || function.hasLocalLinkage())
+            continue;
+        if (function.isDeclaration())
+            out << "import " << function.getName().str() << "\n";
+        else
+            out << (function.getName() == entryPoint ? "entry " : "function ") << function.getName().str() << "\n";
+    }
+
+    for (llvm::GlobalVariable& global : module.globals()) {
+        if (global.hasLocalLinkage())
+            continue;
+        out << (global.isDeclaration() ? "input " : "output ") << global.getName().str() << "\n";
+    }
+
+    return true;
+}
+
+/** C++ identifier for a VCL name, 'AudioBuffer<float32, 2>' become 'AudioBuffer_float32_2'. */
+std::string MakeIdentifier(llvm::StringRef name) {
+    std::string result{};
+    for (char c : name) {
+        if (std::isalnum((unsigned char)c) || c == '_')
+            result += c;
+        else if (!result.empty() && result.back() != '_')
+            result += '_';
+    }
+    while (!result.empty() && result.back() == '_')
+        result.pop_back();
+    if (result.empty() || std::isdigit((unsigned char)result.front()))
+        result.insert(0, "_");
+    return result;
+}
+
+std::string GetHostScalarType(llvm::StringRef name) {
+    static const llvm::StringMap<std::string> names = {
+        { "bool", "bool" },
+        { "int8", "int8_t" }, { "int16", "int16_t" }, { "int32", "int32_t" }, { "int64", "int64_t" },
+        { "uint8", "uint8_t" }, { "uint16", "uint16_t" }, { "uint32", "uint32_t" }, { "uint64", "uint64_t" },
+        { "float32", "float" }, { "float64", "double" }
+    };
+    auto it = names.find(name);
+    return it != names.end() ? it->second : "";
+}
+
+/** C++ type of a VCL parameter or return type, empty when it is anything but a scalar passed by value. */
+std::string GetHostType(VCL::QualType type) {
+    VCL::Type* canonicalType = VCL::Type::GetCanonicalType(type.GetType());
+    if (canonicalType->GetTypeClass() != VCL::Type::BuiltinTypeClass)
+        return "";
+    if (((VCL::BuiltinType*)canonicalType)->GetKind() == VCL::BuiltinType::Void)
+        return "void";
+    return GetHostScalarType(VCL::TypePrinter::Print(VCL::QualType{ canonicalType }));
+}
+
+struct HostHeader {
+    using TypeInfo = VCL::ModuleReflection::TypeInfo;
+
+    std::ostringstream types{};
+    std::ostringstream asserts{};
+    std::map<const TypeInfo*, std::string> names{};
+    std::set<std::string> declared{};
+
+    /** Declare type and everything it is made of, in dependency order, and return its C++ name. */
+    std::string Declare(const TypeInfo* type) {
+        if (auto it = names.find(type); it != names.end())
+            return it->second;
+
+        if (type->kind == TypeInfo::Kind::Scalar) {
+            std::string name = GetHostScalarType(type->name);
+            names.insert({ type, name });
+            return name;
+        }
+
+        std::string element = type->elementType ? Declare(type->elementType) : "";
+        std::vector<std::string> fields{};
+        for (const TypeInfo::Field& field : type->fields)
+            fields.push_back(Declare(field.type));
+
+        std::string name = MakeIdentifier(type->name);
+        names.insert({ type, name });
+        if (!declared.insert(name).second)
+            return name;
+
+        switch (type->kind) {
+            case TypeInfo::Kind::Vector:
+                types << "    struct alignas(" << type->alignment << ") " << name << " {\n";
+                // Lanes of Vec<bool> are packed bits.
+                if (type->stride != 0)
+                    types << "        " << element << " lanes[" << type->elementCount << "];\n";
+                else
+                    types << "        uint8_t bits[" << type->size << "];\n";
+                types << "    };\n\n";
+                break;
+            case TypeInfo::Kind::Lanes:
+            case TypeInfo::Kind::Array:
+                types << "    using " << name << " = " << element << "[" << type->elementCount << "];\n\n";
+                break;
+            case TypeInfo::Kind::Span:
+                types << "    using " << name << " = Span<" << element << ">;\n\n";
+                break;
+            case TypeInfo::Kind::Record:
+                types << "    struct alignas(" << type->alignment << ") " << name << " {\n";
+                for (size_t i = 0; i < fields.size(); ++i)
+                    types << "        " << fields[i] << " " << type->fields[i].name << ";\n";
+                types << "    };\n\n";
+                for (const TypeInfo::Field& field : type->fields)
+                    asserts << "    static_assert(offsetof(" << name << ", " << field.name << ") == " << field.offset << ");\n";
+                break;
+            default:
+                break;
+        }
+        asserts << "    static_assert(sizeof(" << name << ") == " << type->size << " && alignof(" << name << ") == " << type->alignment << ");\n";
+        return name;
+    }
+};
+
+/**
+ * Write a C++ header matching the module layout, every type is checked against the compiled layout with static_asserts.
+ * In/out variables are described in the 'symbols' namespace and bound with Bind, each entry point get an Invoke<Name>
+ * calling it through the address returned by the session lookup or the linker. Entry points taking or returning
+ * anything but scalars are left out, as are their block wrappers.
+ */
+bool WriteHostHeader(llvm::Module& module, VCL::CompilerInstance& instance, const VCL::ModuleReflection& reflection, 
+        uint32_t vectorWidthInElement, const std::string& source, const std::string& filename) {
+    std::ofstream out{ filename, std::ios::trunc };
+    if (!out.is_open())
+        return false;
+
+    std::string namespaceName = MakeIdentifier(llvm::sys::path::stem(source));
+
+    HostHeader header{};
+    for (const VCL::ModuleReflection::Symbol& symbol : reflection.GetSymbols())
+        header.Declare(symbol.type);
+
+    out << "// Generated by cvcl from '" << source << "' for " << module.getTargetTriple() << ", do not edit.\n"
+        << "#pragma once\n\n"
+        << "#include <cstddef>\n"
+        << "#include <cstdint>\n\n\n"
+        << "namespace " << namespaceName << " {\n\n"
+        << "    /** Lanes in every Vec, fixed by the target the module was compiled for. */\n"
+        << "    inline constexpr uint32_t VectorWidthInElement = " << vectorWidthInElement << ";\n\n"
+        << "    template<typename T>\n"
+        << "    struct Span {\n"
+        << "        T* data;\n"
+        << "        uint64_t count;\n"
+        << "    };\n\n"
+        << header.types.str()
+        << header.asserts.str() << "\n"
+        << "    namespace symbols {\n\n";
+
+    for (const VCL::ModuleReflection::Symbol& symbol : reflection.GetSymbols()) {
+        // Qualified so a symbol named after its type doesn't refer to itself.
+        std::string typeName = header.names.at(symbol.type);
+        if (symbol.type->kind != VCL::ModuleReflection::TypeInfo::Kind::Scalar)
+            typeName = namespaceName + "::" + typeName;
+        out << "        /** " << (symbol.in && symbol.out ? "inout " : (symbol.in ? "in " : "out ")) << symbol.type->name << " " << symbol.name << " */\n"
+            << "        struct " << symbol.name << " {\n"
+            << "            using Type = " << typeName << ";\n"
+            << "            static constexpr const char* name = \"" << symbol.name << "\";\n"
+            << "            static constexpr bool in = " << (symbol.in ? "true" : "false") << ";\n"
+            << "            static constexpr bool out = " << (symbol.out ? "true" : "false") << ";\n"
+            << "        };\n\n";
+    }
+
+    out << "    }\n\n"
+        << "    /** Bind value to Symbol, session is anything with DefineSymbolPtr like VCL::ExecutionSession. */\n"
+        << "    template<typename Symbol, typename Session>\n"
+        << "    inline bool Bind(Session& session, typename Symbol::Type* value) {\n"
+        << "        return session.DefineSymbolPtr(Symbol::name, (void*)value);\n"
+        << "    }\n";
+
+    auto writeInvoke = [&out](const std::string& name, const std::string& returnType, const std::vector<std::string>& paramTypes) {
+        std::string signature{}, params{}, args{};
+        for (size_t i = 0; i < paramTypes.size(); ++i) {
+            std::string separator = i == 0 ? "" : ", ";
+            signature += separator + paramTypes[i];
+            params += ", " + paramTypes[i] + " arg" + std::to_string(i);
+            args += separator + "arg" + std::to_string(i);
+        }
+        out << "\n"
+            << "    inline " << returnType << " Invoke" << name << "(void* address" << params << ") {\n"
+            << "        return ((" << returnType << "(*)(" << signature << "))address)(" << args << ");\n"
+            << "    }\n";
+    };
+
+    // Signatures come from the declarations, the IR types lose the signedness of integers.
+    VCL::AttributeTable& attributeTable = instance.GetCompilerContext().GetAttributeTable();
+    VCL::IdentifierTable& identifierTable = instance.GetCompilerContext().GetIdentifierTable();
+    VCL::AttributeDefinition* entryPointAD = attributeTable.GetDefinition(identifierTable.Get("EntryPoint"));
+    VCL::AttributeDefinition* blockAD = attributeTable.GetDefinition(identifierTable.Get("Block"));
+
+    VCL::TranslationUnitDecl* tu = instance.GetASTContext().GetTranslationUnitDecl();
+    for (auto it = tu->Begin(); it != tu->End(); ++it) {
+        if (it->GetDeclClass() != VCL::Decl::FunctionDeclClass)
+            continue;
+        VCL::FunctionDecl* decl = (VCL::FunctionDecl*)it.Get();
+        std::string name = decl->GetIdentifierInfo()->GetName().str();
+        llvm::Function* function = module.getFunction(name);
+        if (!decl->HasAttribute(entryPointAD) || !function || function->isDeclaration())
+            continue;
+
+        std::string returnType = GetHostType(decl->GetType()->GetReturnType());
+        std::vector<std::string> paramTypes{};
+        for (VCL::QualType paramType : decl->GetType()->GetParamsType())
+            paramTypes.push_back(GetHostType(paramType));
+        if (returnType.empty() || std::find(paramTypes.begin(), paramTypes.end(), "") != paramTypes.end())
+            continue;
+
+        writeInvoke(name, returnType, paramTypes);
+        if (decl->HasAttribute(blockAD) && module.getFunction(name + "Block"))
+            writeInvoke(name + "Block", "void", { "uint64_t" });
+    }
+
+    out << "\n}";
+    return true;
+}
+
+bool WriteStaticLibrary(llvm::StringRef object, const llvm::Triple& triple, const std::string& filename) {
+    llvm::object::Archive::Kind kind = llvm::object::Archive::K_GNU;
+    if (triple.isOSDarwin())
+        kind = llvm::object::Archive::K_DARWIN;
+    else if (triple.isOSWindows())
+        kind = llvm::object::Archive::K_COFF;
+
+    std::string memberName = llvm::sys::path::stem(filename).str() + (triple.isOSWindows() ? ".obj" : ".o");
+    llvm::NewArchiveMember member{ llvm::MemoryBufferRef{ object, memberName } };
+    member.MemberName = memberName;
+
+    if (llvm::Error err = llvm::writeArchive(filename, { member }, llvm::SymtabWritingMode::NormalSymtab, kind, true, false); err) {
+        std::cout << llvm::toString(std::move(err)) << std::endl;
+        return false;
+    }
+    return true;
+}
+
 int main(int argc, const char* argv[]) {
     Options options{};
     if (!GetOptions(argc, argv, options))
@@ -133,17 +503,37 @@ int main(int argc, const char* argv[]) {
         return 0;
     }
 
+    bool aheadOfTime = !options.dumpObjFilename.empty() || !options.emitLibFilename.empty();
+
     VCL::TextDiagnosticConsumer diagnosticConsumer{};
     VCL::CompilerContext cc{};
-    VCL::ExecutionSession session{};
-    cc.GetInvocation().GetDiagnosticOptions().SetDiagnosticConsumer(&diagnosticConsumer);
+    cc.GetInvocation()->GetDiagnosticOptions().SetDiagnosticConsumer(&diagnosticConsumer);
+
+    VCL::TargetOptions& targetOptions = cc.GetInvocation()->GetTargetOptions();
+    if (!options.triple.empty()) {
+        // Cross compilation, the native target alone is not enough.
+        llvm::InitializeAllTargetInfos();
+        llvm::InitializeAllTargets();
+        llvm::InitializeAllTargetMCs();
+        llvm::InitializeAllAsmPrinters();
+        targetOptions.SetTriple(options.triple);
+    }
+    if (!options.cpu.empty())
+        targetOptions.SetCPU(options.cpu);
+    if (!options.features.empty())
+        targetOptions.SetFeatures(options.features);
+    // Precompiled kernels are linked into position independent hosts.
+    if (aheadOfTime)
+        targetOptions.SetRelocModel(llvm::Reloc::PIC_);
+    targetOptions.SetVectorLibrary(options.vectorLibrary);
 
     cc.CreateDiagnosticEngine();
     cc.CreateSourceManager();
     cc.CreateIdentifierTable();
     cc.CreateAttributeTable();
     cc.CreateDirectiveRegistry();
-    cc.CreateTarget();
+    if (!cc.CreateTarget())
+        return -1;
     cc.CreateTypeCache();
     cc.CreateModuleCache();
     cc.CreateLLVMContext();
@@ -157,7 +547,17 @@ int main(int argc, const char* argv[]) {
 
     VCL::Source* source = cc.GetSourceManager().LoadFromDisk(options.inputFilename);
 
-    VCL::EmitLLVMAction act{};
+    if (!source) {
+        std::cout << "Couldn't read '" << options.inputFilename << "'." << std::endl;
+        return -1;
+    }
+
+    VCL::EmitObjectAction objectAct{};
+    VCL::EmitLLVMAction llvmAct{};
+    VCL::EmitLLVMAction& act = aheadOfTime ? objectAct : llvmAct;
+    act.SetRunOptimization(options.optimize);
+    act.SetMultiversioning(options.multiversion);
+    act.SetMathAccuracy(options.mathAccuracy);
 
     std::shared_ptr<VCL::CompilerInstance> instance = cc.CreateInstance();
     instance->BeginSource(source);
@@ -178,7 +578,49 @@ int main(int argc, const char* argv[]) {
         irOutFile.close();
         std::cout << "ir written to '" << options.dumpIrFilename << "'" << std::endl;
     }
-    
+
+    if (!options.emitHeaderFilename.empty()) {
+        std::optional<VCL::ModuleReflection> reflection = VCL::ModuleReflection::Get(*act.GetModule().getModuleUnlocked());
+        // Multiversioned modules have no single layout to describe.
+        if (!reflection.has_value()) {
+            std::cout << "No layout to write a header from, --emit-header can't be used along with --multiversion." << std::endl;
+            return -1;
+        }
+        if (!WriteHostHeader(*act.GetModule().getModuleUnlocked(), *instance, *reflection, cc.GetTarget().GetVectorWidthInElement(), 
+                options.inputFilename, options.emitHeaderFilename))
+            return -1;
+        std::cout << "header written to '" << options.emitHeaderFilename << "'" << std::endl;
+    }
+
+    if (aheadOfTime) {
+        if (!options.dumpObjFilename.empty()) {
+            std::ofstream objOutFile{ options.dumpObjFilename, std::ios::binary | std::ios::trunc };
+            objOutFile << objectAct.GetObject().str();
+            objOutFile.close();
+            std::cout << "object written to '" << options.dumpObjFilename << "'" << std::endl;
+        }
+
+        if (!options.emitLibFilename.empty()) {
+            llvm::Triple triple = cc.GetTarget().GetTargetMachine()->getTargetTriple();
+            if (!WriteStaticLibrary(objectAct.GetObject(), triple, options.emitLibFilename))
+                return -1;
+            std::string manifestFilename = options.emitLibFilename + ".manifest";
+            if (!WriteSymbolManifest(*act.GetModule().getModuleUnlocked(), entryPointName, manifestFilename))
+                return -1;
+            std::cout << "library written to '" << options.emitLibFilename << "' (manifest '" << manifestFilename << "')" << std::endl;
+        }
+
+        return 0;
+    }
+
+    VCL::ExecutionSession session{};
+    if (options.vectorLibrary == VCL::VectorLibrary::Libmvec) {
+        session.DefineLibmvecIntrinsic();
+        if (llvm::Error err = session.ConsumeLastError(); err) {
+            std::cout << llvm::toString(std::move(err)) << std::endl;
+            return -1;
+        }
+    }
     if (!session.SubmitModule(act.MoveModule())) {
         std::cout << llvm::toString(session.ConsumeLastError()) << std::endl;
         return -1;
@@ -278,9 +278,15 @@ namespace VCL {
             ASin, ACos, ATan, ATan2,
             Sqrt, Log, Log2, Log10,
             Exp, Exp2,
-            Floor, Ceil, Round, Abs,
+            Floor, Ceil, Round, Fract, Abs,
             // Unary Vec Intrinsic
             Unpack, Pack, Reverse,
+            // Vec Reduction Intrinsic
+            ReduceAdd, ReduceMul, ReduceMin, ReduceMax, ReduceAny, ReduceAll,
+            // Vec Lane Intrinsic
+            Shuffle, Rotate, Slide, Broadcast,
+            // Vec Scan Intrinsic
+            PrefixSum, LinearRecurrence,
             // Unary Array Intrinsic
             Length,
             // Binary Math Intrinsic
@@ -288,8 +294,10 @@ namespace VCL {
             FMod,
             // Ternary Math Intrinsic
             Fma,
+            // Span Intrinsic
+            Gather, Scatter, MaskedLoad, MaskedStore,
             // Other Intrinsic
-            Select
+            Select, LaneMask
         };
 
     public:
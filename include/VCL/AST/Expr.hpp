@@ -366,8 +366,8 @@ namespace VCL {
 
     class SubscriptExpr : public Expr {
     public:
-        SubscriptExpr(Expr* expr, Expr* index, bool isSpan) 
-                : expr{ expr }, index{ index }, isSpan{ isSpan }, Expr{ Expr::SubscriptExprClass } {
+        SubscriptExpr(Expr* expr, Expr* index, bool isSpan, bool isGather) 
+                : expr{ expr }, index{ index }, isSpan{ isSpan }, isGather{ isGather }, Expr{ Expr::SubscriptExprClass } {
             SetValueCategory(Expr::LValue);
             SetDependent(expr->IsDependent() || index->IsDependent());
         }
@@ -376,12 +376,17 @@ namespace VCL {
         inline Expr* GetExpr() { return expr; }
         inline Expr* GetIndex() { return index; }
         inline bool IsSpan() const { return isSpan; }
+        /** Span subscripted by a vector of indices, its address is a vector of pointers loaded with a gather and stored with a scatter. */
+        inline bool IsGather() const { return isGather; }
 
         static inline SubscriptExpr* Create(ASTContext& context, Expr* expr, Expr* index, QualType resultType, SourceRange range) {
             bool isSpan = false;
+            bool isGather = false;
             if (!expr->GetResultType().GetType()->IsDependent())
                 isSpan = Type::GetCanonicalType(expr->GetResultType().GetType())->GetTypeClass() == Type::SpanTypeClass;
-            SubscriptExpr* instance = context.AllocateNode<SubscriptExpr>(expr, index, isSpan);
+            if (isSpan && !index->GetResultType().GetType()->IsDependent())
+                isGather = Type::GetCanonicalType(index->GetResultType().GetType())->GetTypeClass() == Type::VectorTypeClass;
+            SubscriptExpr* instance = context.AllocateNode<SubscriptExpr>(expr, index, isSpan, isGather);
             instance->SetResultType(resultType);
             instance->SetSourceRange(range);
             return instance;
@@ -391,6 +396,7 @@ namespace VCL {
         Expr* expr;
         Expr* index;
         bool isSpan;
+        bool isGather;
     };
 
     class NullExpr : public Expr {
@@ -22,13 +22,22 @@ namespace VCL {
         CodeGenFunction& operator=(const CodeGenFunction& other) = delete;
         CodeGenFunction& operator=(CodeGenFunction&& other) = delete;
 
-        llvm::Function* Generate(FunctionDecl* decl, bool imported = false);
+        /**
+         * Generate the function of decl. A masked function take the lanes active at its call as a last
+         * Vec<bool> parameter, it is called under varying control flow so its stores only touch those lanes.
+         */
+        llvm::Function* Generate(FunctionDecl* decl, bool imported = false, bool masked = false);
 
         llvm::AllocaInst* GenerateAllocaInst(llvm::Type* type, llvm::StringRef name);
         llvm::AllocaInst* GenerateAllocaInst(QualType type, llvm::StringRef name);
 
         llvm::Value* GetDeclValue(Decl* decl);
 
+        /** Load a value of type from ptr, a vector of pointers is gathered in the lanes active under varying control flow. */
+        llvm::Value* GenerateLoad(llvm::Type* type, llvm::Value* ptr);
+        /** Store value to ptr, only in the lanes active under varying control flow when value is a vector. A vector of pointers is scattered. */
+        llvm::Instruction* GenerateStore(llvm::Value* value, llvm::Value* ptr);
+
         void PushBreakBB(llvm::BasicBlock* breakBB);
         void PopBreakBB();
         void PushContinueBB(llvm::BasicBlock* continueBB);
@@ -46,6 +55,8 @@ namespace VCL {
         bool GenerateForStmt(ForStmt* stmt);
         bool GenerateBreakStmt(BreakStmt* stmt);
         bool GenerateContinueStmt(ContinueStmt* stmt);
+        bool GenerateVaryingIfStmt(IfStmt* stmt, llvm::Value* condition);
+        bool GenerateVaryingLoop(Expr* condition, Expr* loopExpr, Stmt* thenStmt);
 
         // CGDecl
 
@@ -79,6 +90,11 @@ namespace VCL {
         llvm::Value* DispatchBinaryComparisonOp(Expr* lhs, Expr* rhs, llvm::CmpInst::Predicate signedPredicate,
             llvm::CmpInst::Predicate floatPredicate);
 
+        /** Lanes offset to offset + width - 1 of lhs followed by rhs, offset in [0, width]. */
+        llvm::Value* GenerateLaneSlide(llvm::Value* lhs, llvm::Value* rhs, llvm::Value* offset);
+        /** Lanes y[i] = a[i] * y[i - 1] + b[i], y[-1] loaded from state which then receive the last lane. */
+        llvm::Value* GenerateLinearRecurrence(llvm::Value* a, llvm::Value* b, llvm::Value* state);
+
     private:
         CodeGenModule& cgm;
         
@@ -89,8 +105,17 @@ namespace VCL {
 
         llvm::SmallVector<llvm::BasicBlock*, 16> breakBBStack;
         llvm::SmallVector<llvm::BasicBlock*, 16> continueBBStack;
+        /** Mask active when each loop of breakBBStack was entered, break and continue cannot change it. */
+        llvm::SmallVector<llvm::Value*, 16> loopMaskStack;
+
+        /** Lanes active under varying control flow, nullptr when every lane is. */
+        llvm::Value* mask;
+        /** Lanes active when entering the function, the mask parameter of a masked function. */
+        llvm::Value* entryMask;
 
         bool strictIEEE;
+        /** [AllowApproxFunctions], math intrinsics on Vec<float32> then use MathAccuracy::Fast whatever the module accuracy. */
+        bool allowApproxFunc;
     };
     
 }
\ No newline at end of file
@@ -10,11 +10,15 @@
 #include <VCL/Sema/ModuleTable.hpp>
 #include <VCL/CodeGen/CodeGenTypes.hpp>
 #include <VCL/CodeGen/CodeGenFunction.hpp>
+#include <VCL/CodeGen/MathAccuracy.hpp>
 
 #include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
 #include <llvm/ADT/DenseMap.h>
 #include <llvm/IR/GlobalValue.h>
 #include <llvm/IR/Constant.h>
+#include <llvm/IR/GlobalVariable.h>
+#include <llvm/IR/Metadata.h>
+#include <llvm/ADT/SmallVector.h>
 
 
 namespace VCL {
@@ -40,6 +44,21 @@ namespace VCL {
         inline AttributeTable& GetAttributeTable() { return attributeTable; }
         inline IdentifierTable& GetIdentifierTable() { return identifierTable; }
 
+        /** Lower in/out variables into an instance context passed by pointer to the entry points. */
+        inline bool GetUseInstanceContext() const { return useInstanceContext; }
+        inline void SetUseInstanceContext(bool useInstanceContext) { this->useInstanceContext = useInstanceContext; }
+
+        /**
+         * Emit imported functions and variables in this module rather than linking the imported modules,
+         * so they are generated for this module Target. Used when compiling one module for several targets.
+         */
+        inline bool GetEmitImportedDefinitions() const { return emitImportedDefinitions; }
+        inline void SetEmitImportedDefinitions(bool emitImportedDefinitions) { this->emitImportedDefinitions = emitImportedDefinitions; }
+
+        /** Accuracy of the math intrinsics called on Vec<float32>, see MathAccuracy. */
+        inline MathAccuracy GetMathAccuracy() const { return mathAccuracy; }
+        inline void SetMathAccuracy(MathAccuracy mathAccuracy) { this->mathAccuracy = mathAccuracy; }
+
         bool LinkNow();
 
         bool Emit(bool verifyModule = true);
@@ -53,6 +72,28 @@ namespace VCL {
         bool EmitImportedDecl(Decl* decl);
 
         llvm::GlobalValue* GetGlobalDeclValue(Decl* decl);
+        /** Masked function of decl, called under varying control flow, generated on first use. */
+        llvm::Function* GetMaskedFunction(FunctionDecl* decl);
+        inline void AddMaskedFunction(FunctionDecl* decl, llvm::Function* function) { maskedFunctions.insert({ decl, function }); }
+
+        // CGBlock
+
+        bool EmitBlockEntryPoint(FunctionDecl* decl, llvm::Function* function);
+
+        // CGInstanceContext
+
+        bool LowerInstanceContext();
+
+        // CGReflection
+
+        /** Record the layout of every in/out variable in the module metadata, see ModuleReflection. */
+        bool EmitReflection();
+        llvm::MDNode* GenerateTypeReflection(QualType type);
+
+        // CGMath
+
+        /** Vector implementation of a math intrinsic on type at accuracy, nullptr when the C library is called instead. */
+        llvm::Function* GetVectorMathFunction(FunctionDecl::IntrinsicID id, llvm::Type* type, MathAccuracy accuracy);
 
         // CGConstantValue
 
@@ -71,6 +112,12 @@ namespace VCL {
         IdentifierTable& identifierTable;
 
         llvm::DenseMap<Decl*, llvm::GlobalValue*> globals;
+        llvm::DenseMap<FunctionDecl*, llvm::Function*> maskedFunctions;
+        llvm::SmallVector<std::pair<VarDecl*, llvm::GlobalVariable*>> contextGlobals;
+        llvm::SmallVector<std::pair<FunctionDecl*, llvm::Function*>> blockEntryPoints;
+        bool useInstanceContext = false;
+        bool emitImportedDefinitions = false;
+        MathAccuracy mathAccuracy = MathAccuracy::High;
         
         CodeGenTypes cgt;
     };
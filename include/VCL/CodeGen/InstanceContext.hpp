@@ -0,0 +1,70 @@
+#pragma once
+
+#include <llvm/IR/Module.h>
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/ADT/StringRef.h>
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+
+namespace VCL {
+
+    /**
+     * Layout of the instance context generated when in/out variables are lowered into a struct
+     * passed by pointer to the entry points (see EmitLLVMAction::SetUseInstanceContext).
+     * The host allocate one context per instance (voice, stream, ...) with this size and alignment,
+     * write inputs and read outputs at the fields offset, then call the entry point with it.
+     */
+    class InstanceContextLayout {
+    public:
+        struct Field {
+            std::string name;
+            uint64_t offset;
+            uint64_t size;
+            bool in;
+            bool out;
+        };
+
+    public:
+        InstanceContextLayout() = default;
+        InstanceContextLayout(const InstanceContextLayout& other) = default;
+        InstanceContextLayout(InstanceContextLayout&& other) = default;
+        ~InstanceContextLayout() = default;
+
+        InstanceContextLayout& operator=(const InstanceContextLayout& other) = default;
+        InstanceContextLayout& operator=(InstanceContextLayout&& other) = default;
+
+        /** Read the layout recorded in the module metadata, nothing if the module wasn't compiled with an instance context. */
+        static std::optional<InstanceContextLayout> Get(const llvm::Module& module);
+
+        inline uint64_t GetSize() const { return size; }
+        inline uint64_t GetAlignment() const { return alignment; }
+
+        inline llvm::ArrayRef<Field> GetFields() const { return fields; }
+        inline const Field* GetField(llvm::StringRef name) const {
+            for (const Field& field : fields)
+                if (field.name == name)
+                    return &field;
+            return nullptr;
+        }
+
+        template<typename T>
+        inline T* GetFieldPtr(void* context, llvm::StringRef name) const {
+            const Field* field = GetField(name);
+            return field ? (T*)((uint8_t*)context + field->offset) : nullptr;
+        }
+
+    public:
+        static constexpr llvm::StringLiteral FieldsMetadataName = "vcl.context";
+        static constexpr llvm::StringLiteral LayoutMetadataName = "vcl.context.layout";
+
+    private:
+        uint64_t size = 0;
+        uint64_t alignment = 1;
+        llvm::SmallVector<Field> fields{};
+    };
+
+}
\ No newline at end of file
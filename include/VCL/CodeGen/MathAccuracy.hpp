@@ -0,0 +1,47 @@
+#pragma once
+
+#include <llvm/ADT/StringRef.h>
+
+#include <optional>
+
+
+namespace VCL {
+
+    /**
+     * Accuracy of the math intrinsics called on Vec<float32>, see CGMath. Bounds are for float32 results,
+     * everything else, scalars, float64 and [StrictIEEE] functions, always call the C library.
+     * Functions marked [AllowApproxFunctions] use Fast whatever the module accuracy.
+     */
+    enum class MathAccuracy {
+        /** Call the C library once per lane. */
+        Libm,
+        /**
+         * Vector polynomials within 2 ULP for exp, exp2, log, log2, log10 and tanh, within 2 ULP for sin and cos
+         * when |x| <= 8192 (1e-7 absolute near their zeros), within 4 ULP for tan when |x| < pi / 2,
+         * and within 8 ULP for pow while |y * log2(x)| <= 32, growing linearly beyond.
+         */
+        High,
+        /**
+         * Shorter polynomials within 1e-4 relative error (absolute for sin and cos) for sin, cos, exp, exp2 and pow,
+         * within 2e-5 relative error for log, log2, log10 and tanh, tan is High.
+         */
+        Fast
+    };
+
+    inline llvm::StringRef GetMathAccuracyName(MathAccuracy accuracy) {
+        switch (accuracy) {
+            case MathAccuracy::Libm: return "libm";
+            case MathAccuracy::High: return "high";
+            case MathAccuracy::Fast: return "fast";
+        }
+        return "";
+    }
+
+    inline std::optional<MathAccuracy> GetMathAccuracyFromName(llvm::StringRef name) {
+        for (MathAccuracy accuracy : { MathAccuracy::Libm, MathAccuracy::High, MathAccuracy::Fast })
+            if (GetMathAccuracyName(accuracy) == name)
+                return accuracy;
+        return {};
+    }
+
+}
\ No newline at end of file
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <VCL/Core/Diagnostic.hpp>
+
+#include <llvm/IR/Module.h>
+#include <llvm/TargetParser/Triple.h>
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/MapVector.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/ADT/StringRef.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+
+namespace VCL {
+
+    /** One code path of a multiversioned module, compiled for cpu with features. */
+    struct TargetVersion {
+        llvm::StringLiteral name;
+        llvm::StringLiteral cpu;
+        llvm::StringLiteral features;
+    };
+
+    /**
+     * Merge the same module compiled for several targets into one, then emit for each entry point
+     * a dispatcher selecting the version supported by the running CPU on its first call.
+     * Every dispatcher and the exported 'uint32 GetVectorWidthInElement()' agree on the selected version,
+     * the host use it to size the buffers bound to vector in/out variables.
+     */
+    class Multiversioner {
+    public:
+        Multiversioner() = delete;
+        Multiversioner(llvm::Module& module, DiagnosticReporter& diagnosticReporter);
+        Multiversioner(const Multiversioner& other) = delete;
+        Multiversioner(Multiversioner&& other) = delete;
+        ~Multiversioner() = default;
+
+        Multiversioner& operator=(const Multiversioner& other) = delete;
+        Multiversioner& operator=(Multiversioner&& other) = delete;
+
+        /** Versions compiled in multiversioning mode, from the least to the most capable. */
+        static llvm::ArrayRef<TargetVersion> GetVersions();
+        static bool IsSupported(const llvm::Triple& triple);
+
+        /**
+         * Rename the entry points of version after target, make everything else local to it and link it into the module.
+         * Versions must be added in the order of GetVersions.
+         */
+        bool AddVersion(std::unique_ptr<llvm::Module> version, const TargetVersion& target, uint32_t vectorWidthInByte);
+        /** Emit the entry point dispatchers once every version is added. */
+        bool EmitDispatchers();
+
+    private:
+        struct GlobalDefinition {
+            llvm::Type* type;
+            llvm::Constant* initializer;
+            bool isConstant;
+            llvm::MaybeAlign alignment;
+            uint64_t size;
+        };
+
+        llvm::Function* EmitCPULevel();
+
+    private:
+        llvm::Module& module;
+        DiagnosticReporter& diagnosticReporter;
+        llvm::SmallVector<uint32_t> vectorWidthsInByte{};
+        llvm::MapVector<std::string, llvm::SmallVector<std::string>> entryPoints{};
+        llvm::MapVector<std::string, GlobalDefinition> globalDefinitions{};
+    };
+
+}
\ No newline at end of file
@@ -1,5 +1,11 @@
 #pragma once
 
+#include <VCL/Core/TargetOptions.hpp>
+
+
+namespace llvm {
+    class Module;
+}
 
 namespace VCL {
     class CodeGenModule;
@@ -14,7 +20,16 @@ namespace VCL {
         Optimizer& operator=(const Optimizer& other) = default;
         Optimizer& operator=(Optimizer&& other) = default;
 
+        /** Let the vectorizer call the functions of vectorLibrary and replace the math intrinsics on vectors with them. */
+        inline VectorLibrary GetVectorLibrary() const { return vectorLibrary; }
+        inline void SetVectorLibrary(VectorLibrary vectorLibrary) { this->vectorLibrary = vectorLibrary; }
+
+        /** Link the imported modules then optimize. */
         bool Optimize(CodeGenModule& cgm);
+        bool Optimize(llvm::Module& module);
+
+    private:
+        VectorLibrary vectorLibrary = VectorLibrary::None;
     };
 
 }
\ No newline at end of file
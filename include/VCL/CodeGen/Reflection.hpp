@@ -0,0 +1,107 @@
+#pragma once
+
+#include <llvm/IR/Module.h>
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/ADT/StringRef.h>
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+
+namespace VCL {
+
+    /**
+     * Memory layout of every in/out variable of a compiled module, computed with the module DataLayout
+     * when it is generated. Lets the host bind its own storage to the symbols (see ExecutionSession::DefineSymbolPtr)
+     * without guessing how VCL types are lowered.
+     * Vector sizes depend on the Target the module was compiled for, multiversioned modules carry no reflection.
+     */
+    class ModuleReflection {
+    public:
+        struct TypeInfo {
+            enum class Kind {
+                Scalar,
+                Vector,
+                Lanes,
+                Array,
+                Span,
+                Record
+            };
+
+            struct Field {
+                std::string name;
+                uint64_t offset;
+                const TypeInfo* type;
+            };
+
+            Kind kind;
+            /** VCL spelling of the type, 'AudioBuffer<float32, 2>'. */
+            std::string name;
+            uint64_t size;
+            uint64_t alignment;
+            /** Element count of vectors, lanes and arrays, 0 otherwise. */
+            uint64_t elementCount = 0;
+            /** Distance in bytes between two elements of vectors, lanes, arrays and spans, whose data is held by the host. */
+            uint64_t stride = 0;
+            const TypeInfo* elementType = nullptr;
+            /** Fields of records, in declaration order. */
+            llvm::SmallVector<Field> fields{};
+
+            inline uint64_t GetElementOffset(uint64_t index) const { return index * stride; }
+            inline const Field* GetField(llvm::StringRef name) const {
+                for (const Field& field : fields)
+                    if (field.name == name)
+                        return &field;
+                return nullptr;
+            }
+
+            /**
+             * Offset from the start of a value of this type of a member reached by path, like 'channels[1]'.
+             * Spans can't be subscripted, their elements aren't stored in the value.
+             */
+            std::optional<uint64_t> GetOffset(llvm::StringRef path, const TypeInfo** type = nullptr) const;
+        };
+
+        struct Symbol {
+            std::string name;
+            const TypeInfo* type;
+            bool in;
+            bool out;
+        };
+
+    public:
+        ModuleReflection() = default;
+        ModuleReflection(const ModuleReflection& other) = delete;
+        ModuleReflection(ModuleReflection&& other) = default;
+        ~ModuleReflection() = default;
+
+        ModuleReflection& operator=(const ModuleReflection& other) = delete;
+        ModuleReflection& operator=(ModuleReflection&& other) = default;
+
+        /** Read the reflection recorded in the module metadata, nothing if the module has none (cached or multiversioned). */
+        static std::optional<ModuleReflection> Get(const llvm::Module& module);
+
+        inline llvm::ArrayRef<Symbol> GetSymbols() const { return symbols; }
+        inline const Symbol* GetSymbol(llvm::StringRef name) const {
+            for (const Symbol& symbol : symbols)
+                if (symbol.name == name)
+                    return &symbol;
+            return nullptr;
+        }
+
+        /** Offset from the start of a symbol of a member reached by path, like 'buffer.channels[1]'. */
+        std::optional<uint64_t> GetOffset(llvm::StringRef path, const TypeInfo** type = nullptr) const;
+
+    public:
+        static constexpr llvm::StringLiteral MetadataName = "vcl.reflection";
+
+    private:
+        llvm::SmallVector<Symbol> symbols{};
+        std::vector<std::unique_ptr<TypeInfo>> types{};
+    };
+
+}
\ No newline at end of file
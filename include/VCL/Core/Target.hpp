@@ -9,6 +9,7 @@
 #include <llvm/ADT/IntrusiveRefCntPtr.h>
 
 #include <cstdint>
+#include <string>
 #include <expected>
 
 
@@ -28,6 +29,10 @@ namespace VCL {
 
         inline llvm::TargetMachine* GetTargetMachine() { return tm.get(); }
 
+        /** False when the target machine could not be created, GetError then tell why. */
+        inline bool IsValid() const { return tm != nullptr; }
+        inline llvm::StringRef GetError() const { return error; }
+
         /** Always the same number of element in a vector, let llvm do its magic while lowering */
         inline uint32_t GetVectorWidthInElement() const { return vectorWidthInByte / 4; }
 
@@ -38,7 +43,8 @@ namespace VCL {
     
     private:
         std::unique_ptr<llvm::TargetMachine> tm;
-        uint32_t vectorWidthInByte;
+        uint32_t vectorWidthInByte = 0;
+        std::string error;
     };
 
 }
\ No newline at end of file
@@ -1,13 +1,22 @@
 #pragma once
 
 #include <llvm/TargetParser/Host.h>
+#include <llvm/Support/CodeGen.h>
 #include <llvm/ADT/StringRef.h>
 
 #include <string>
+#include <optional>
 
 
 namespace VCL {
 
+    /** Vector math library the optimizer may call in place of math functions on vectors. */
+    enum class VectorLibrary {
+        None,
+        /** glibc libmvec on x86-64, its symbols must be defined in the session, see ExecutionSession::DefineLibmvecIntrinsic. */
+        Libmvec
+    };
+
     class TargetOptions {
     public:
         TargetOptions();
@@ -19,7 +28,8 @@ namespace VCL {
         TargetOptions& operator=(TargetOptions&& other) = default;
 
         inline llvm::StringRef GetTriple() { return triple; }
-        inline void SetTriple(std::string& triple) { this->triple = triple; }
+        /** A triple other than the host one also reset the CPU and features to generic, set them afterward. */
+        void SetTriple(std::string& triple);
 
         inline llvm::StringRef GetCPU() { return cpu; }
         inline void SetCPU(std::string& cpu) { this->cpu = cpu; }
@@ -27,10 +37,20 @@ namespace VCL {
         inline llvm::StringRef GetFeatures() { return features; }
         inline void SetFeatures(std::string& features) { this->features = features; }
 
+        /** Relocation model of the generated code, left to the target default when unset. */
+        inline std::optional<llvm::Reloc::Model> GetRelocModel() const { return relocModel; }
+        inline void SetRelocModel(std::optional<llvm::Reloc::Model> relocModel) { this->relocModel = relocModel; }
+
+        /** Vector library of every module compiled with these options, None by default. */
+        inline VectorLibrary GetVectorLibrary() const { return vectorLibrary; }
+        inline void SetVectorLibrary(VectorLibrary vectorLibrary) { this->vectorLibrary = vectorLibrary; }
+
     private:
         std::string triple;
         std::string cpu;
         std::string features;
+        std::optional<llvm::Reloc::Model> relocModel;
+        VectorLibrary vectorLibrary = VectorLibrary::None;
     };
 
 }
\ No newline at end of file
@@ -62,7 +62,7 @@ namespace VCL {
 
         Target& GetTarget();
         bool HasTarget();
-        void CreateTarget();
+        bool CreateTarget();
         void CopyTarget(CompilerContext& other);
 
         TypeCache& GetTypeCache();
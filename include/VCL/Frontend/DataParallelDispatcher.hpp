@@ -0,0 +1,110 @@
+#pragma once
+
+#include <VCL/CodeGen/InstanceContext.hpp>
+#include <VCL/Frontend/KernelHandle.hpp>
+
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/ADT/StringRef.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+namespace VCL {
+
+    /**
+     * Run an entry point compiled with an instance context over large Span in/out bindings,
+     * split into chunks executed on a work-stealing pool of worker threads.
+     * Each chunk run with its own copy of the context where every bound span is narrowed to the chunk range,
+     * so outputs written through spans land at the same place whatever the scheduling.
+     * Scalar outputs are taken from the last chunk, as if the chunks had run in order.
+     */
+    class DataParallelDispatcher {
+    public:
+        /** A Span field of the instance context to split, elementSize is the size of one element in bytes. */
+        struct SpanBinding {
+            std::string name;
+            uint64_t elementSize;
+        };
+
+        struct WorkerStats {
+            uint64_t chunkCount = 0;
+            uint64_t elementCount = 0;
+            uint64_t stolenCount = 0;
+            double seconds = 0.0;
+
+            /** Elements processed per second of work. */
+            inline double GetThroughput() const { return seconds > 0.0 ? elementCount / seconds : 0.0; }
+        };
+
+    public:
+        DataParallelDispatcher() = delete;
+        /**
+         * Create a pool of threadCount workers, 0 use one worker per hardware thread.
+         * Chunks are a multiple of vectorWidthInElement (see Target::GetVectorWidthInElement).
+         */
+        DataParallelDispatcher(uint32_t threadCount, uint32_t vectorWidthInElement);
+        DataParallelDispatcher(const DataParallelDispatcher& other) = delete;
+        DataParallelDispatcher(DataParallelDispatcher&& other) = delete;
+        ~DataParallelDispatcher();
+
+        DataParallelDispatcher& operator=(const DataParallelDispatcher& other) = delete;
+        DataParallelDispatcher& operator=(DataParallelDispatcher&& other) = delete;
+
+        /**
+         * Run kernel over the spans bound in context, which is left untouched except for its scalar outputs.
+         * Every bound span must have the same element count. Block until every chunk completed.
+         */
+        bool Dispatch(const KernelHandle<void(void*)>& kernel, const InstanceContextLayout& layout, void* context, llvm::ArrayRef<SpanBinding> spans);
+
+        /** Bytes of span data touched by one chunk, defaults to a typical per-core L2 size. */
+        inline uint64_t GetChunkSizeInByte() const { return chunkSizeInByte; }
+        inline void SetChunkSizeInByte(uint64_t chunkSizeInByte) { this->chunkSizeInByte = chunkSizeInByte; }
+
+        inline uint32_t GetVectorWidthInElement() const { return vectorWidthInElement; }
+        inline uint32_t GetThreadCount() const { return threadCount; }
+
+        /** Statistics accumulated by each worker since creation or the last ResetStats. */
+        std::vector<WorkerStats> GetStats();
+        void ResetStats();
+
+    private:
+        struct Job;
+
+        struct Worker {
+            std::deque<uint64_t> chunks{};
+            std::mutex mutex{};
+            std::vector<uint8_t> context{};
+            WorkerStats stats{};
+        };
+
+        void Run(uint32_t index);
+        void RunJob(uint32_t index, Job& job);
+        bool PopChunk(uint32_t index, uint64_t& chunk, bool& stolen);
+
+    private:
+        uint32_t threadCount;
+        uint32_t vectorWidthInElement;
+        uint64_t chunkSizeInByte = 256 * 1024;
+        std::vector<std::unique_ptr<Worker>> workers{};
+        std::vector<std::thread> threads{};
+
+        std::mutex mutex{};
+        std::mutex dispatchMutex{};
+        std::condition_variable condition{};
+        std::condition_variable doneCondition{};
+        Job* job = nullptr;
+        uint64_t generation = 0;
+        uint32_t activeCount = 0;
+        bool running = true;
+    };
+
+}
\ No newline at end of file
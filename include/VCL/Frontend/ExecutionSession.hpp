@@ -1,5 +1,10 @@
 #pragma once
         
+#include <VCL/Frontend/ObjectCache.hpp>
+#include <VCL/Frontend/TaskDispatcher.hpp>
+#include <VCL/Frontend/KernelHandle.hpp>
+#include <VCL/Frontend/ParameterBlock.hpp>
+
 #include <llvm/ExecutionEngine/JITSymbol.h>
 #include <llvm/ExecutionEngine/JITEventListener.h>
 #include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
@@ -8,6 +13,9 @@
 #include <llvm/ExecutionEngine/Orc/ExecutionUtils.h>
 #include <llvm/ExecutionEngine/Orc/ExecutorProcessControl.h>
 #include <llvm/ExecutionEngine/Orc/IRCompileLayer.h>
+#include <llvm/ExecutionEngine/Orc/CompileOnDemandLayer.h>
+#include <llvm/ExecutionEngine/Orc/IndirectionUtils.h>
+#include <llvm/ExecutionEngine/Orc/LazyReexports.h>
 #include <llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h>
 #include <llvm/ExecutionEngine/Orc/RTDyldObjectLinkingLayer.h>
 #include <llvm/ExecutionEngine/Orc/ObjectTransformLayer.h>
@@ -17,15 +25,60 @@
 #include <llvm/ExecutionEngine/Orc/AbsoluteSymbols.h>
 #include <llvm/ExecutionEngine/SectionMemoryManager.h>
 #include <llvm/Support/Debug.h>
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/SmallVector.h>
 
 #include <memory>
+#include <atomic>
+#include <vector>
+#include <string>
 
 
 namespace VCL {
 
+    /**
+     * Handle to a module submitted to an ExecutionSession.
+     * Each module live in its own JITDylib and is owned by a ResourceTracker,
+     * it can be removed or replaced without affecting the other modules.
+     */
+    class ModuleHandle {
+    public:
+        ModuleHandle() = default;
+        ModuleHandle(llvm::orc::JITDylib* dylib, llvm::orc::ResourceTrackerSP tracker, std::shared_ptr<const std::vector<std::string>> symbols) 
+            : dylib{ dylib }, tracker{ tracker }, symbols{ symbols } {}
+        ModuleHandle(const ModuleHandle& other) = default;
+        ModuleHandle(ModuleHandle&& other) = default;
+        ~ModuleHandle() = default;
+
+        ModuleHandle& operator=(const ModuleHandle& other) = default;
+        ModuleHandle& operator=(ModuleHandle&& other) = default;
+
+        inline explicit operator bool() const { return tracker != nullptr; }
+
+        inline llvm::orc::JITDylib* GetJITDylib() const { return dylib; }
+        inline llvm::orc::ResourceTrackerSP GetResourceTracker() const { return tracker; }
+        /** Name of the module in/out variables. */
+        inline const std::vector<std::string>& GetSymbols() const { return *symbols; }
+
+    private:
+        llvm::orc::JITDylib* dylib = nullptr;
+        llvm::orc::ResourceTrackerSP tracker = nullptr;
+        std::shared_ptr<const std::vector<std::string>> symbols = std::make_shared<const std::vector<std::string>>();
+    };
+
+    /** Address of an entry point, updated atomically when the module defining it is replaced. */
+    using EntryPointSlot = std::atomic<void*>;
+
     class ExecutionSession {
     public:
+        /** Create a session whose materializations run on the calling thread. */
         ExecutionSession();
+        /**
+         * Create a session whose materializations run on threadCount worker threads,
+         * 0 use one worker per hardware thread.
+         */
+        explicit ExecutionSession(uint32_t threadCount);
         ExecutionSession(const ExecutionSession& other) = delete;
         ExecutionSession(ExecutionSession&& other);
         ~ExecutionSession();
@@ -35,16 +88,88 @@ namespace VCL {
 
         inline llvm::Error ConsumeLastError() { return std::move(lastError); }
 
-        bool SubmitModule(llvm::orc::ThreadSafeModule&& module);
+        ModuleHandle SubmitModule(llvm::orc::ThreadSafeModule&& module);
+        /**
+         * Submit a batch of modules and compile them right away, in parallel when the session has worker threads.
+         * Modules sharing a ThreadSafeContext are serialized by its lock, use one context per module to compile them concurrently.
+         * A module that failed to compile get an empty handle.
+         */
+        std::vector<ModuleHandle> SubmitModules(std::vector<llvm::orc::ThreadSafeModule>&& modules);
+        /** Remove a module and free its code, the caller must ensure none of its code is still running. */
+        bool RemoveModule(ModuleHandle& handle);
+        /**
+         * Submit module in place of handle, then atomically swap the entry point slots taken on handle,
+         * slots of the other modules are left untouched. The new module must define each of these entry points.
+         * The old module is kept alive, remove it once no thread can still be running its code
+         * (e.g. at the next block boundary).
+         */
+        ModuleHandle ReplaceModule(ModuleHandle& handle, llvm::orc::ThreadSafeModule&& module);
 
+        /** Lookup a symbol in every module, the first module defining it wins. */
         void* Lookup(llvm::StringRef name);
+        /** Lookup a symbol defined by module or bound to the session. */
+        void* Lookup(const ModuleHandle& module, llvm::StringRef name);
+        /**
+         * Lookup an entry point of module through a slot that always hold the address of the latest definition,
+         * following the module through ReplaceModule. The slot is freed when the module is removed.
+         */
+        EntryPointSlot* LookupEntryPoint(const ModuleHandle& module, llvm::StringRef name = "Main");
+
+        /**
+         * Resolve an entry point of module and all its in/out symbols once, inputs must already be defined.
+         * Signature must match the entry point, e.g. void() or void(void*) with an instance context.
+         * The kernel keep calling this module after a ReplaceModule, get it again from the new handle.
+         */
+        template<typename Signature>
+        inline KernelHandle<Signature> GetKernel(const ModuleHandle& module, llvm::StringRef entryPoint = "Main") {
+            void* address = nullptr;
+            llvm::StringMap<void*> symbols{};
+            if (!ResolveKernel(module, entryPoint, address, symbols))
+                return KernelHandle<Signature>{};
+            return KernelHandle<Signature>{ address, std::move(symbols), module.GetResourceTracker() };
+        }
         bool DefineSymbolPtr(llvm::StringRef name, void* ptr);
+        /** Bind an in variable to block, the kernel see each new value once the real-time thread call ParameterBlock::Latch. */
+        inline bool DefineParameterBlock(llvm::StringRef name, ParameterBlock& block) { return DefineSymbolPtr(name, block.GetBoundPtr()); }
 
         void EnableGDBListener();
         void DisableGDBListener();
+        /** Notify listener of every object linked from now on, compiled or loaded from the object cache. */
+        void RegisterJITEventListener(llvm::JITEventListener& listener);
+        void UnregisterJITEventListener(llvm::JITEventListener& listener);
 
         void DefineDefaultMemIntrinsic();
         void DefineDefaultMathIntrinsic();
+        /**
+         * Define the vector variants of the math functions found in glibc libmvec,
+         * needed by modules compiled with VectorLibrary::Libmvec. Fails when the library can't be loaded.
+         */
+        void DefineLibmvecIntrinsic();
+
+        /**
+         * Enable the persistent object cache stored in directory, bounded to maxSize bytes.
+         * Module whose object is already cached are linked directly, skipping code generation.
+         * Must be called before any module is submitted.
+         */
+        bool EnableObjectCache(llvm::StringRef directory, uint64_t maxSize);
+        inline bool HasObjectCache() const { return objectCache != nullptr; }
+        inline ObjectCache* GetObjectCache() { return objectCache.get(); }
+
+        /**
+         * Enable lazy compilation, submitted modules are then only compiled function by function
+         * when first looked up or called. Must be called before any module is submitted.
+         */
+        bool EnableLazyCompilation();
+        inline bool IsLazyCompilationEnabled() const { return codLayer != nullptr; }
+
+        /** Number of worker threads used for compilation, 0 when materializing on the calling thread. */
+        inline uint32_t GetThreadCount() const { return threadCount; }
+
+    private:
+        ExecutionSession(std::unique_ptr<ThreadPoolTaskDispatcher> dispatcher);
+
+        llvm::Error AddModule(llvm::orc::ResourceTrackerSP tracker, llvm::orc::ThreadSafeModule&& module, std::vector<std::string>& symbols);
+        bool ResolveKernel(const ModuleHandle& module, llvm::StringRef entryPoint, void*& address, llvm::StringMap<void*>& symbols);
 
     private:
         std::unique_ptr<llvm::orc::ExecutionSession> session;
@@ -52,7 +177,14 @@ namespace VCL {
         std::unique_ptr<llvm::orc::MangleAndInterner> mangle;
         std::unique_ptr<llvm::orc::RTDyldObjectLinkingLayer> linkingLayer;
         std::unique_ptr<llvm::orc::IRCompileLayer> compileLayer;
+        std::unique_ptr<ObjectCache> objectCache;
+        std::unique_ptr<llvm::orc::LazyCallThroughManager> lazyCallThroughManager;
+        std::unique_ptr<llvm::orc::CompileOnDemandLayer> codLayer;
         llvm::orc::JITDylib* main;
+        llvm::SmallVector<llvm::orc::JITDylib*> searchOrder;
+        llvm::DenseMap<llvm::orc::JITDylib*, llvm::StringMap<std::unique_ptr<EntryPointSlot>>> entryPoints;
+        uint32_t moduleCount;
+        uint32_t threadCount;
         llvm::JITEventListener* gdbListener;
         llvm::Error lastError;
     };
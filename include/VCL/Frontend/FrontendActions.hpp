@@ -2,6 +2,12 @@
 
 #include <VCL/Frontend/FrontendAction.hpp>
 #include <VCL/CodeGen/CodeGenAction.hpp>
+#include <VCL/CodeGen/MathAccuracy.hpp>
+#include <VCL/Frontend/ObjectCache.hpp>
+
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/SmallVectorMemoryBuffer.h>
+#include <llvm/ADT/SmallVector.h>
 
 
 namespace VCL {
@@ -18,8 +24,62 @@ namespace VCL {
         inline bool GetRunOptimization() const { return runOptimization; }
         inline void SetRunOptimization(bool runOptimization) { this->runOptimization = runOptimization; }
 
+        /**
+         * When an object is already cached for this module, skip code generation and optimization.
+         * The emitted module is then empty and only carry its cache key as identifier,
+         * ExecutionSession::SubmitModule link the cached object instead, and fails if it was evicted meanwhile.
+         */
+        inline ObjectCache* GetObjectCache() const { return objectCache; }
+        inline void SetObjectCache(ObjectCache* objectCache) { this->objectCache = objectCache; }
+
+        inline bool IsCached() const { return cached; }
+
+        /**
+         * Lower in/out variables into an instance context struct passed by pointer to the entry points,
+         * so one compiled module can run any number of instances concurrently. See InstanceContextLayout.
+         * Imported modules must not declare in/out variables, they are compiled without the context.
+         */
+        inline bool GetUseInstanceContext() const { return useInstanceContext; }
+        inline void SetUseInstanceContext(bool useInstanceContext) { this->useInstanceContext = useInstanceContext; }
+
+        /**
+         * Compile every entry point for each of Multiversioner::GetVersions in one module,
+         * the version matching the running CPU is selected on the first call. x86-64 only.
+         */
+        inline bool GetMultiversioning() const { return multiversioning; }
+        inline void SetMultiversioning(bool multiversioning) { this->multiversioning = multiversioning; }
+
+        /** Accuracy of the math intrinsics called on Vec<float32>, High by default, see MathAccuracy. */
+        inline MathAccuracy GetMathAccuracy() const { return mathAccuracy; }
+        inline void SetMathAccuracy(MathAccuracy mathAccuracy) { this->mathAccuracy = mathAccuracy; }
+
+    private:
+        bool EmitMultiversion(llvm::Module& module);
+
     private:
         bool runOptimization = true;
+        bool useInstanceContext = false;
+        bool multiversioning = false;
+        MathAccuracy mathAccuracy = MathAccuracy::High;
+        ObjectCache* objectCache = nullptr;
+        bool cached = false;
+    };
+
+    /**
+     * Emit the module then lower it to a relocatable object for the CompilerContext Target,
+     * used for ahead of time compilation.
+     */
+    class EmitObjectAction : public EmitLLVMAction {
+    public:
+        bool Execute() override;
+
+        inline llvm::StringRef GetObject() const { return { object.data(), object.size() }; }
+        inline std::unique_ptr<llvm::MemoryBuffer> MoveObject() {
+            return std::make_unique<llvm::SmallVectorMemoryBuffer>(std::move(object), "object", false);
+        }
+
+    private:
+        llvm::SmallVector<char, 0> object{};
     };
 
 }
\ No newline at end of file
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <llvm/ExecutionEngine/Orc/Core.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/StringRef.h>
+
+#include <cassert>
+#include <utility>
+
+
+namespace VCL {
+
+    template<typename Signature>
+    class KernelHandle;
+
+    /**
+     * Typed handle to an entry point, created by ExecutionSession::GetKernel.
+     * The entry point and every in/out symbol of its module are resolved once at creation,
+     * invoking the kernel or reading its symbols never touch the symbol table again.
+     * The handle is tied to the ModuleHandle it was taken from, it doesn't follow ExecutionSession::ReplaceModule
+     * (use an EntryPointSlot for that) and must be fetched again from the new module, the old one become invalid once removed.
+     */
+    template<typename R, typename... Args>
+    class KernelHandle<R(Args...)> {
+    public:
+        using FunctionType = R(*)(Args...);
+
+    public:
+        KernelHandle() = default;
+        KernelHandle(void* entryPoint, llvm::StringMap<void*>&& symbols, llvm::orc::ResourceTrackerSP tracker) 
+            : entryPoint{ (FunctionType)entryPoint }, symbols{ std::move(symbols) }, tracker{ std::move(tracker) } {}
+        KernelHandle(const KernelHandle& other) = default;
+        KernelHandle(KernelHandle&& other) = default;
+        ~KernelHandle() = default;
+
+        KernelHandle& operator=(const KernelHandle& other) = default;
+        KernelHandle& operator=(KernelHandle&& other) = default;
+
+        inline explicit operator bool() const { return entryPoint != nullptr; }
+        /** False once the module the handle was taken from has been removed, its code and symbols are then freed. */
+        inline bool IsValid() const { return entryPoint != nullptr && !tracker->isDefunct(); }
+
+        inline R operator()(Args... args) const { return Invoke(std::forward<Args>(args)...); }
+        inline R Invoke(Args... args) const {
+            assert(IsValid() && "kernel of a removed module");
+            return entryPoint(std::forward<Args>(args)...);
+        }
+
+        inline FunctionType GetEntryPoint() const { return entryPoint; }
+
+        /** Address of one of the module in/out symbols, nullptr if the module doesn't have it. */
+        template<typename T>
+        inline T* GetSymbol(llvm::StringRef name) const {
+            auto it = symbols.find(name);
+            return it == symbols.end() ? nullptr : (T*)it->getValue();
+        }
+
+        inline const llvm::StringMap<void*>& GetSymbols() const { return symbols; }
+
+    private:
+        FunctionType entryPoint = nullptr;
+        llvm::StringMap<void*> symbols{};
+        llvm::orc::ResourceTrackerSP tracker = nullptr;
+    };
+
+}
\ No newline at end of file
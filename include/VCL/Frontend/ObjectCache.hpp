@@ -0,0 +1,87 @@
+#pragma once
+
+#include <llvm/ExecutionEngine/ObjectCache.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/StringRef.h>
+
+#include <cstdint>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+
+
+namespace VCL {
+    class CompilerInstance;
+
+    /**
+     * Persistent on-disk cache of compiled objects.
+     * Objects are stored as '<key>.o' inside the cache directory, where the key is derived
+     * from everything that can change the generated code (source content, imported modules,
+     * defined values, target and compiler version). Cached objects are keyed through the llvm::Module identifier,
+     * which EmitLLVMAction set using MakeKey.
+     * The directory is bounded to a maximum size, least recently used objects are evicted first.
+     */
+    class ObjectCache : public llvm::ObjectCache {
+    public:
+        ObjectCache() = delete;
+        ObjectCache(llvm::StringRef directory, uint64_t maxSize);
+        ObjectCache(const ObjectCache& other) = delete;
+        ObjectCache(ObjectCache&& other) = delete;
+        ~ObjectCache() override = default;
+
+        ObjectCache& operator=(const ObjectCache& other) = delete;
+        ObjectCache& operator=(ObjectCache&& other) = delete;
+
+        void notifyObjectCompiled(const llvm::Module* module, llvm::MemoryBufferRef buffer) override;
+        std::unique_ptr<llvm::MemoryBuffer> getObject(const llvm::Module* module) override;
+
+        /** Return true if an object is stored for this key, does not count as a hit or a miss. */
+        bool Contains(llvm::StringRef key);
+        /** Load the object stored for this key, return nullptr on miss. */
+        std::unique_ptr<llvm::MemoryBuffer> Load(llvm::StringRef key);
+        /** Store an object for this key, then evict objects until the directory fit in its maximum size. */
+        bool Store(llvm::StringRef key, llvm::MemoryBufferRef buffer);
+        /** Evict least recently used objects until the directory fit in its maximum size. */
+        void Prune();
+        /** Remove every cached object. */
+        void Clear();
+
+        inline llvm::StringRef GetDirectory() const { return directory; }
+        inline uint64_t GetMaxSize() const { return maxSize; }
+
+        inline uint64_t GetHitCount() const { return hitCount; }
+        inline uint64_t GetMissCount() const { return missCount; }
+        inline uint64_t GetEvictionCount() const { return evictionCount; }
+
+        /**
+         * Hash everything that affect the code generated for this instance, including its imported modules,
+         * the compiler version and the LLVM version.
+         */
+        static uint64_t HashCompilerInstance(CompilerInstance& instance);
+        /** Make a cache key, usable as a llvm::Module identifier. */
+        static std::string MakeKey(uint64_t hash);
+        static bool IsKey(llvm::StringRef key);
+
+    public:
+        /** Bump whenever a change to the compiler alter the generated code, objects of older versions are then never reused. */
+        static constexpr uint64_t CompilerVersion = 1;
+        /** Named metadata marking an empty module emitted for a cached object, it can't be compiled in its place. */
+        static constexpr llvm::StringLiteral CachedMetadataName = "vcl.cached";
+
+    private:
+        void GetObjectPath(llvm::StringRef key, llvm::SmallVectorImpl<char>& path);
+        void PruneUnlocked(llvm::StringRef keep);
+
+    private:
+        std::string directory;
+        uint64_t maxSize;
+        std::mutex mutex{};
+        std::atomic<uint64_t> hitCount = 0;
+        std::atomic<uint64_t> missCount = 0;
+        std::atomic<uint64_t> evictionCount = 0;
+    };
+
+}
\ No newline at end of file
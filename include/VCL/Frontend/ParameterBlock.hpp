@@ -0,0 +1,104 @@
+#pragma once
+
+#include <VCL/CodeGen/Reflection.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+
+
+namespace VCL {
+
+    /**
+     * Tear free storage for an in variable updated by control threads while the real-time thread run its module.
+     * The kernel reads the bound storage (see ExecutionSession::DefineParameterBlock), which only the real-time thread
+     * writes when it calls Latch between two blocks. Writers publish whole values into a triple buffer, Latch takes the
+     * latest one with a single atomic exchange, so the real-time side never blocks nor sees half of an update.
+     * Writers are serialized between themselves.
+     */
+    class ParameterBlock {
+    public:
+        ParameterBlock() = delete;
+        /** Parameter of size bytes, every copy aligned on alignment. Starts zero initialized. */
+        ParameterBlock(size_t size, size_t alignment);
+        ParameterBlock(const ModuleReflection::TypeInfo& type) : ParameterBlock{ type.size, type.alignment } {}
+        ParameterBlock(const ParameterBlock& other) = delete;
+        ParameterBlock(ParameterBlock&& other) = delete;
+        ~ParameterBlock() = default;
+
+        ParameterBlock& operator=(const ParameterBlock& other) = delete;
+        ParameterBlock& operator=(ParameterBlock&& other) = delete;
+
+        /** Storage to bind to the in variable, read by the kernel. */
+        inline void* GetBoundPtr() { return GetSlot(BoundSlot); }
+        inline size_t GetSize() const { return size; }
+
+        /**
+         * Control thread, modify the last written value in place with update(void*) then publish it,
+         * so a single field can change without rewriting the others.
+         */
+        template<typename F>
+        void Update(F&& update) {
+            std::lock_guard<std::mutex> lock{ writeMutex };
+            update(GetSlot(StagingSlot));
+            Publish();
+        }
+
+        /** Control thread, publish a whole value of GetSize bytes. */
+        void Write(const void* value) {
+            Update([this, value](void* staging) { std::memcpy(staging, value, size); });
+        }
+
+        /** Real-time thread, at a block boundary. Copy the latest published value to the bound storage if there is a new one. */
+        bool Latch();
+
+    private:
+        void Publish();
+
+        inline uint8_t* GetSlot(uint32_t slot) { return storage + slot * stride; }
+
+    private:
+        static constexpr uint32_t BoundSlot = 0;
+        static constexpr uint32_t StagingSlot = 1;
+        /** Slots of the triple buffer come after. */
+        static constexpr uint32_t BufferSlot = 2;
+        static constexpr uint32_t SlotCount = 5;
+        /** Set in middle when it hold a value not latched yet. */
+        static constexpr uint32_t DirtyBit = 0x4;
+        static constexpr uint32_t IndexMask = 0x3;
+
+        size_t size;
+        size_t stride;
+        std::unique_ptr<uint8_t[]> buffer;
+        uint8_t* storage;
+
+        std::mutex writeMutex{};
+        uint32_t back = 0;
+        std::atomic<uint32_t> middle{ 1 };
+        uint32_t front = 2;
+    };
+
+    /** Typed ParameterBlock for a host type matching the in variable, like the ones written by cvcl --emit-header. */
+    template<typename T>
+    class Parameter : public ParameterBlock {
+    public:
+        Parameter() : ParameterBlock{ sizeof(T), alignof(T) } {}
+        Parameter(const T& value) : ParameterBlock{ sizeof(T), alignof(T) } {
+            Write(value);
+            Latch();
+        }
+
+        inline T* GetBoundPtr() { return (T*)ParameterBlock::GetBoundPtr(); }
+
+        template<typename F>
+        void Update(F&& update) {
+            ParameterBlock::Update([&update](void* staging) { update(*(T*)staging); });
+        }
+
+        void Write(const T& value) { ParameterBlock::Write(&value); }
+    };
+
+}
\ No newline at end of file
@@ -1,10 +1,17 @@
 #pragma once
 
 #include <VCL/Core/Target.hpp>
+#include <VCL/CodeGen/Reflection.hpp>
 
 #include <llvm/Support/Allocator.h>
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/ADT/StringRef.h>
 
 #include <algorithm>
+#include <array>
+#include <optional>
 #include <cstring>
 #include <cstdint>
 #include <cmath>
@@ -66,36 +73,198 @@ namespace VCL {
         uint8_t* ptr;
     };
 
+    /** A value of any reflected type, usually a whole record like an AudioBuffer, see StorageManager::AllocateRecord. */
+    class RecordView {
+    public:
+        RecordView(uint8_t* ptr, const ModuleReflection::TypeInfo* type) : ptr{ ptr }, type{ type } {}
+        RecordView(const RecordView& other) = default;
+        RecordView(RecordView&& other) = default;
+        ~RecordView() = default;
+
+        inline RecordView& operator=(const RecordView& other) = default;
+        inline RecordView& operator=(RecordView&& other) = default;
+
+        /** Pointer to the member reached by path (see ModuleReflection::TypeInfo::GetOffset), nullptr if there is none. */
+        template<typename T>
+        inline T* GetPtr(llvm::StringRef path) {
+            std::optional<uint64_t> offset = type ? type->GetOffset(path) : std::nullopt;
+            return offset.has_value() ? (T*)(ptr + *offset) : nullptr;
+        }
+
+        inline uint8_t* GetPtr() { return ptr; }
+        inline const ModuleReflection::TypeInfo* GetType() const { return type; }
+        inline bool IsValid() const { return ptr != nullptr; }
+
+    private:
+        uint8_t* ptr;
+        const ModuleReflection::TypeInfo* type;
+    };
+
+    /** How StorageManager::AllocateBuffer map and place large buffers, usually bound to Span in/out variables. */
+    struct BufferPolicy {
+        enum class HugePages {
+            None,
+            /** Advise the kernel to back the buffer with transparent huge pages. */
+            Transparent,
+            /** Map explicit huge pages from the reserved pool, falling back to Transparent if none are left. */
+            Explicit
+        };
+
+        HugePages hugePages = HugePages::Transparent;
+        /**
+         * Split the buffer in one region per NUMA node, each first touched from a thread running on its node
+         * so its pages are placed there. Otherwise pages are placed by whoever touches them first.
+         */
+        bool numaAware = false;
+    };
+
+    /** A large buffer of elements split in regions, each one local to a NUMA node. */
+    class BufferView {
+    public:
+        struct Region {
+            uint64_t firstElement;
+            uint64_t elementCount;
+            uint32_t node;
+        };
+
+    public:
+        BufferView() = default;
+        BufferView(uint8_t* ptr, uint64_t elementCount, uint64_t elementSize, size_t mappedSize, llvm::SmallVector<Region> regions)
+            : ptr{ ptr }, elementCount{ elementCount }, elementSize{ elementSize }, mappedSize{ mappedSize }, regions{ std::move(regions) } {}
+        BufferView(const BufferView& other) = default;
+        BufferView(BufferView&& other) = default;
+        ~BufferView() = default;
+
+        inline BufferView& operator=(const BufferView& other) = default;
+        inline BufferView& operator=(BufferView&& other) = default;
+
+        template<typename T>
+        inline T* GetPtr() { return (T*)ptr; }
+        template<typename T>
+        inline T* GetPtr(const Region& region) { return (T*)(ptr + region.firstElement * elementSize); }
+        inline uint8_t* GetPtr() { return ptr; }
+
+        inline uint64_t GetElementCount() const { return elementCount; }
+        inline uint64_t GetElementSize() const { return elementSize; }
+        inline size_t GetMappedSize() const { return mappedSize; }
+        /** Regions start on a page boundary and cover every element, in order. */
+        inline llvm::ArrayRef<Region> GetRegions() const { return regions; }
+        inline bool IsValid() const { return ptr != nullptr; }
+
+    private:
+        uint8_t* ptr = nullptr;
+        uint64_t elementCount = 0;
+        uint64_t elementSize = 0;
+        size_t mappedSize = 0;
+        llvm::SmallVector<Region> regions{};
+    };
+
+    /**
+     * Allocate storage for in/out variables, aligned on the Target vector width.
+     * Small blocks are pooled in power of two size classes, starting at one vector, and reused once freed
+     * so creating and destroying instances keep the memory usage stable. Larger blocks are given back on Free.
+     * Not thread safe.
+     */
     class StorageManager {
+    public:
+        struct Stats {
+            /** Memory held by the manager, in use or pooled. */
+            uint64_t reservedBytes = 0;
+            uint64_t usedBytes = 0;
+            uint64_t pooledBytes = 0;
+            uint64_t allocationCount = 0;
+            uint64_t freeCount = 0;
+            /** Allocations served from a previously freed block. */
+            uint64_t reuseCount = 0;
+        };
+
     public:
         StorageManager(Target& target) : target{ target }, allocator{} {}
         StorageManager(const StorageManager& other) = delete;
         StorageManager(StorageManager&& other) = delete;
-        ~StorageManager() = default;
+        ~StorageManager();
 
         inline StorageManager& operator=(const StorageManager& other) = delete;
         inline StorageManager& operator=(StorageManager&& other) = delete;
 
+        /** Allocate size bytes aligned on max(alignment, Target::GetVectorWidthInByte). */
+        void* Allocate(size_t size, size_t alignment = 0);
+        /** Give back a block of size bytes, which must be the size it was allocated with. */
+        void Free(void* ptr, size_t size);
+        /** Free every allocation at once, invalidating all views. The first slab is kept for the next allocations. */
+        void Reset();
+
+        inline Stats GetStats() const {
+            Stats result = stats;
+            result.reservedBytes = allocator.getTotalMemory() + largeBytes + bufferBytes;
+            return result;
+        }
+
         BoolVectorView AllocateBoolVector() {
-            /** It's one bit (not byte) per boolean */
-            size_t size = std::max((size_t)(target.GetVectorWidthInElement() / 8), (size_t)1);
-            uint8_t* ptr = (uint8_t*)allocator.Allocate(size, target.GetVectorWidthInByte());
-            return BoolVectorView{ ptr };
+            return BoolVectorView{ (uint8_t*)Allocate(GetBoolVectorSize()) };
         }
 
         template<typename T>
         NumericVectorView<T> AllocateNumericVector() {
-            T* ptr = (T*)allocator.Allocate(target.GetVectorWidthInElement() * sizeof(T), target.GetVectorWidthInByte());
-            return NumericVectorView<T>{ ptr };
+            return NumericVectorView<T>{ (T*)Allocate(target.GetVectorWidthInElement() * sizeof(T)) };
         }
 
         Float32VectorView AllocateFloat32Vector() { return AllocateNumericVector<float_t>(); }
         Float64VectorView AllocateFloat64Vector() { return AllocateNumericVector<double_t>(); }
         Int32VectorView AllocateInt32Vector() { return AllocateNumericVector<int32_t>(); }
 
+        /** Allocate a zero initialized value of type, with the layout of the module it was reflected from. */
+        RecordView AllocateRecord(const ModuleReflection::TypeInfo& type) {
+            uint8_t* ptr = (uint8_t*)Allocate(type.size, type.alignment);
+            std::memset(ptr, 0, type.size);
+            return RecordView{ ptr, &type };
+        }
+
+        void Free(BoolVectorView view) { Free(view.GetPtr(), GetBoolVectorSize()); }
+        template<typename T>
+        void Free(NumericVectorView<T> view) { Free(view.GetPtr(), target.GetVectorWidthInElement() * sizeof(T)); }
+        void Free(RecordView view) { Free(view.GetPtr(), view.GetType()->size); }
+
+        /**
+         * Map a buffer of elementCount elements of elementSize bytes directly from the system, page aligned,
+         * placed following policy. Meant for multi-gigabyte Span bindings, never pooled.
+         */
+        BufferView AllocateBuffer(uint64_t elementCount, uint64_t elementSize, const BufferPolicy& policy = {});
+        void Free(BufferView& view);
+
+        /** NUMA nodes of the system, 1 if it isn't NUMA or the topology can't be read. */
+        static uint32_t GetNodeCount();
+        /** Restrict the calling thread to the CPUs of node, so what it touches first is placed there. */
+        static bool PinCurrentThreadToNode(uint32_t node);
+
+    private:
+        struct FreeBlock {
+            FreeBlock* next;
+        };
+
+        struct LargeAllocation {
+            size_t size;
+            size_t alignment;
+        };
+
+        /** It's one bit (not byte) per boolean */
+        inline size_t GetBoolVectorSize() const { return std::max((size_t)(target.GetVectorWidthInElement() / 8), (size_t)1); }
+        inline size_t GetSizeClassSize(uint32_t sizeClass) const { return (size_t)target.GetVectorWidthInByte() << sizeClass; }
+        uint32_t GetSizeClass(size_t size, size_t alignment) const;
+
+    public:
+        /** Blocks above the largest class, 2^(SizeClassCount - 1) vectors, are not pooled. */
+        static constexpr uint32_t SizeClassCount = 16;
+
     private:
         Target& target;
         llvm::BumpPtrAllocator allocator;
+        std::array<FreeBlock*, SizeClassCount> freeLists{};
+        llvm::DenseMap<void*, LargeAllocation> largeAllocations{};
+        uint64_t largeBytes = 0;
+        llvm::DenseMap<void*, size_t> buffers{};
+        uint64_t bufferBytes = 0;
+        Stats stats{};
     };
 
 }
\ No newline at end of file
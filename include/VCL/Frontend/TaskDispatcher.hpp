@@ -0,0 +1,49 @@
+#pragma once
+
+#include <llvm/ExecutionEngine/Orc/TaskDispatch.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace VCL {
+
+    /**
+     * ORC task dispatcher running materialization on a fixed number of worker threads.
+     * Installed on the ExecutionSession so independent modules are compiled in parallel.
+     */
+    class ThreadPoolTaskDispatcher : public llvm::orc::TaskDispatcher {
+    public:
+        ThreadPoolTaskDispatcher() = delete;
+        /** A threadCount of 0 use one worker per hardware thread. */
+        ThreadPoolTaskDispatcher(uint32_t threadCount);
+        ThreadPoolTaskDispatcher(const ThreadPoolTaskDispatcher& other) = delete;
+        ThreadPoolTaskDispatcher(ThreadPoolTaskDispatcher&& other) = delete;
+        ~ThreadPoolTaskDispatcher() override;
+
+        ThreadPoolTaskDispatcher& operator=(const ThreadPoolTaskDispatcher& other) = delete;
+        ThreadPoolTaskDispatcher& operator=(ThreadPoolTaskDispatcher&& other) = delete;
+
+        void dispatch(std::unique_ptr<llvm::orc::Task> task) override;
+        void shutdown() override;
+
+        inline uint32_t GetThreadCount() const { return threadCount; }
+
+    private:
+        void Run();
+
+    private:
+        uint32_t threadCount;
+        std::vector<std::thread> workers{};
+        std::deque<std::unique_ptr<llvm::orc::Task>> tasks{};
+        std::mutex mutex{};
+        std::condition_variable condition{};
+        bool running = true;
+    };
+
+}
\ No newline at end of file
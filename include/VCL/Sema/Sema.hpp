@@ -85,6 +85,7 @@ namespace VCL {
         
         TemplateSpecializationType* CreateVectorTemplateSpecializationType(Type* ofType);
         TemplateSpecializationType* CreateLanesTemplateSpecializationType(Type* ofType);
+        TemplateSpecializationType* CreateSpanTemplateSpecializationType(Type* ofType);
         void AddIntrinsicTypes();
         void AddIntrinsicMathFunction(FunctionDecl::IntrinsicID intrinsicID, llvm::StringRef name, uint32_t argCount);
         void AddIntrinsicFunction(FunctionDecl::IntrinsicID intrinsicID, llvm::StringRef name);
@@ -159,6 +160,8 @@ namespace VCL {
 
         std::pair<Expr*, Expr*> ActOnImplicitBinaryArithmeticCast(Expr* lhs, Expr* rhs);
         Expr* ActOnCast(Expr* expr, QualType toType, SourceRange range);
+        /** Cast condition to bool, or Vec<bool> for a varying condition. */
+        Expr* ActOnCondition(Expr* condition);
         Expr* ActOnSplat(Expr* expr, SourceRange range);
         
         Expr* ActOnNumericConstant(Token* value);
@@ -0,0 +1,221 @@
+#include <VCL/CodeGen/CodeGenModule.hpp>
+
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/DerivedTypes.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/InstIterator.h>
+#include <llvm/IR/ReplaceConstant.h>
+#include <llvm/Transforms/Utils/Cloning.h>
+#include <llvm/ADT/STLExtras.h>
+
+
+namespace {
+
+    /** Varying variables hold one value per sample, anything made of vectors. */
+    bool IsVaryingType(llvm::Type* type) {
+        if (type->isVectorTy())
+            return true;
+        if (llvm::ArrayType* arrayType = llvm::dyn_cast<llvm::ArrayType>(type); arrayType)
+            return IsVaryingType(arrayType->getElementType());
+        if (llvm::StructType* structType = llvm::dyn_cast<llvm::StructType>(type); structType)
+            return llvm::any_of(structType->elements(), IsVaryingType);
+        return false;
+    }
+
+    constexpr uint32_t MaxBlockInlineDepth = 64;
+
+}
+
+bool VCL::CodeGenModule::EmitBlockEntryPoint(FunctionDecl* decl, llvm::Function* function) {
+    llvm::LLVMContext& context = GetLLVMContext();
+
+    AttributeDefinition* entryPointAD = attributeTable.GetDefinition(identifierTable.Get("EntryPoint"));
+    AttributeDefinition* blockAD = attributeTable.GetDefinition(identifierTable.Get("Block"));
+
+    if (!decl->HasAttribute(entryPointAD) || function->arg_size() != 0 || function->isDeclaration()) {
+        diagnosticReporter.Error(Diagnostic::BlockInvalidEntryPoint)
+            .AddHint(DiagnosticHint{ decl->GetSourceRange() })
+            .SetCompilerInfo(__FILE__, __func__, __LINE__)
+            .Report();
+        return false;
+    }
+
+    if (useInstanceContext) {
+        diagnosticReporter.Error(Diagnostic::BlockInstanceContext)
+            .AddHint(DiagnosticHint{ decl->GetSourceRange() })
+            .SetCompilerInfo(__FILE__, __func__, __LINE__)
+            .Report();
+        return false;
+    }
+
+    // In/out variables of this module and the imported ones, by name.
+    llvm::StringMap<std::pair<VarDecl*, llvm::GlobalVariable*>> variables{};
+    for (auto& [globalDecl, gv] : globals) {
+        if (globalDecl->GetDeclClass() != Decl::VarDeclClass)
+            continue;
+        VarDecl* varDecl = (VarDecl*)globalDecl;
+        if (varDecl->HasInAttribute() || varDecl->HasOutAttribute())
+            variables.insert({ varDecl->GetIdentifierInfo()->GetName(), { varDecl, (llvm::GlobalVariable*)gv } });
+    }
+
+    // Inputs advanced by the wrapper are bound to a single value, the first step, and move by a
+    // whole vector of their lane to lane increment at every step.
+    llvm::SmallVector<llvm::GlobalVariable*> advanced{};
+    for (ConstantValue* arg : decl->HasAttribute(blockAD)->GetArgs()) {
+        llvm::StringRef name = arg->GetConstantValueClass() == ConstantValue::ConstantIdentifierClass ?
+            ((ConstantIdentifier*)arg)->GetIdentifierInfo()->GetName() : "";
+        auto it = variables.find(name);
+        llvm::FixedVectorType* type = it != variables.end() ? llvm::dyn_cast<llvm::FixedVectorType>(it->getValue().second->getValueType()) : nullptr;
+        if (!type || !type->getElementType()->isFloatingPointTy() || type->getNumElements() < 2 ||
+                !it->getValue().first->HasInAttribute() || it->getValue().first->HasOutAttribute()) {
+            diagnosticReporter.Error(Diagnostic::BlockInvalidAdvancedInput, name.str())
+                .AddHint(DiagnosticHint{ decl->GetSourceRange() })
+                .SetCompilerInfo(__FILE__, __func__, __LINE__)
+                .Report();
+            return false;
+        }
+        advanced.push_back(it->getValue().second);
+    }
+
+    // Every other varying variable is bound by the host to a buffer of one value per step.
+    llvm::SmallVector<llvm::GlobalVariable*> strided{};
+    for (auto& entry : variables) {
+        llvm::GlobalVariable* gv = entry.getValue().second;
+        if (!IsVaryingType(gv->getValueType()) || llvm::is_contained(advanced, gv))
+            continue;
+        strided.push_back(gv);
+    }
+    llvm::sort(strided, [](llvm::GlobalVariable* a, llvm::GlobalVariable* b) { return a->getName() < b->getName(); });
+
+    // The variables keep their single value for the entry point, the host store the address of each
+    // buffer in a '<EntryPoint>Block.<name>' pointer before running the block.
+    std::string wrapperName = (function->getName() + "Block").str();
+    llvm::PointerType* ptrType = llvm::PointerType::getUnqual(context);
+    llvm::SmallVector<llvm::GlobalVariable*> buffers{};
+    for (llvm::GlobalVariable* gv : strided) {
+        llvm::GlobalVariable* buffer = new llvm::GlobalVariable(module, ptrType, false,
+            llvm::GlobalValue::ExternalLinkage, llvm::ConstantPointerNull::get(ptrType), wrapperName + "." + gv->getName());
+        buffer->setDSOLocal(true);
+        buffers.push_back(buffer);
+    }
+
+    llvm::SmallVector<llvm::GlobalVariable*> redirected{ strided };
+    redirected.append(advanced.begin(), advanced.end());
+
+    llvm::SmallVector<llvm::Constant*> constants{ redirected.begin(), redirected.end() };
+    llvm::convertUsersOfConstantsToInstructions(constants);
+
+    // One step of the block is the entry point with every call inlined, so that each
+    // redirected variable is only reached from the step body and can become a parameter.
+    llvm::SmallVector<llvm::Type*> stepParamTypes(redirected.size(), ptrType);
+    llvm::Function* step = llvm::Function::Create(
+        llvm::FunctionType::get(llvm::Type::getVoidTy(context), stepParamTypes, false),
+        llvm::GlobalValue::InternalLinkage, function->getName() + ".BlockStep", module);
+
+    llvm::ValueToValueMapTy vmap{};
+    llvm::SmallVector<llvm::ReturnInst*> returns{};
+    llvm::CloneFunctionInto(step, function, vmap, llvm::CloneFunctionChangeType::LocalChangesOnly, returns);
+    step->setLinkage(llvm::GlobalValue::InternalLinkage);
+    step->setDSOLocal(true);
+    step->removeFnAttr(llvm::Attribute::NoInline);
+    step->addFnAttr(llvm::Attribute::AlwaysInline);
+
+    for (uint32_t depth = 0;; ++depth) {
+        llvm::SmallVector<llvm::CallBase*> calls{};
+        for (llvm::Instruction& instruction : llvm::instructions(step)) {
+            llvm::CallBase* call = llvm::dyn_cast<llvm::CallBase>(&instruction);
+            if (call && call->getCalledFunction() && !call->getCalledFunction()->isDeclaration())
+                calls.push_back(call);
+        }
+        if (calls.empty())
+            break;
+        if (depth == MaxBlockInlineDepth) {
+            diagnosticReporter.Error(Diagnostic::BlockRecursiveCall)
+                .AddHint(DiagnosticHint{ decl->GetSourceRange() })
+                .SetCompilerInfo(__FILE__, __func__, __LINE__)
+                .Report();
+            return false;
+        }
+        for (llvm::CallBase* call : calls) {
+            llvm::InlineFunctionInfo info{};
+            if (!llvm::InlineFunction(*call, info).isSuccess()) {
+                diagnosticReporter.Error(Diagnostic::InternalError)
+                    .SetCompilerInfo(__FILE__, __func__, __LINE__)
+                    .Report();
+                return false;
+            }
+        }
+    }
+
+    for (unsigned i = 0; i < redirected.size(); ++i) {
+        step->getArg(i)->setName(redirected[i]->getName());
+        llvm::SmallVector<llvm::User*> users{ redirected[i]->users() };
+        for (llvm::User* user : users) {
+            llvm::Instruction* instruction = llvm::dyn_cast<llvm::Instruction>(user);
+            if (instruction && instruction->getFunction() == step)
+                instruction->replaceUsesOfWith(redirected[i], step->getArg(i));
+        }
+    }
+
+    // void <EntryPoint>Block(uint64 count), run count steps one after the other.
+    llvm::Type* i64 = llvm::Type::getInt64Ty(context);
+    llvm::Function* wrapper = llvm::Function::Create(
+        llvm::FunctionType::get(llvm::Type::getVoidTy(context), { i64 }, false),
+        llvm::GlobalValue::ExternalLinkage, wrapperName, module);
+    wrapper->copyAttributesFrom(function);
+    wrapper->setLinkage(llvm::GlobalValue::ExternalLinkage);
+    wrapper->setDSOLocal(true);
+    wrapper->getArg(0)->setName("count");
+
+    llvm::BasicBlock* entryBB = llvm::BasicBlock::Create(context, "entry", wrapper);
+    llvm::BasicBlock* headerBB = llvm::BasicBlock::Create(context, "block.header", wrapper);
+    llvm::BasicBlock* bodyBB = llvm::BasicBlock::Create(context, "block.body", wrapper);
+    llvm::BasicBlock* exitBB = llvm::BasicBlock::Create(context, "block.exit", wrapper);
+
+    llvm::IRBuilder<> builder{ entryBB };
+    llvm::Align align{ target.GetVectorWidthInByte() };
+
+    llvm::SmallVector<llvm::Value*> bufferPtrs{};
+    for (llvm::GlobalVariable* buffer : buffers)
+        bufferPtrs.push_back(builder.CreateLoad(ptrType, buffer, buffer->getName()));
+
+    llvm::SmallVector<llvm::AllocaInst*> advancedValues{};
+    llvm::SmallVector<llvm::Value*> advancedDeltas{};
+    for (llvm::GlobalVariable* gv : advanced) {
+        llvm::FixedVectorType* type = llvm::cast<llvm::FixedVectorType>(gv->getValueType());
+        llvm::Value* first = builder.CreateAlignedLoad(type, gv, align);
+        llvm::Value* increment = builder.CreateFSub(builder.CreateExtractElement(first, (uint64_t)1), builder.CreateExtractElement(first, (uint64_t)0));
+        llvm::Value* stride = builder.CreateFMul(increment, llvm::ConstantFP::get(type->getElementType(), type->getNumElements()));
+        advancedDeltas.push_back(builder.CreateVectorSplat(type->getNumElements(), stride));
+        llvm::AllocaInst* value = builder.CreateAlloca(type, nullptr, gv->getName());
+        value->setAlignment(align);
+        builder.CreateAlignedStore(first, value, align);
+        advancedValues.push_back(value);
+    }
+    builder.CreateBr(headerBB);
+
+    builder.SetInsertPoint(headerBB);
+    llvm::PHINode* index = builder.CreatePHI(i64, 2, "index");
+    index->addIncoming(llvm::ConstantInt::get(i64, 0), entryBB);
+    builder.CreateCondBr(builder.CreateICmpULT(index, wrapper->getArg(0)), bodyBB, exitBB);
+
+    builder.SetInsertPoint(bodyBB);
+    llvm::SmallVector<llvm::Value*> args{};
+    for (unsigned i = 0; i < buffers.size(); ++i)
+        args.push_back(builder.CreateInBoundsGEP(strided[i]->getValueType(), bufferPtrs[i], index));
+    args.append(advancedValues.begin(), advancedValues.end());
+    builder.CreateCall(step, args);
+    for (unsigned i = 0; i < advanced.size(); ++i) {
+        llvm::Type* type = advanced[i]->getValueType();
+        llvm::Value* value = builder.CreateAlignedLoad(type, advancedValues[i], align);
+        builder.CreateAlignedStore(builder.CreateFAdd(value, advancedDeltas[i]), advancedValues[i], align);
+    }
+    llvm::Value* nextIndex = builder.CreateNUWAdd(index, llvm::ConstantInt::get(i64, 1));
+    index->addIncoming(nextIndex, bodyBB);
+    builder.CreateBr(headerBB);
+
+    builder.SetInsertPoint(exitBB);
+    builder.CreateRetVoid();
+
+    return true;
+}
\ No newline at end of file
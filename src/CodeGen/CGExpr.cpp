@@ -2,6 +2,8 @@
 
 #include <VCL/CodeGen/CodeGenModule.hpp>
 
+#include <algorithm>
+
 
 
 llvm::Value* VCL::CodeGenFunction::GenerateExpr(Expr* expr) {
@@ -46,7 +48,7 @@ llvm::Value* VCL::CodeGenFunction::GenerateLoadExpr(LoadExpr* expr) {
     llvm::Value* exprValue = GenerateExpr(expr->GetExpr());
     if (!exprValue)
         return nullptr;
-    llvm::Value* v = builder.CreateLoad(cgm.GetCGT().ConvertType(expr->GetResultType()), exprValue);
+    llvm::Value* v = GenerateLoad(cgm.GetCGT().ConvertType(expr->GetResultType()), exprValue);
     return v;
 }
 
@@ -159,7 +161,7 @@ llvm::Value* VCL::CodeGenFunction::GenerateBinaryExpr(BinaryExpr* expr) {
             if (!lhsExprValue || !rhsExprValue) {
                 return nullptr;
             }
-            return builder.CreateStore(rhsExprValue, lhsExprValue);
+            return GenerateStore(rhsExprValue, lhsExprValue);
         }
         default:
             cgm.GetDiagnosticReporter().Error(Diagnostic::InternalError)
@@ -174,46 +176,46 @@ llvm::Value* VCL::CodeGenFunction::GenerateUnaryExpr(UnaryExpr* expr) {
     switch (expr->GetOperator()) {
         case UnaryOperator::PrefixIncrement: {
             llvm::Value* exprValue = GenerateExpr(expr->GetExpr());
-            llvm::Value* loadedExprValue = builder.CreateLoad(cgm.GetCGT().ConvertType(expr->GetResultType()), exprValue);
+            llvm::Value* loadedExprValue = GenerateLoad(cgm.GetCGT().ConvertType(expr->GetResultType()), exprValue);
             llvm::Value* result = nullptr;
             if (loadedExprValue->getType()->isFloatingPointTy())
                 result = builder.CreateFAdd(loadedExprValue, llvm::ConstantFP::get(loadedExprValue->getType(), 1.0));
             else
                 result = builder.CreateAdd(loadedExprValue, llvm::ConstantInt::get(loadedExprValue->getType(), 1));
-            builder.CreateStore(result, exprValue);
+            GenerateStore(result, exprValue);
             return result;
         }
         case UnaryOperator::PrefixDecrement: {
             llvm::Value* exprValue = GenerateExpr(expr->GetExpr());
-            llvm::Value* loadedExprValue = builder.CreateLoad(cgm.GetCGT().ConvertType(expr->GetResultType()), exprValue);
+            llvm::Value* loadedExprValue = GenerateLoad(cgm.GetCGT().ConvertType(expr->GetResultType()), exprValue);
             llvm::Value* result = nullptr;
             if (loadedExprValue->getType()->isFloatingPointTy())
                 result = builder.CreateFSub(loadedExprValue, llvm::ConstantFP::get(loadedExprValue->getType(), 1.0));
             else
                 result = builder.CreateSub(loadedExprValue, llvm::ConstantInt::get(loadedExprValue->getType(), 1));
-            builder.CreateStore(result, exprValue);
+            GenerateStore(result, exprValue);
             return result;
         }
         case UnaryOperator::PostfixIncrement: {
             llvm::Value* exprValue = GenerateExpr(expr->GetExpr());
-            llvm::Value* loadedExprValue = builder.CreateLoad(cgm.GetCGT().ConvertType(expr->GetResultType()), exprValue);
+            llvm::Value* loadedExprValue = GenerateLoad(cgm.GetCGT().ConvertType(expr->GetResultType()), exprValue);
             llvm::Value* result = nullptr;
             if (loadedExprValue->getType()->isFloatingPointTy())
                 result = builder.CreateFAdd(loadedExprValue, llvm::ConstantFP::get(loadedExprValue->getType(), 1.0));
             else
                 result = builder.CreateAdd(loadedExprValue, llvm::ConstantInt::get(loadedExprValue->getType(), 1));
-            builder.CreateStore(result, exprValue);
+            GenerateStore(result, exprValue);
             return loadedExprValue;
         }
         case UnaryOperator::PostfixDecrement: {
             llvm::Value* exprValue = GenerateExpr(expr->GetExpr());
-            llvm::Value* loadedExprValue = builder.CreateLoad(cgm.GetCGT().ConvertType(expr->GetResultType()), exprValue);
+            llvm::Value* loadedExprValue = GenerateLoad(cgm.GetCGT().ConvertType(expr->GetResultType()), exprValue);
             llvm::Value* result = nullptr;
             if (loadedExprValue->getType()->isFloatingPointTy())
                 result = builder.CreateFSub(loadedExprValue, llvm::ConstantFP::get(loadedExprValue->getType(), 1.0));
             else
                 result = builder.CreateSub(loadedExprValue, llvm::ConstantInt::get(loadedExprValue->getType(), 1));
-            builder.CreateStore(result, exprValue);
+            GenerateStore(result, exprValue);
             return loadedExprValue;
         }
         case UnaryOperator::Plus: {
@@ -318,7 +320,16 @@ llvm::Value* VCL::CodeGenFunction::GenerateCallExpr(CallExpr* expr) {
         argsValue.push_back(argValue);
     }
 
-    return builder.CreateCall(llvm::cast<llvm::Function>(value), argsValue);
+    // Under varying control flow, the callee must only touch the active lanes too.
+    llvm::Function* callee = llvm::cast<llvm::Function>(value);
+    if (mask) {
+        callee = cgm.GetMaskedFunction(expr->GetFunctionDecl());
+        if (!callee)
+            return nullptr;
+        argsValue.push_back(mask);
+    }
+
+    return builder.CreateCall(callee, argsValue);
 }
 
 llvm::Value* VCL::CodeGenFunction::GenerateIntrinsicCallExpr(CallExpr* expr) {
@@ -330,6 +341,14 @@ llvm::Value* VCL::CodeGenFunction::GenerateIntrinsicCallExpr(CallExpr* expr) {
         argsValue.push_back(argValue);
     }
 
+    // Vectors of float32 use the polynomials of CGMath rather than a C library call per lane.
+    if (!strictIEEE && !argsValue.empty()) {
+        MathAccuracy accuracy = allowApproxFunc ? MathAccuracy::Fast : cgm.GetMathAccuracy();
+        llvm::Function* mathFunction = cgm.GetVectorMathFunction(expr->GetFunctionDecl()->GetIntrinsicID(), argsValue[0]->getType(), accuracy);
+        if (mathFunction)
+            return builder.CreateCall(mathFunction, argsValue);
+    }
+
     switch (expr->GetFunctionDecl()->GetIntrinsicID()) {
         // Unary Math
         case FunctionDecl::IntrinsicID::Sin: return builder.CreateUnaryIntrinsic(llvm::Intrinsic::sin, argsValue[0]);
@@ -350,13 +369,29 @@ llvm::Value* VCL::CodeGenFunction::GenerateIntrinsicCallExpr(CallExpr* expr) {
         case FunctionDecl::IntrinsicID::Floor: return builder.CreateUnaryIntrinsic(llvm::Intrinsic::floor, argsValue[0]);
         case FunctionDecl::IntrinsicID::Ceil: return builder.CreateUnaryIntrinsic(llvm::Intrinsic::ceil, argsValue[0]);
         case FunctionDecl::IntrinsicID::Round: return builder.CreateUnaryIntrinsic(llvm::Intrinsic::round, argsValue[0]);
+        case FunctionDecl::IntrinsicID::Fract: {
+            llvm::Value* fraction = builder.CreateFSub(argsValue[0], builder.CreateUnaryIntrinsic(llvm::Intrinsic::floor, argsValue[0]));
+            // Tiny negative values would round up to 1, keep the result below like GLSL.
+            llvm::APFloat belowOne{ fraction->getType()->getScalarType()->getFltSemantics(), 1 };
+            belowOne.next(true);
+            llvm::Constant* belowOneValue = llvm::ConstantFP::get(fraction->getType(), belowOne);
+            return builder.CreateSelect(builder.CreateFCmpOGE(fraction, belowOneValue), belowOneValue, fraction);
+        }
         case FunctionDecl::IntrinsicID::Abs: return builder.CreateUnaryIntrinsic(llvm::Intrinsic::abs, argsValue[0]);
         // Binary Math
         case FunctionDecl::IntrinsicID::ATan2: return builder.CreateBinaryIntrinsic(llvm::Intrinsic::atan2, argsValue[0], argsValue[1]);
         case FunctionDecl::IntrinsicID::Pow: return builder.CreateBinaryIntrinsic(llvm::Intrinsic::pow, argsValue[0], argsValue[1]);
         case FunctionDecl::IntrinsicID::Min: return builder.CreateBinaryIntrinsic(llvm::Intrinsic::minimum, argsValue[0], argsValue[1]);
         case FunctionDecl::IntrinsicID::Max: return builder.CreateBinaryIntrinsic(llvm::Intrinsic::maximum, argsValue[0], argsValue[1]);
-        case FunctionDecl::IntrinsicID::FMod: return builder.CreateFRem(argsValue[0], argsValue[1]);
+        case FunctionDecl::IntrinsicID::FMod: {
+            // frem is a C library call per lane, x - trunc(x / y) * y only differ from it by the rounding of x / y,
+            // the result may then be off by y once |x / y| get close to 2^24 for float32.
+            if (strictIEEE || cgm.GetMathAccuracy() == MathAccuracy::Libm)
+                return builder.CreateFRem(argsValue[0], argsValue[1]);
+            llvm::Value* quotient = builder.CreateUnaryIntrinsic(llvm::Intrinsic::trunc, builder.CreateFDiv(argsValue[0], argsValue[1]));
+            return builder.CreateIntrinsic(llvm::Intrinsic::fmuladd, { quotient->getType() },
+                { builder.CreateFNeg(quotient), argsValue[1], argsValue[0] });
+        }
         // Ternary Math
         case FunctionDecl::IntrinsicID::Fma: return builder.CreateFMA(argsValue[0], argsValue[1], argsValue[2]);
         // Unpack & Pack
@@ -373,6 +408,80 @@ llvm::Value* VCL::CodeGenFunction::GenerateIntrinsicCallExpr(CallExpr* expr) {
             }
             return builder.CreateAlignedLoad(returnType, value, align);
         }
+        // Lane, vector widths are powers of two so lane indices wrap with a mask.
+        case FunctionDecl::IntrinsicID::Reverse: return builder.CreateVectorReverse(argsValue[0]);
+        case FunctionDecl::IntrinsicID::Shuffle: {
+            uint32_t width = llvm::cast<llvm::FixedVectorType>(argsValue[0]->getType())->getNumElements();
+            llvm::Value* indices = builder.CreateAnd(argsValue[1], width - 1);
+            if (llvm::Constant* constantIndices = llvm::dyn_cast<llvm::Constant>(indices)) {
+                llvm::SmallVector<int> shuffleMask{};
+                for (uint32_t i = 0; i < width; ++i) {
+                    llvm::ConstantInt* index = llvm::dyn_cast<llvm::ConstantInt>(constantIndices->getAggregateElement(i));
+                    shuffleMask.push_back(index ? (int)index->getZExtValue() : llvm::PoisonMaskElem);
+                }
+                return builder.CreateShuffleVector(argsValue[0], shuffleMask);
+            }
+            // Lanes picked at run time are read back from the stack.
+            llvm::Type* elementType = argsValue[0]->getType()->getScalarType();
+            llvm::AllocaInst* alloca = GenerateAllocaInst(argsValue[0]->getType(), "shuffle");
+            builder.CreateStore(argsValue[0], alloca);
+            llvm::Align align = cgm.GetLLVMModule().getDataLayout().getABITypeAlign(elementType);
+            return builder.CreateMaskedGather(argsValue[0]->getType(), builder.CreateGEP(elementType, alloca, indices), align);
+        }
+        case FunctionDecl::IntrinsicID::Rotate: {
+            uint32_t width = llvm::cast<llvm::FixedVectorType>(argsValue[0]->getType())->getNumElements();
+            return GenerateLaneSlide(argsValue[0], argsValue[0], builder.CreateAnd(argsValue[1], width - 1));
+        }
+        case FunctionDecl::IntrinsicID::Slide: {
+            uint32_t width = llvm::cast<llvm::FixedVectorType>(argsValue[0]->getType())->getNumElements();
+            llvm::Value* offset = argsValue[2];
+            if (llvm::ConstantInt* constantOffset = llvm::dyn_cast<llvm::ConstantInt>(offset)) {
+                offset = builder.getInt32(std::clamp<int64_t>(constantOffset->getSExtValue(), 0, width));
+            } else {
+                offset = builder.CreateBinaryIntrinsic(llvm::Intrinsic::smax, offset, builder.getInt32(0));
+                offset = builder.CreateBinaryIntrinsic(llvm::Intrinsic::smin, offset, builder.getInt32(width));
+            }
+            return GenerateLaneSlide(argsValue[0], argsValue[1], offset);
+        }
+        case FunctionDecl::IntrinsicID::Broadcast: {
+            uint32_t width = llvm::cast<llvm::FixedVectorType>(argsValue[0]->getType())->getNumElements();
+            llvm::Value* lane = builder.CreateAnd(argsValue[1], width - 1);
+            if (llvm::ConstantInt* constantLane = llvm::dyn_cast<llvm::ConstantInt>(lane))
+                return builder.CreateShuffleVector(argsValue[0], llvm::SmallVector<int>(width, (int)constantLane->getZExtValue()));
+            return builder.CreateVectorSplat(width, builder.CreateExtractElement(argsValue[0], lane));
+        }
+        // Scan, a prefix sum is a recurrence whose factors are all one.
+        case FunctionDecl::IntrinsicID::PrefixSum: {
+            llvm::Type* type = argsValue[0]->getType();
+            llvm::Value* one = type->isFPOrFPVectorTy() ? llvm::ConstantFP::get(type, 1.0) : llvm::ConstantInt::get(type, 1);
+            return GenerateLinearRecurrence(one, argsValue[0], argsValue[1]);
+        }
+        case FunctionDecl::IntrinsicID::LinearRecurrence: return GenerateLinearRecurrence(argsValue[0], argsValue[1], argsValue[2]);
+        // Reduction
+        case FunctionDecl::IntrinsicID::ReduceAdd:
+        case FunctionDecl::IntrinsicID::ReduceMul: {
+            bool isAdd = expr->GetFunctionDecl()->GetIntrinsicID() == FunctionDecl::IntrinsicID::ReduceAdd;
+            if (!argsValue[0]->getType()->isFPOrFPVectorTy())
+                return isAdd ? builder.CreateAddReduce(argsValue[0]) : builder.CreateMulReduce(argsValue[0]);
+            // Lanes are accumulated in order under [StrictIEEE], otherwise in any order so the reduction can be a tree of shuffles.
+            llvm::Type* elementType = argsValue[0]->getType()->getScalarType();
+            llvm::CallInst* result = isAdd ? builder.CreateFAddReduce(llvm::ConstantFP::getNegativeZero(elementType), argsValue[0])
+                : builder.CreateFMulReduce(llvm::ConstantFP::get(elementType, 1.0), argsValue[0]);
+            if (!strictIEEE)
+                result->setHasAllowReassoc(true);
+            return result;
+        }
+        case FunctionDecl::IntrinsicID::ReduceMin:
+        case FunctionDecl::IntrinsicID::ReduceMax: {
+            bool isMin = expr->GetFunctionDecl()->GetIntrinsicID() == FunctionDecl::IntrinsicID::ReduceMin;
+            if (argsValue[0]->getType()->isFPOrFPVectorTy())
+                return isMin ? builder.CreateFPMinReduce(argsValue[0]) : builder.CreateFPMaxReduce(argsValue[0]);
+            BuiltinType* type = (BuiltinType*)Type::GetCanonicalType(expr->GetFunctionDecl()->GetType()->GetReturnType().GetType());
+            bool isSigned = BuiltinType::GetKindCategory(type->GetKind()) == BuiltinType::Category::SignedKind;
+            return isMin ? builder.CreateIntMinReduce(argsValue[0], isSigned) : builder.CreateIntMaxReduce(argsValue[0], isSigned);
+        }
+        case FunctionDecl::IntrinsicID::ReduceAny: return builder.CreateOrReduce(argsValue[0]);
+        case FunctionDecl::IntrinsicID::ReduceAll: return builder.CreateAndReduce(argsValue[0]);
         // Length
         case FunctionDecl::IntrinsicID::Length: {
             Type* type = Type::GetCanonicalType(expr->GetFunctionDecl()->GetType()->GetParamsType()[0].GetType());
@@ -383,9 +492,8 @@ llvm::Value* VCL::CodeGenFunction::GenerateIntrinsicCallExpr(CallExpr* expr) {
                 uint64_t size = ((ArrayType*)type)->GetElementCount();
                 return llvm::ConstantInt::get(cgm.GetLLVMContext(), llvm::APInt{ 64, size });
             } else if (type->GetTypeClass() == Type::SpanTypeClass) {
-                llvm::StructType* spanType = cgm.GetCGT().ConvertSpanType(type);
-                llvm::Value* v = builder.CreateLoad(spanType->getStructElementType(1), builder.CreateStructGEP(spanType, argsValue[0], 1));
-                return v;
+                // Spans are passed by value, the loaded { ptr, size } pair.
+                return builder.CreateExtractValue(argsValue[0], 1);
             } else {
                 cgm.GetDiagnosticReporter().Error(Diagnostic::InternalError)
                     .SetCompilerInfo(__FILE__, __func__, __LINE__)
@@ -395,6 +503,44 @@ llvm::Value* VCL::CodeGenFunction::GenerateIntrinsicCallExpr(CallExpr* expr) {
         }
         // Select
         case FunctionDecl::IntrinsicID::Select: return builder.CreateSelect(argsValue[0], argsValue[1], argsValue[2]);
+        case FunctionDecl::IntrinsicID::LaneMask: {
+            uint32_t width = cgm.GetTarget().GetVectorWidthInElement();
+            llvm::SmallVector<llvm::Constant*> lanes{};
+            for (uint32_t i = 0; i < width; ++i)
+                lanes.push_back(llvm::ConstantInt::get(argsValue[0]->getType(), i));
+            BuiltinType* type = (BuiltinType*)Type::GetCanonicalType(expr->GetFunctionDecl()->GetType()->GetParamsType()[0].GetType());
+            bool isSigned = BuiltinType::GetKindCategory(type->GetKind()) == BuiltinType::Category::SignedKind;
+            return builder.CreateICmp(isSigned ? llvm::CmpInst::ICMP_SGT : llvm::CmpInst::ICMP_UGT,
+                builder.CreateVectorSplat(width, argsValue[0]), llvm::ConstantVector::get(lanes));
+        }
+        // Masked Load / Store
+        case FunctionDecl::IntrinsicID::MaskedLoad:
+        case FunctionDecl::IntrinsicID::MaskedStore: {
+            bool isLoad = expr->GetFunctionDecl()->GetIntrinsicID() == FunctionDecl::IntrinsicID::MaskedLoad;
+            SpanType* spanType = (SpanType*)Type::GetCanonicalType(expr->GetFunctionDecl()->GetType()->GetParamsType()[0].GetType());
+            llvm::Type* elementType = cgm.GetCGT().ConvertType(spanType->GetElementType());
+            llvm::Value* ptr = builder.CreateGEP(elementType, builder.CreateExtractValue(argsValue[0], 0), argsValue[1]);
+            llvm::Align align = cgm.GetLLVMModule().getDataLayout().getABITypeAlign(elementType);
+            // Lanes inactive under varying control flow are left out as well.
+            llvm::Value* laneMask = argsValue[isLoad ? 2 : 3];
+            if (mask)
+                laneMask = builder.CreateAnd(laneMask, mask);
+            if (isLoad) {
+                llvm::Type* type = llvm::FixedVectorType::get(elementType, cgm.GetTarget().GetVectorWidthInElement());
+                return builder.CreateMaskedLoad(type, ptr, align, laneMask, llvm::Constant::getNullValue(type));
+            }
+            return builder.CreateMaskedStore(argsValue[2], ptr, align, laneMask);
+        }
+        // Gather / Scatter
+        case FunctionDecl::IntrinsicID::Gather:
+        case FunctionDecl::IntrinsicID::Scatter: {
+            SpanType* spanType = (SpanType*)Type::GetCanonicalType(expr->GetFunctionDecl()->GetType()->GetParamsType()[0].GetType());
+            llvm::Type* elementType = cgm.GetCGT().ConvertType(spanType->GetElementType());
+            llvm::Value* ptrs = builder.CreateGEP(elementType, builder.CreateExtractValue(argsValue[0], 0), argsValue[1]);
+            if (expr->GetFunctionDecl()->GetIntrinsicID() == FunctionDecl::IntrinsicID::Gather)
+                return GenerateLoad(llvm::FixedVectorType::get(elementType, cgm.GetTarget().GetVectorWidthInElement()), ptrs);
+            return GenerateStore(argsValue[2], ptrs);
+        }
         default: 
             cgm.GetDiagnosticReporter().Error(Diagnostic::MissingImplementation)
                 .SetCompilerInfo(__FILE__, __func__, __LINE__)
@@ -420,6 +566,7 @@ llvm::Value* VCL::CodeGenFunction::GenerateSubscriptExpr(SubscriptExpr* expr) {
         llvm::Type* spanTypeLLVM = cgm.GetCGT().ConvertSpanType(spanType);
         llvm::Type* type = cgm.GetCGT().ConvertType(spanType->GetElementType());
         lhs = builder.CreateLoad(spanTypeLLVM->getStructElementType(0), builder.CreateStructGEP(spanTypeLLVM, lhs, 0));
+        // A vector index yield a vector of pointers, see GenerateLoad and GenerateStore.
         llvm::Value* result = builder.CreateGEP(type, lhs, index);
         return result;
     } else {
@@ -430,6 +577,58 @@ llvm::Value* VCL::CodeGenFunction::GenerateSubscriptExpr(SubscriptExpr* expr) {
     }
 }
 
+llvm::Value* VCL::CodeGenFunction::GenerateLaneSlide(llvm::Value* lhs, llvm::Value* rhs, llvm::Value* offset) {
+    uint32_t width = llvm::cast<llvm::FixedVectorType>(lhs->getType())->getNumElements();
+    if (llvm::ConstantInt* constantOffset = llvm::dyn_cast<llvm::ConstantInt>(offset)) {
+        llvm::SmallVector<int> shuffleMask{};
+        for (uint32_t i = 0; i < width; ++i)
+            shuffleMask.push_back(constantOffset->getZExtValue() + i);
+        return builder.CreateShuffleVector(lhs, rhs, shuffleMask);
+    }
+
+    // Both vectors are stored next to each other and the result loaded at the offset.
+    llvm::Type* elementType = lhs->getType()->getScalarType();
+    llvm::AllocaInst* alloca = GenerateAllocaInst(llvm::ArrayType::get(lhs->getType(), 2), "slide");
+    builder.CreateStore(lhs, builder.CreateConstGEP2_32(alloca->getAllocatedType(), alloca, 0, 0));
+    builder.CreateStore(rhs, builder.CreateConstGEP2_32(alloca->getAllocatedType(), alloca, 0, 1));
+    llvm::Align align = cgm.GetLLVMModule().getDataLayout().getABITypeAlign(elementType);
+    return builder.CreateAlignedLoad(lhs->getType(), builder.CreateGEP(elementType, alloca, offset), align);
+}
+
+llvm::Value* VCL::CodeGenFunction::GenerateLinearRecurrence(llvm::Value* a, llvm::Value* b, llvm::Value* state) {
+    llvm::Type* type = b->getType();
+    uint32_t width = llvm::cast<llvm::FixedVectorType>(type)->getNumElements();
+    bool isFloat = type->isFPOrFPVectorTy();
+    auto mul = [&](llvm::Value* lhs, llvm::Value* rhs) { return isFloat ? builder.CreateFMul(lhs, rhs) : builder.CreateMul(lhs, rhs); };
+    auto add = [&](llvm::Value* lhs, llvm::Value* rhs) { return isFloat ? builder.CreateFAdd(lhs, rhs) : builder.CreateAdd(lhs, rhs); };
+
+    llvm::Value* initial = builder.CreateLoad(type->getScalarType(), state);
+    llvm::Value* result = nullptr;
+    if (strictIEEE && isFloat) {
+        // Lanes are computed one after the other, rounding like the scalar loop.
+        llvm::Value* y = initial;
+        result = llvm::PoisonValue::get(type);
+        for (uint32_t i = 0; i < width; ++i) {
+            y = add(mul(builder.CreateExtractElement(a, i), y), builder.CreateExtractElement(b, i));
+            result = builder.CreateInsertElement(result, y, i);
+        }
+    } else {
+        // After the step s each lane hold y[i] = a[i] * y[i - s] + b[i], composing it with the lane s before doubles s.
+        // Lanes before the first are the identity, a = 1 and b = 0.
+        llvm::Value* one = isFloat ? llvm::ConstantFP::get(type, 1.0) : llvm::ConstantInt::get(type, 1);
+        llvm::Value* zero = llvm::Constant::getNullValue(type);
+        for (uint32_t s = 1; s < width; s *= 2) {
+            llvm::Value* offset = builder.getInt32(width - s);
+            b = add(mul(a, GenerateLaneSlide(zero, b, offset)), b);
+            a = mul(a, GenerateLaneSlide(one, a, offset));
+        }
+        result = add(mul(a, builder.CreateVectorSplat(width, initial)), b);
+    }
+
+    GenerateStore(builder.CreateExtractElement(result, width - 1), state);
+    return result;
+}
+
 llvm::Value* VCL::CodeGenFunction::GenerateAggregateExpr(AggregateExpr* expr) {
     llvm::Type* type = cgm.GetCGT().ConvertType(expr->GetResultType());
     llvm::Value* agg = llvm::PoisonValue::get(type);
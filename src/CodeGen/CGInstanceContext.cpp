@@ -0,0 +1,215 @@
+#include <VCL/CodeGen/CodeGenModule.hpp>
+
+#include <VCL/CodeGen/InstanceContext.hpp>
+
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/DerivedTypes.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Metadata.h>
+#include <llvm/IR/ReplaceConstant.h>
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/SetVector.h>
+#include <llvm/ADT/SmallPtrSet.h>
+
+
+bool VCL::CodeGenModule::LowerInstanceContext() {
+    llvm::LLVMContext& context = GetLLVMContext();
+
+    // Imported modules are compiled on their own and keep their in/out variables as globals,
+    // their functions would still read and write those instead of the context.
+    for (auto& [name, importedModule] : importedModules) {
+        TranslationUnitDecl* tu = importedModule->GetCompilerInstance()->GetASTContext().GetTranslationUnitDecl();
+        for (auto it = tu->Begin(); it != tu->End(); ++it) {
+            if (it->GetDeclClass() != Decl::VarDeclClass)
+                continue;
+            VarDecl* decl = (VarDecl*)it.Get();
+            if (decl->HasInAttribute() || decl->HasOutAttribute()) {
+                diagnosticReporter.Error(Diagnostic::ImportedInstanceContext, decl->GetIdentifierInfo()->GetName().str())
+                    .AddHint(DiagnosticHint{ decl->GetSourceRange() })
+                    .SetCompilerInfo(__FILE__, __func__, __LINE__)
+                    .Report();
+                return false;
+            }
+        }
+    }
+
+    llvm::SmallVector<llvm::Type*> fieldTypes{};
+    llvm::SmallVector<llvm::Constant*> fieldGlobals{};
+    for (auto& [decl, gv] : contextGlobals) {
+        fieldTypes.push_back(gv->getValueType());
+        fieldGlobals.push_back(gv);
+    }
+
+    llvm::StructType* contextType = llvm::StructType::create(context, fieldTypes, "InstanceContext");
+    llvm::PointerType* contextPtrType = llvm::PointerType::getUnqual(context);
+
+    // Field access on globals are folded into constant expressions, turn them into instructions
+    // so every use of a global belong to a function.
+    llvm::convertUsersOfConstantsToInstructions(fieldGlobals);
+
+    // Entry points and every function that reach an in/out variable get the context as first parameter.
+    AttributeDefinition* entryPointAD = attributeTable.GetDefinition(identifierTable.Get("EntryPoint"));
+    llvm::SmallPtrSet<llvm::GlobalValue*, 8> entryPoints{};
+    for (auto& [decl, gv] : globals)
+        if (decl->GetDeclClass() == Decl::FunctionDeclClass && ((FunctionDecl*)decl)->HasAttribute(entryPointAD) && !IsDeclImported(decl))
+            entryPoints.insert(gv);
+
+    llvm::SetVector<llvm::Function*> functions{};
+    for (llvm::Function& function : module)
+        if (!function.isDeclaration() && entryPoints.contains(&function))
+            functions.insert(&function);
+    for (llvm::Constant* gv : fieldGlobals) {
+        for (llvm::User* user : gv->users()) {
+            if (!llvm::isa<llvm::Instruction>(user)) {
+                diagnosticReporter.Error(Diagnostic::InternalError)
+                    .SetCompilerInfo(__FILE__, __func__, __LINE__)
+                    .Report();
+                return false;
+            }
+            functions.insert(llvm::cast<llvm::Instruction>(user)->getFunction());
+        }
+    }
+    for (size_t i = 0; i < functions.size(); ++i) {
+        for (llvm::User* user : functions[i]->users()) {
+            if (llvm::CallInst* call = llvm::dyn_cast<llvm::CallInst>(user); call)
+                functions.insert(call->getFunction());
+        }
+    }
+
+    llvm::DenseMap<llvm::Function*, llvm::Function*> replacements{};
+
+    for (llvm::Function* function : functions) {
+        llvm::FunctionType* functionType = function->getFunctionType();
+        llvm::SmallVector<llvm::Type*> paramTypes{ contextPtrType };
+        paramTypes.append(functionType->param_begin(), functionType->param_end());
+
+        llvm::Function* newFunction = llvm::Function::Create(
+            llvm::FunctionType::get(functionType->getReturnType(), paramTypes, functionType->isVarArg()), 
+            function->getLinkage(), function->getAddressSpace(), "", &module);
+        newFunction->copyAttributesFrom(function);
+
+        llvm::AttributeList attributes = function->getAttributes();
+        llvm::SmallVector<llvm::AttributeSet> paramAttributes{ llvm::AttributeSet{} };
+        for (unsigned i = 0; i < functionType->getNumParams(); ++i)
+            paramAttributes.push_back(attributes.getParamAttrs(i));
+        newFunction->setAttributes(llvm::AttributeList::get(context, attributes.getFnAttrs(), attributes.getRetAttrs(), paramAttributes));
+
+        newFunction->takeName(function);
+        newFunction->splice(newFunction->begin(), function);
+        newFunction->getArg(0)->setName("context");
+        for (unsigned i = 0; i < functionType->getNumParams(); ++i) {
+            function->getArg(i)->replaceAllUsesWith(newFunction->getArg(i + 1));
+            newFunction->getArg(i + 1)->takeName(function->getArg(i));
+        }
+
+        replacements.insert({ function, newFunction });
+    }
+
+    llvm::IRBuilder<> builder{ context };
+
+    // Every caller is itself a replaced function, forward its own context.
+    for (auto& [function, newFunction] : replacements) {
+        llvm::SmallVector<llvm::User*> users{ function->users() };
+        for (llvm::User* user : users) {
+            llvm::CallInst* call = llvm::dyn_cast<llvm::CallInst>(user);
+            if (!call || call->getCalledFunction() != function) {
+                diagnosticReporter.Error(Diagnostic::InternalError)
+                    .SetCompilerInfo(__FILE__, __func__, __LINE__)
+                    .Report();
+                return false;
+            }
+
+            llvm::SmallVector<llvm::Value*> args{ call->getFunction()->getArg(0) };
+            args.append(call->arg_begin(), call->arg_end());
+
+            builder.SetInsertPoint(call);
+            llvm::CallInst* newCall = builder.CreateCall(newFunction, args);
+            newCall->setCallingConv(call->getCallingConv());
+            newCall->setTailCallKind(call->getTailCallKind());
+            newCall->setDebugLoc(call->getDebugLoc());
+            call->replaceAllUsesWith(newCall);
+            newCall->takeName(call);
+            call->eraseFromParent();
+        }
+    }
+
+    for (auto& [function, newFunction] : replacements)
+        function->eraseFromParent();
+
+    // Replace each in/out variable by its field, addressed once at the start of each function.
+    for (unsigned i = 0; i < contextGlobals.size(); ++i) {
+        llvm::GlobalVariable* gv = contextGlobals[i].second;
+        llvm::DenseMap<llvm::Function*, llvm::Value*> fieldPtrs{};
+        llvm::SmallVector<llvm::User*> users{ gv->users() };
+        for (llvm::User* user : users) {
+            llvm::Instruction* instruction = llvm::cast<llvm::Instruction>(user);
+            llvm::Function* function = instruction->getFunction();
+            llvm::Value*& fieldPtr = fieldPtrs[function];
+            if (!fieldPtr) {
+                builder.SetInsertPoint(&function->getEntryBlock(), function->getEntryBlock().getFirstInsertionPt());
+                fieldPtr = builder.CreateStructGEP(contextType, function->getArg(0), i, gv->getName());
+            }
+            instruction->replaceUsesOfWith(gv, fieldPtr);
+        }
+    }
+
+    // Record the layout so the host can fill the context without knowing the generated type.
+    const llvm::DataLayout& layout = module.getDataLayout();
+    const llvm::StructLayout* structLayout = layout.getStructLayout(contextType);
+    llvm::Type* i64 = llvm::Type::getInt64Ty(context);
+
+    llvm::NamedMDNode* fieldsMD = module.getOrInsertNamedMetadata(InstanceContextLayout::FieldsMetadataName);
+    for (unsigned i = 0; i < contextGlobals.size(); ++i) {
+        auto& [decl, gv] = contextGlobals[i];
+        llvm::StringRef direction = decl->HasInoutAttribute() ? "inout" : (decl->HasInAttribute() ? "in" : "out");
+        fieldsMD->addOperand(llvm::MDNode::get(context, {
+            llvm::MDString::get(context, decl->GetIdentifierInfo()->GetName()),
+            llvm::MDString::get(context, direction),
+            llvm::ConstantAsMetadata::get(llvm::ConstantInt::get(i64, structLayout->getElementOffset(i))),
+            llvm::ConstantAsMetadata::get(llvm::ConstantInt::get(i64, layout.getTypeAllocSize(fieldTypes[i])))
+        }));
+    }
+
+    llvm::NamedMDNode* layoutMD = module.getOrInsertNamedMetadata(InstanceContextLayout::LayoutMetadataName);
+    layoutMD->addOperand(llvm::MDNode::get(context, {
+        llvm::ConstantAsMetadata::get(llvm::ConstantInt::get(i64, structLayout->getSizeInBytes())),
+        llvm::ConstantAsMetadata::get(llvm::ConstantInt::get(i64, layout.getABITypeAlign(contextType).value()))
+    }));
+
+    for (auto& [decl, gv] : contextGlobals) {
+        globals.erase(decl);
+        gv->eraseFromParent();
+    }
+    contextGlobals.clear();
+
+    return true;
+}
+
+std::optional<VCL::InstanceContextLayout> VCL::InstanceContextLayout::Get(const llvm::Module& module) {
+    llvm::NamedMDNode* layoutMD = module.getNamedMetadata(LayoutMetadataName);
+    if (!layoutMD || layoutMD->getNumOperands() != 1)
+        return {};
+
+    auto getInteger = [](const llvm::MDOperand& operand) -> uint64_t {
+        return llvm::mdconst::extract<llvm::ConstantInt>(operand)->getZExtValue();
+    };
+
+    InstanceContextLayout result{};
+    result.size = getInteger(layoutMD->getOperand(0)->getOperand(0));
+    result.alignment = getInteger(layoutMD->getOperand(0)->getOperand(1));
+
+    if (llvm::NamedMDNode* fieldsMD = module.getNamedMetadata(FieldsMetadataName); fieldsMD) {
+        for (llvm::MDNode* node : fieldsMD->operands()) {
+            llvm::StringRef direction = llvm::cast<llvm::MDString>(node->getOperand(1))->getString();
+            result.fields.push_back(Field{
+                llvm::cast<llvm::MDString>(node->getOperand(0))->getString().str(),
+                getInteger(node->getOperand(2)),
+                getInteger(node->getOperand(3)),
+                direction != "out",
+                direction != "in"
+            });
+        }
+    }
+
+    return result;
+}
\ No newline at end of file
@@ -0,0 +1,342 @@
+#include <VCL/CodeGen/CodeGenModule.hpp>
+
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/DerivedTypes.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Intrinsics.h>
+#include <llvm/ADT/ArrayRef.h>
+
+#include <string>
+
+
+namespace {
+
+    using IntrinsicID = VCL::FunctionDecl::IntrinsicID;
+
+    struct VectorMathFunction {
+        IntrinsicID id;
+        llvm::StringLiteral name;
+        uint32_t argCount;
+    };
+
+    constexpr VectorMathFunction vectorMathFunctions[] = {
+        { IntrinsicID::Sin, "sin", 1 },
+        { IntrinsicID::Cos, "cos", 1 },
+        { IntrinsicID::Tan, "tan", 1 },
+        { IntrinsicID::Exp, "exp", 1 },
+        { IntrinsicID::Exp2, "exp2", 1 },
+        { IntrinsicID::Log, "log", 1 },
+        { IntrinsicID::Log2, "log2", 1 },
+        { IntrinsicID::Log10, "log10", 1 },
+        { IntrinsicID::Pow, "pow", 2 },
+        { IntrinsicID::Tanh, "tanh", 1 }
+    };
+
+    // Coefficients from the highest degree down, mostly from Cephes single precision functions.
+    constexpr double sinCoefficients[] = { -1.9515295891e-4, 8.3321608736e-3, -1.6666654611e-1 };
+    constexpr double sinFastCoefficients[] = { 1.0 / 120.0, -1.0 / 6.0 };
+    constexpr double cosCoefficients[] = { 2.443315711809948e-5, -1.388731625493765e-3, 4.166664568298827e-2 };
+    constexpr double cosFastCoefficients[] = { -1.0 / 720.0, 1.0 / 24.0 };
+    constexpr double tanCoefficients[] = { 9.38540185543e-3, 3.11992232697e-3, 2.44301354525e-2,
+        5.34112807005e-2, 1.33387994085e-1, 3.33331568548e-1 };
+    constexpr double expCoefficients[] = { 1.9875691500e-4, 1.3981999507e-3, 8.3334519073e-3,
+        4.1665795894e-2, 1.6666665459e-1, 5.0000001201e-1 };
+    constexpr double expFastCoefficients[] = { 1.0 / 24.0, 1.0 / 6.0, 0.5 };
+    constexpr double exp2Coefficients[] = { 1.535336188319500e-4, 1.339887440266574e-3, 9.618437357674640e-3,
+        5.550332471162809e-2, 2.402264791363012e-1, 6.931472028550421e-1 };
+    constexpr double exp2FastCoefficients[] = { 9.61812910762848e-3, 5.55041086648216e-2, 2.40226506959101e-1, 6.93147180559945e-1 };
+    constexpr double logCoefficients[] = { 7.0376836292e-2, -1.1514610310e-1, 1.1676998740e-1, -1.2420140846e-1,
+        1.4249322787e-1, -1.6668057665e-1, 2.0000714765e-1, -2.4999993993e-1, 3.3333331174e-1 };
+    constexpr double logFastCoefficients[] = { -1.519133968610586e-1, 2.204782089682129e-1, -2.520393664112545e-1, 3.326412868111760e-1 };
+    constexpr double tanhCoefficients[] = { -5.70498872745e-3, 2.06390887954e-2, -5.37397155531e-2, 1.33314422036e-1, -3.33332819422e-1 };
+
+    // pi / 2 and ln(2) split so the leading parts multiplied by a small integer are exact.
+    constexpr double PiOver2A = 1.5703125;
+    constexpr double PiOver2B = 4.837512969970703125e-4;
+    constexpr double PiOver2C = 7.549789948768648e-8;
+    constexpr double Ln2A = 0.693359375;
+    constexpr double Ln2B = -2.12194440e-4;
+    constexpr double Log2EMinus1 = 0.44269504088896340736;
+    constexpr double Log10EA = 0.43359375;
+    constexpr double Log10EB = 7.00731903251827651129e-4;
+    constexpr double Log10Of2A = 0.30078125;
+    constexpr double Log10Of2B = 2.48745663981195213739e-4;
+
+    /** Emit the float32 vector implementations, lane by lane identical to a scalar evaluation. */
+    class VectorMathBuilder {
+    public:
+        VectorMathBuilder(llvm::IRBuilder<>& builder, llvm::FixedVectorType* type, bool fast)
+            : builder{ builder }, type{ type }, intType{ llvm::VectorType::getInteger(type) }, fast{ fast } {}
+
+        llvm::Value* Sin(llvm::Value* x, bool cosine) {
+            auto [r, quadrant] = ReduceQuarterTurn(x);
+            if (cosine)
+                quadrant = builder.CreateAdd(quadrant, Int(1));
+            llvm::Value* r2 = builder.CreateFMul(r, r);
+            llvm::Value* s = MulAdd(builder.CreateFMul(r, r2), Polynomial(r2, ForAccuracy(sinCoefficients, sinFastCoefficients)), r);
+            llvm::Value* c = MulAdd(builder.CreateFMul(r2, r2), Polynomial(r2, ForAccuracy(cosCoefficients, cosFastCoefficients)),
+                MulAdd(r2, Constant(-0.5), Constant(1.0)));
+            // sin(r + k * pi / 2) is sin(r), cos(r), -sin(r), -cos(r).
+            llvm::Value* useCos = builder.CreateICmpNE(builder.CreateAnd(quadrant, Int(1)), Int(0));
+            llvm::Value* sign = builder.CreateShl(builder.CreateAnd(quadrant, Int(2)), Int(30));
+            return FlipSign(builder.CreateSelect(useCos, c, s), sign);
+        }
+
+        llvm::Value* Tan(llvm::Value* x) {
+            auto [r, quadrant] = ReduceQuarterTurn(x);
+            llvm::Value* r2 = builder.CreateFMul(r, r);
+            llvm::Value* t = MulAdd(builder.CreateFMul(r, r2), Polynomial(r2, tanCoefficients), r);
+            // tan(r + pi / 2) is -1 / tan(r).
+            llvm::Value* isOdd = builder.CreateICmpNE(builder.CreateAnd(quadrant, Int(1)), Int(0));
+            return builder.CreateSelect(isOdd, builder.CreateFDiv(Constant(-1.0), t), t);
+        }
+
+        llvm::Value* Exp(llvm::Value* x) {
+            x = Clamp(x, -104.0, 89.0);
+            llvm::Value* n = Round(builder.CreateFMul(x, Constant(1.44269504088896341)));
+            llvm::Value* r = MulAdd(n, Constant(-Ln2A), x);
+            r = MulAdd(n, Constant(-Ln2B), r);
+            llvm::Value* p = MulAdd(builder.CreateFMul(r, r), Polynomial(r, ForAccuracy(expCoefficients, expFastCoefficients)),
+                builder.CreateFAdd(r, Constant(1.0)));
+            return Scale(p, n);
+        }
+
+        llvm::Value* Exp2(llvm::Value* x) {
+            x = Clamp(x, -151.0, 129.0);
+            llvm::Value* n = Round(x);
+            return Scale(Exp2Fraction(builder.CreateFSub(x, n)), n);
+        }
+
+        llvm::Value* Log(llvm::Value* x) {
+            LogParts parts = ReduceLog(x, ForAccuracy(logCoefficients, logFastCoefficients));
+            llvm::Value* y = MulAdd(parts.e, Constant(Ln2B), parts.y);
+            y = MulAdd(parts.m2, Constant(-0.5), y);
+            llvm::Value* result = MulAdd(parts.e, Constant(Ln2A), builder.CreateFAdd(parts.m, y));
+            return LogSpecialCases(x, result);
+        }
+
+        llvm::Value* Log2(llvm::Value* x) {
+            LogParts parts = ReduceLog(x, ForAccuracy(logCoefficients, logFastCoefficients));
+            llvm::Value* result = builder.CreateFAdd(Log2Fraction(parts), parts.e);
+            return LogSpecialCases(x, result);
+        }
+
+        llvm::Value* Log10(llvm::Value* x) {
+            LogParts parts = ReduceLog(x, ForAccuracy(logCoefficients, logFastCoefficients));
+            llvm::Value* y = MulAdd(parts.m2, Constant(-0.5), parts.y);
+            // Terms accumulated from the smallest.
+            llvm::Value* result = builder.CreateFMul(builder.CreateFAdd(parts.m, y), Constant(Log10EB));
+            result = MulAdd(y, Constant(Log10EA), result);
+            result = MulAdd(parts.m, Constant(Log10EA), result);
+            result = MulAdd(parts.e, Constant(Log10Of2B), result);
+            result = MulAdd(parts.e, Constant(Log10Of2A), result);
+            return LogSpecialCases(x, result);
+        }
+
+        llvm::Value* Pow(llvm::Value* x, llvm::Value* y) {
+            llvm::Value* ax = builder.CreateUnaryIntrinsic(llvm::Intrinsic::fabs, x);
+            // Always the full polynomial, its error is multiplied by y.
+            LogParts parts = ReduceLog(ax, logCoefficients);
+
+            // y * log2(|x|) = y * e + y * log2(m), the exponent part is kept exact with its rounding error.
+            llvm::Value* ye = builder.CreateFMul(y, parts.e);
+            llvm::Value* yeError = builder.CreateIntrinsic(llvm::Intrinsic::fmuladd, { type }, { y, parts.e, builder.CreateFNeg(ye) });
+            llvm::Value* n = Round(ye);
+            llvm::Value* t = builder.CreateFAdd(builder.CreateFSub(ye, n), MulAdd(y, Log2Fraction(parts), yeError));
+            llvm::Value* n2 = Round(t);
+            llvm::Value* result = Scale(Exp2Fraction(builder.CreateFSub(t, n2)), Clamp(builder.CreateFAdd(n, n2), -151.0, 129.0));
+
+            llvm::Value* isYInteger = builder.CreateFCmpOEQ(Round(y), y);
+            llvm::Value* halfY = builder.CreateFMul(y, Constant(0.5));
+            llvm::Value* isYOdd = builder.CreateAnd(isYInteger, builder.CreateFCmpONE(Round(halfY), halfY));
+
+            llvm::Value* isZero = builder.CreateFCmpOEQ(ax, Constant(0.0));
+            llvm::Value* zeroResult = builder.CreateSelect(builder.CreateFCmpOLT(y, Constant(0.0)), Infinity(), Constant(0.0));
+            result = builder.CreateSelect(isZero, zeroResult, result);
+
+            // Negative bases only have a real power for integer exponents, negated when odd.
+            llvm::Value* isNegative = builder.CreateICmpSLT(builder.CreateBitCast(x, intType), Int(0));
+            llvm::Value* negativeResult = builder.CreateSelect(isYOdd, builder.CreateFNeg(result), result);
+            negativeResult = builder.CreateSelect(isYInteger, negativeResult, NaN());
+            result = builder.CreateSelect(isNegative, negativeResult, result);
+            // The bits of a NaN x read as a finite logarithm.
+            result = builder.CreateSelect(builder.CreateFCmpUNO(x, y), NaN(), result);
+
+            // pow(x, 0) and pow(1, y) are 1 even for a NaN operand.
+            llvm::Value* isOne = builder.CreateOr(builder.CreateFCmpOEQ(y, Constant(0.0)), builder.CreateFCmpOEQ(x, Constant(1.0)));
+            return builder.CreateSelect(isOne, Constant(1.0), result);
+        }
+
+        llvm::Value* Tanh(llvm::Value* x) {
+            llvm::Value* ax = builder.CreateUnaryIntrinsic(llvm::Intrinsic::fabs, x);
+            llvm::Value* x2 = builder.CreateFMul(x, x);
+            llvm::Value* small = MulAdd(builder.CreateFMul(x, x2), Polynomial(x2, tanhCoefficients), x);
+            // 1 - 2 / (e^2|x| + 1), exp overflow to infinity give 1.
+            llvm::Value* e = Exp(builder.CreateFAdd(ax, ax));
+            llvm::Value* large = builder.CreateFSub(Constant(1.0), builder.CreateFDiv(Constant(2.0), builder.CreateFAdd(e, Constant(1.0))));
+            large = builder.CreateBinaryIntrinsic(llvm::Intrinsic::copysign, large, x);
+            return builder.CreateSelect(builder.CreateFCmpOLT(ax, Constant(0.625)), small, large);
+        }
+
+    private:
+        /** x = m + e * ln(2), with 1 + m in [sqrt(0.5), sqrt(2)), y the polynomial part of log(1 + m) less -m2 / 2. */
+        struct LogParts {
+            llvm::Value* m;
+            llvm::Value* m2;
+            llvm::Value* y;
+            llvm::Value* e;
+        };
+
+        llvm::Value* Constant(double value) { return llvm::ConstantFP::get(type, value); }
+        llvm::Value* Int(int32_t value) { return llvm::ConstantInt::get(intType, value, true); }
+        llvm::Value* Infinity() { return llvm::ConstantFP::getInfinity(type); }
+        llvm::Value* NaN() { return llvm::ConstantFP::getNaN(type); }
+
+        llvm::Value* MulAdd(llvm::Value* a, llvm::Value* b, llvm::Value* c) {
+            return builder.CreateIntrinsic(llvm::Intrinsic::fmuladd, { type }, { a, b, c });
+        }
+
+        llvm::ArrayRef<double> ForAccuracy(llvm::ArrayRef<double> coefficients, llvm::ArrayRef<double> fastCoefficients) {
+            return fast ? fastCoefficients : coefficients;
+        }
+
+        llvm::Value* Polynomial(llvm::Value* x, llvm::ArrayRef<double> coefficients) {
+            llvm::Value* result = Constant(coefficients[0]);
+            for (double coefficient : coefficients.drop_front())
+                result = MulAdd(result, x, Constant(coefficient));
+            return result;
+        }
+
+        llvm::Value* Round(llvm::Value* x) {
+            return builder.CreateUnaryIntrinsic(llvm::Intrinsic::rint, x);
+        }
+
+        /** NaN stays NaN, unlike with maxnum / minnum which return the other operand. */
+        llvm::Value* Clamp(llvm::Value* x, double low, double high) {
+            x = builder.CreateBinaryIntrinsic(llvm::Intrinsic::maximum, x, Constant(low));
+            return builder.CreateBinaryIntrinsic(llvm::Intrinsic::minimum, x, Constant(high));
+        }
+
+        /** Integral x to int32, NaN and out of range values give a defined (but meaningless) result instead of poison. */
+        llvm::Value* ToInt(llvm::Value* x) {
+            x = builder.CreateSelect(builder.CreateFCmpUNO(x, x), Constant(0.0), Clamp(x, -2147483648.0, 2147483520.0));
+            return builder.CreateFPToSI(x, intType);
+        }
+
+        llvm::Value* FlipSign(llvm::Value* x, llvm::Value* sign) {
+            return builder.CreateBitCast(builder.CreateXor(builder.CreateBitCast(x, intType), sign), type);
+        }
+
+        /** p * 2^n for an integral n in [-151, 129], in two steps so that neither power of two overflows. */
+        llvm::Value* Scale(llvm::Value* p, llvm::Value* n) {
+            llvm::Value* ni = ToInt(n);
+            llvm::Value* n1 = builder.CreateAShr(ni, Int(1));
+            llvm::Value* n2 = builder.CreateSub(ni, n1);
+            auto powerOf2 = [&](llvm::Value* exponent) {
+                return builder.CreateBitCast(builder.CreateShl(builder.CreateAdd(exponent, Int(127)), Int(23)), type);
+            };
+            return builder.CreateFMul(builder.CreateFMul(p, powerOf2(n1)), powerOf2(n2));
+        }
+
+        /** x = r + k * pi / 2 with r in [-pi / 4, pi / 4], accurate while k * PiOver2B is exact. */
+        std::pair<llvm::Value*, llvm::Value*> ReduceQuarterTurn(llvm::Value* x) {
+            llvm::Value* k = Round(builder.CreateFMul(x, Constant(0.63661977236758134)));
+            llvm::Value* r = MulAdd(k, Constant(-PiOver2A), x);
+            r = MulAdd(k, Constant(-PiOver2B), r);
+            r = MulAdd(k, Constant(-PiOver2C), r);
+            return { r, ToInt(k) };
+        }
+
+        /** 2^r for r in [-0.5, 0.5]. */
+        llvm::Value* Exp2Fraction(llvm::Value* r) {
+            return MulAdd(r, Polynomial(r, ForAccuracy(exp2Coefficients, exp2FastCoefficients)), Constant(1.0));
+        }
+
+        LogParts ReduceLog(llvm::Value* x, llvm::ArrayRef<double> coefficients) {
+            // Subnormals are brought in the normal range first.
+            llvm::Value* isSubnormal = builder.CreateFCmpOLT(x, Constant(1.17549435e-38));
+            x = builder.CreateSelect(isSubnormal, builder.CreateFMul(x, Constant(8388608.0)), x);
+            llvm::Value* bits = builder.CreateBitCast(x, intType);
+            llvm::Value* e = builder.CreateSub(builder.CreateLShr(bits, Int(23)), Int(126));
+            e = builder.CreateSub(e, builder.CreateSelect(isSubnormal, Int(23), Int(0)));
+            // Mantissa in [0.5, 1), doubled below sqrt(0.5).
+            llvm::Value* m = builder.CreateBitCast(builder.CreateOr(builder.CreateAnd(bits, Int(0x007fffff)), Int(0x3f000000)), type);
+            llvm::Value* isSmall = builder.CreateFCmpOLT(m, Constant(0.707106781186547524));
+            e = builder.CreateSub(e, builder.CreateZExt(isSmall, intType));
+            m = builder.CreateFSub(builder.CreateSelect(isSmall, builder.CreateFAdd(m, m), m), Constant(1.0));
+
+            llvm::Value* m2 = builder.CreateFMul(m, m);
+            llvm::Value* y = builder.CreateFMul(builder.CreateFMul(m, m2), Polynomial(m, coefficients));
+            return { m, m2, y, builder.CreateSIToFP(e, type) };
+        }
+
+        /** log2(1 + m), accumulated from the smallest term. */
+        llvm::Value* Log2Fraction(const LogParts& parts) {
+            llvm::Value* y = MulAdd(parts.m2, Constant(-0.5), parts.y);
+            llvm::Value* result = builder.CreateFMul(y, Constant(Log2EMinus1));
+            result = MulAdd(parts.m, Constant(Log2EMinus1), result);
+            result = builder.CreateFAdd(result, y);
+            return builder.CreateFAdd(result, parts.m);
+        }
+
+        llvm::Value* LogSpecialCases(llvm::Value* x, llvm::Value* result) {
+            result = builder.CreateSelect(builder.CreateFCmpOEQ(x, Constant(0.0)), builder.CreateFNeg(Infinity()), result);
+            result = builder.CreateSelect(builder.CreateFCmpOEQ(x, Infinity()), Infinity(), result);
+            return builder.CreateSelect(builder.CreateFCmpULT(x, Constant(0.0)), NaN(), result);
+        }
+
+    private:
+        llvm::IRBuilder<>& builder;
+        llvm::FixedVectorType* type;
+        llvm::VectorType* intType;
+        bool fast;
+    };
+
+}
+
+llvm::Function* VCL::CodeGenModule::GetVectorMathFunction(FunctionDecl::IntrinsicID id, llvm::Type* type, MathAccuracy accuracy) {
+    llvm::FixedVectorType* vectorType = llvm::dyn_cast<llvm::FixedVectorType>(type);
+    if (accuracy == MathAccuracy::Libm || !vectorType || !vectorType->getElementType()->isFloatTy())
+        return nullptr;
+
+    const VectorMathFunction* mathFunction = nullptr;
+    for (const VectorMathFunction& candidate : vectorMathFunctions)
+        if (candidate.id == id)
+            mathFunction = &candidate;
+    if (!mathFunction)
+        return nullptr;
+
+    // One definition per module, shared by every call and inlined by the optimizer.
+    std::string name = "vcl.math." + mathFunction->name.str() + "." + GetMathAccuracyName(accuracy).str() +
+        ".v" + std::to_string(vectorType->getNumElements()) + "f32";
+    if (llvm::Function* function = module.getFunction(name))
+        return function;
+
+    llvm::SmallVector<llvm::Type*> paramsType(mathFunction->argCount, type);
+    llvm::Function* function = llvm::Function::Create(llvm::FunctionType::get(type, paramsType, false),
+        llvm::GlobalValue::InternalLinkage, name, module);
+    function->setDoesNotAccessMemory();
+    function->setDoesNotThrow();
+    function->addFnAttr(llvm::Attribute::AlwaysInline);
+
+    llvm::IRBuilder<> builder{ llvm::BasicBlock::Create(GetLLVMContext(), "entry", function) };
+    VectorMathBuilder mathBuilder{ builder, vectorType, accuracy == MathAccuracy::Fast };
+    llvm::Value* x = function->getArg(0);
+    llvm::Value* result = nullptr;
+    switch (id) {
+        case FunctionDecl::IntrinsicID::Sin: result = mathBuilder.Sin(x, false); break;
+        case FunctionDecl::IntrinsicID::Cos: result = mathBuilder.Sin(x, true); break;
+        case FunctionDecl::IntrinsicID::Tan: result = mathBuilder.Tan(x); break;
+        case FunctionDecl::IntrinsicID::Exp: result = mathBuilder.Exp(x); break;
+        case FunctionDecl::IntrinsicID::Exp2: result = mathBuilder.Exp2(x); break;
+        case FunctionDecl::IntrinsicID::Log: result = mathBuilder.Log(x); break;
+        case FunctionDecl::IntrinsicID::Log2: result = mathBuilder.Log2(x); break;
+        case FunctionDecl::IntrinsicID::Log10: result = mathBuilder.Log10(x); break;
+        case FunctionDecl::IntrinsicID::Pow: result = mathBuilder.Pow(x, function->getArg(1)); break;
+        case FunctionDecl::IntrinsicID::Tanh: result = mathBuilder.Tanh(x); break;
+        default: break;
+    }
+    builder.CreateRet(result);
+
+    return function;
+}
\ No newline at end of file
@@ -0,0 +1,260 @@
+#include <VCL/CodeGen/CodeGenModule.hpp>
+
+#include <VCL/AST/TypePrinter.hpp>
+#include <VCL/CodeGen/Reflection.hpp>
+
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/DerivedTypes.h>
+#include <llvm/IR/Metadata.h>
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/STLExtras.h>
+
+#include <algorithm>
+#include <cctype>
+
+
+namespace {
+
+    using TypeInfo = VCL::ModuleReflection::TypeInfo;
+
+    constexpr std::pair<llvm::StringLiteral, TypeInfo::Kind> kindNames[] = {
+        { "scalar", TypeInfo::Kind::Scalar },
+        { "vector", TypeInfo::Kind::Vector },
+        { "lanes", TypeInfo::Kind::Lanes },
+        { "array", TypeInfo::Kind::Array },
+        { "span", TypeInfo::Kind::Span },
+        { "record", TypeInfo::Kind::Record }
+    };
+
+    bool IsIdentifierChar(char c) {
+        return std::isalnum((unsigned char)c) || c == '_';
+    }
+
+    uint64_t GetInteger(const llvm::MDOperand& operand) {
+        return llvm::mdconst::extract<llvm::ConstantInt>(operand)->getZExtValue();
+    }
+
+    /** Type nodes are uniqued by LLVM, each one is read once and shared by every symbol using it. */
+    const TypeInfo* ReadTypeInfo(const llvm::MDNode* node, std::vector<std::unique_ptr<TypeInfo>>& types,
+            llvm::DenseMap<const llvm::MDNode*, const TypeInfo*>& typeInfos) {
+        if (auto it = typeInfos.find(node); it != typeInfos.end())
+            return it->second;
+
+        std::unique_ptr<TypeInfo> info = std::make_unique<TypeInfo>();
+        llvm::StringRef kind = llvm::cast<llvm::MDString>(node->getOperand(0))->getString();
+        for (auto& [name, value] : kindNames)
+            if (name == kind)
+                info->kind = value;
+        info->name = llvm::cast<llvm::MDString>(node->getOperand(1))->getString().str();
+        info->size = GetInteger(node->getOperand(2));
+        info->alignment = GetInteger(node->getOperand(3));
+        info->elementCount = GetInteger(node->getOperand(4));
+        info->stride = GetInteger(node->getOperand(5));
+        if (llvm::MDNode* elementNode = llvm::cast_or_null<llvm::MDNode>(node->getOperand(6).get()); elementNode)
+            info->elementType = ReadTypeInfo(elementNode, types, typeInfos);
+        for (const llvm::MDOperand& operand : llvm::cast<llvm::MDNode>(node->getOperand(7))->operands()) {
+            llvm::MDNode* fieldNode = llvm::cast<llvm::MDNode>(operand);
+            info->fields.push_back(TypeInfo::Field{
+                llvm::cast<llvm::MDString>(fieldNode->getOperand(0))->getString().str(),
+                GetInteger(fieldNode->getOperand(1)),
+                ReadTypeInfo(llvm::cast<llvm::MDNode>(fieldNode->getOperand(2)), types, typeInfos)
+            });
+        }
+
+        const TypeInfo* result = info.get();
+        types.push_back(std::move(info));
+        typeInfos.insert({ node, result });
+        return result;
+    }
+
+}
+
+bool VCL::CodeGenModule::EmitReflection() {
+    llvm::LLVMContext& context = GetLLVMContext();
+
+    // In/out variables of this module and the imported ones it use, sorted for a stable output.
+    llvm::SmallVector<std::pair<VarDecl*, llvm::GlobalVariable*>> variables{};
+    for (auto& [decl, gv] : globals) {
+        if (decl->GetDeclClass() != Decl::VarDeclClass)
+            continue;
+        VarDecl* varDecl = (VarDecl*)decl;
+        if (varDecl->HasInAttribute() || varDecl->HasOutAttribute())
+            variables.push_back({ varDecl, (llvm::GlobalVariable*)gv });
+    }
+    llvm::sort(variables, [](auto& a, auto& b) { return a.second->getName() < b.second->getName(); });
+
+    llvm::NamedMDNode* reflectionMD = module.getOrInsertNamedMetadata(ModuleReflection::MetadataName);
+    for (auto& [decl, gv] : variables) {
+        llvm::MDNode* typeMD = GenerateTypeReflection(decl->GetValueType());
+        if (!typeMD)
+            return false;
+        llvm::StringRef direction = decl->HasInoutAttribute() ? "inout" : (decl->HasInAttribute() ? "in" : "out");
+        reflectionMD->addOperand(llvm::MDNode::get(context, {
+            llvm::MDString::get(context, decl->GetIdentifierInfo()->GetName()),
+            llvm::MDString::get(context, direction),
+            typeMD
+        }));
+    }
+
+    return true;
+}
+
+llvm::MDNode* VCL::CodeGenModule::GenerateTypeReflection(QualType type) {
+    llvm::LLVMContext& context = GetLLVMContext();
+    const llvm::DataLayout& layout = module.getDataLayout();
+    llvm::Type* i64 = llvm::Type::getInt64Ty(context);
+
+    llvm::Type* llvmType = cgt.ConvertType(type);
+    if (!llvmType)
+        return nullptr;
+
+    Type* canonicalType = Type::GetCanonicalType(type.GetType());
+    llvm::StringRef kind;
+    QualType elementType{};
+    uint64_t elementCount = 0;
+    uint64_t stride = 0;
+    llvm::SmallVector<llvm::Metadata*> fields{};
+
+    switch (canonicalType->GetTypeClass()) {
+        case Type::BuiltinTypeClass:
+            kind = "scalar";
+            break;
+        case Type::VectorTypeClass: {
+            kind = "vector";
+            elementType = ((VectorType*)canonicalType)->GetElementType();
+            llvm::FixedVectorType* vectorType = llvm::cast<llvm::FixedVectorType>(llvmType);
+            elementCount = vectorType->getNumElements();
+            // Vectors are packed, lanes of Vec<bool> are bits and can't be addressed.
+            uint64_t elementBits = layout.getTypeSizeInBits(vectorType->getElementType());
+            stride = elementBits % 8 == 0 ? elementBits / 8 : 0;
+            break;
+        }
+        case Type::LanesTypeClass:
+        case Type::ArrayTypeClass: {
+            bool isLanes = canonicalType->GetTypeClass() == Type::LanesTypeClass;
+            kind = isLanes ? "lanes" : "array";
+            elementType = isLanes ? ((LanesType*)canonicalType)->GetElementType() : ((ArrayType*)canonicalType)->GetElementType();
+            llvm::ArrayType* arrayType = llvm::cast<llvm::ArrayType>(llvmType);
+            elementCount = arrayType->getNumElements();
+            stride = layout.getTypeAllocSize(arrayType->getElementType());
+            break;
+        }
+        case Type::SpanTypeClass: {
+            kind = "span";
+            elementType = ((SpanType*)canonicalType)->GetElementType();
+            llvm::Type* llvmElementType = cgt.ConvertType(elementType);
+            if (!llvmElementType)
+                return nullptr;
+            stride = layout.getTypeAllocSize(llvmElementType);
+            break;
+        }
+        case Type::RecordTypeClass: {
+            kind = "record";
+            RecordDecl* decl = ((RecordType*)canonicalType)->GetRecordDecl();
+            const llvm::StructLayout* structLayout = layout.getStructLayout(llvm::cast<llvm::StructType>(llvmType));
+            unsigned index = 0;
+            for (auto it = decl->Begin(); it != decl->End(); ++it) {
+                if (it->GetDeclClass() != Decl::FieldDeclClass)
+                    continue;
+                FieldDecl* fieldDecl = (FieldDecl*)it.Get();
+                llvm::MDNode* fieldTypeMD = GenerateTypeReflection(fieldDecl->GetType());
+                if (!fieldTypeMD)
+                    return nullptr;
+                fields.push_back(llvm::MDNode::get(context, {
+                    llvm::MDString::get(context, fieldDecl->GetIdentifierInfo()->GetName()),
+                    llvm::ConstantAsMetadata::get(llvm::ConstantInt::get(i64, structLayout->getElementOffset(index++))),
+                    fieldTypeMD
+                }));
+            }
+            break;
+        }
+        default:
+            diagnosticReporter.Error(Diagnostic::InternalError)
+                .SetCompilerInfo(__FILE__, __func__, __LINE__)
+                .Report();
+            return nullptr;
+    }
+
+    llvm::MDNode* elementMD = nullptr;
+    if (elementType.GetType()) {
+        elementMD = GenerateTypeReflection(elementType);
+        if (!elementMD)
+            return nullptr;
+    }
+
+    return llvm::MDNode::get(context, {
+        llvm::MDString::get(context, kind),
+        llvm::MDString::get(context, TypePrinter::Print(QualType{ type.GetType() })),
+        llvm::ConstantAsMetadata::get(llvm::ConstantInt::get(i64, layout.getTypeAllocSize(llvmType))),
+        llvm::ConstantAsMetadata::get(llvm::ConstantInt::get(i64, layout.getABITypeAlign(llvmType).value())),
+        llvm::ConstantAsMetadata::get(llvm::ConstantInt::get(i64, elementCount)),
+        llvm::ConstantAsMetadata::get(llvm::ConstantInt::get(i64, stride)),
+        elementMD,
+        llvm::MDTuple::get(context, fields)
+    });
+}
+
+std::optional<VCL::ModuleReflection> VCL::ModuleReflection::Get(const llvm::Module& module) {
+    llvm::NamedMDNode* reflectionMD = module.getNamedMetadata(MetadataName);
+    if (!reflectionMD)
+        return {};
+
+    ModuleReflection result{};
+    llvm::DenseMap<const llvm::MDNode*, const TypeInfo*> typeInfos{};
+    for (llvm::MDNode* node : reflectionMD->operands()) {
+        // Imported modules linked in bring their own copy of the symbols they share with this one.
+        llvm::StringRef name = llvm::cast<llvm::MDString>(node->getOperand(0))->getString();
+        if (result.GetSymbol(name))
+            continue;
+        llvm::StringRef direction = llvm::cast<llvm::MDString>(node->getOperand(1))->getString();
+        result.symbols.push_back(Symbol{
+            name.str(),
+            ReadTypeInfo(llvm::cast<llvm::MDNode>(node->getOperand(2)), result.types, typeInfos),
+            direction != "out",
+            direction != "in"
+        });
+    }
+
+    return result;
+}
+
+std::optional<uint64_t> VCL::ModuleReflection::GetOffset(llvm::StringRef path, const TypeInfo** type) const {
+    size_t nameLength = std::find_if_not(path.begin(), path.end(), IsIdentifierChar) - path.begin();
+    const Symbol* symbol = GetSymbol(path.take_front(nameLength));
+    if (!symbol)
+        return {};
+    return symbol->type->GetOffset(path.drop_front(nameLength), type);
+}
+
+std::optional<uint64_t> VCL::ModuleReflection::TypeInfo::GetOffset(llvm::StringRef path, const TypeInfo** type) const {
+    const TypeInfo* current = this;
+    uint64_t offset = 0;
+    // The leading field may be named without a dot.
+    bool isField = !path.empty() && IsIdentifierChar(path.front());
+    while (!path.empty()) {
+        if (isField || path.consume_front(".")) {
+            size_t length = std::find_if_not(path.begin(), path.end(), IsIdentifierChar) - path.begin();
+            const Field* field = current->GetField(path.take_front(length));
+            if (!field)
+                return {};
+            path = path.drop_front(length);
+            offset += field->offset;
+            current = field->type;
+        } else if (path.consume_front("[")) {
+            uint64_t index;
+            if (path.consumeInteger(10, index) || !path.consume_front("]"))
+                return {};
+            if (current->kind == Kind::Span || index >= current->elementCount || current->stride == 0)
+                return {};
+            offset += current->GetElementOffset(index);
+            current = current->elementType;
+        } else {
+            return {};
+        }
+        isField = false;
+    }
+
+    if (type)
+        *type = current;
+    return offset;
+}
\ No newline at end of file
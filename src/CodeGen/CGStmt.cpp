@@ -2,6 +2,17 @@
 
 #include <VCL/CodeGen/CodeGenModule.hpp>
 
+#include <llvm/IR/CFG.h>
+
+
+namespace {
+
+    bool IsVaryingCondition(VCL::Expr* condition) {
+        return condition && VCL::Type::GetCanonicalType(condition->GetResultType().GetType())->GetTypeClass() == VCL::Type::VectorTypeClass;
+    }
+
+}
+
 
 bool VCL::CodeGenFunction::GenerateStmt(Stmt* stmt) {
     switch (stmt->GetStmtClass()) {
@@ -41,6 +52,13 @@ bool VCL::CodeGenFunction::GenerateCompoundStmt(CompoundStmt* stmt) {
 }
 
 bool VCL::CodeGenFunction::GenerateReturnStmt(ReturnStmt* stmt) {
+    if (mask != entryMask) {
+        cgm.GetDiagnosticReporter().Error(Diagnostic::VaryingReturn)
+            .AddHint(DiagnosticHint{ stmt->GetSourceRange() })
+            .SetCompilerInfo(__FILE__, __func__, __LINE__)
+            .Report();
+        return false;
+    }
     if (stmt->GetExpr()) {
         llvm::Value* value = GenerateExpr(stmt->GetExpr());
         if (!value)
@@ -56,6 +74,8 @@ bool VCL::CodeGenFunction::GenerateIfStmt(IfStmt* stmt) {
     llvm::Value* condition = GenerateExpr(stmt->GetCondition());
     if (!condition)
         return false;
+    if (IsVaryingCondition(stmt->GetCondition()))
+        return GenerateVaryingIfStmt(stmt, condition);
     
     llvm::BasicBlock* thenBB = llvm::BasicBlock::Create(cgm.GetLLVMContext(), "then", function);
     llvm::BasicBlock* elseBB = llvm::BasicBlock::Create(cgm.GetLLVMContext(), "else", function);
@@ -80,6 +100,9 @@ bool VCL::CodeGenFunction::GenerateIfStmt(IfStmt* stmt) {
 }
 
 bool VCL::CodeGenFunction::GenerateWhileStmt(WhileStmt* stmt) {
+    if (IsVaryingCondition(stmt->GetCondition()))
+        return GenerateVaryingLoop(stmt->GetCondition(), nullptr, stmt->GetThenStmt());
+
     llvm::BasicBlock* conditionBB = llvm::BasicBlock::Create(cgm.GetLLVMContext(), "while", function);
     llvm::BasicBlock* thenBB = llvm::BasicBlock::Create(cgm.GetLLVMContext(), "loop", function);
     llvm::BasicBlock* endBB = llvm::BasicBlock::Create(cgm.GetLLVMContext(), "end", function);
@@ -114,6 +137,8 @@ bool VCL::CodeGenFunction::GenerateForStmt(ForStmt* stmt) {
     if (stmt->GetStartStmt())
         if (!GenerateStmt(stmt->GetStartStmt()))
             return false;
+    if (IsVaryingCondition(stmt->GetCondition()))
+        return GenerateVaryingLoop(stmt->GetCondition(), stmt->GetLoopExpr(), stmt->GetThenStmt());
 
     llvm::BasicBlock* conditionBB = llvm::BasicBlock::Create(cgm.GetLLVMContext(), "for", function);
     llvm::BasicBlock* thenBB = llvm::BasicBlock::Create(cgm.GetLLVMContext(), "loop", function);
@@ -157,13 +182,120 @@ bool VCL::CodeGenFunction::GenerateForStmt(ForStmt* stmt) {
 }
 
 bool VCL::CodeGenFunction::GenerateBreakStmt(BreakStmt* stmt) {
+    if (loopMaskStack.back() != mask) {
+        cgm.GetDiagnosticReporter().Error(Diagnostic::VaryingLoopJump, "break")
+            .AddHint(DiagnosticHint{ stmt->GetSourceRange() })
+            .SetCompilerInfo(__FILE__, __func__, __LINE__)
+            .Report();
+        return false;
+    }
     llvm::BasicBlock* breakBB = breakBBStack.back();
     builder.CreateBr(breakBB);
     return true;
 }
 
 bool VCL::CodeGenFunction::GenerateContinueStmt(ContinueStmt* stmt) {
+    if (loopMaskStack.back() != mask) {
+        cgm.GetDiagnosticReporter().Error(Diagnostic::VaryingLoopJump, "continue")
+            .AddHint(DiagnosticHint{ stmt->GetSourceRange() })
+            .SetCompilerInfo(__FILE__, __func__, __LINE__)
+            .Report();
+        return false;
+    }
     llvm::BasicBlock* continueBB = continueBBStack.back();
     builder.CreateBr(continueBB);
     return true;
+}
+
+bool VCL::CodeGenFunction::GenerateVaryingIfStmt(IfStmt* stmt, llvm::Value* condition) {
+    // Both branches run one after the other, each with the lanes taking it, and are skipped when none does.
+    llvm::Value* outerMask = mask;
+    llvm::Value* thenMask = outerMask ? builder.CreateAnd(outerMask, condition) : condition;
+
+    llvm::BasicBlock* thenBB = llvm::BasicBlock::Create(cgm.GetLLVMContext(), "varying_then", function);
+    llvm::BasicBlock* elseTestBB = llvm::BasicBlock::Create(cgm.GetLLVMContext(), "varying_else_test", function);
+    llvm::BasicBlock* endBB = llvm::BasicBlock::Create(cgm.GetLLVMContext(), "varying_end", function);
+
+    builder.CreateCondBr(builder.CreateOrReduce(thenMask), thenBB, elseTestBB);
+    builder.SetInsertPoint(thenBB);
+    mask = thenMask;
+    bool s = GenerateStmt(stmt->GetThenStmt());
+    mask = outerMask;
+    if (!s)
+        return false;
+    if (!builder.GetInsertBlock()->getTerminator())
+        builder.CreateBr(elseTestBB);
+
+    builder.SetInsertPoint(elseTestBB);
+    if (stmt->GetElseStmt()) {
+        llvm::Value* elseMask = builder.CreateNot(condition);
+        if (outerMask)
+            elseMask = builder.CreateAnd(outerMask, elseMask);
+        llvm::BasicBlock* elseBB = llvm::BasicBlock::Create(cgm.GetLLVMContext(), "varying_else", function);
+        builder.CreateCondBr(builder.CreateOrReduce(elseMask), elseBB, endBB);
+        builder.SetInsertPoint(elseBB);
+        mask = elseMask;
+        s = GenerateStmt(stmt->GetElseStmt());
+        mask = outerMask;
+        if (!s)
+            return false;
+    }
+    if (!builder.GetInsertBlock()->getTerminator())
+        builder.CreateBr(endBB);
+
+    builder.SetInsertPoint(endBB);
+    return true;
+}
+
+bool VCL::CodeGenFunction::GenerateVaryingLoop(Expr* condition, Expr* loopExpr, Stmt* thenStmt) {
+    // Lanes leave the loop as soon as their condition is false, it runs as long as any lane remains.
+    llvm::Value* outerMask = mask;
+    llvm::Type* maskType = cgm.GetCGT().ConvertType(condition->GetResultType());
+    llvm::BasicBlock* entryBB = builder.GetInsertBlock();
+
+    llvm::BasicBlock* conditionBB = llvm::BasicBlock::Create(cgm.GetLLVMContext(), "varying_loop", function);
+    llvm::BasicBlock* thenBB = llvm::BasicBlock::Create(cgm.GetLLVMContext(), "varying_loop_body", function);
+    llvm::BasicBlock* loopExprBB = llvm::BasicBlock::Create(cgm.GetLLVMContext(), "varying_loop_expr", function);
+    llvm::BasicBlock* endBB = llvm::BasicBlock::Create(cgm.GetLLVMContext(), "varying_loop_end", function);
+
+    builder.CreateBr(conditionBB);
+    builder.SetInsertPoint(conditionBB);
+
+    llvm::PHINode* loopMask = builder.CreatePHI(maskType, 2, "loop_mask");
+    loopMask->addIncoming(outerMask ? outerMask : llvm::Constant::getAllOnesValue(maskType), entryBB);
+    mask = loopMask;
+    llvm::Value* conditionValue = GenerateExpr(condition);
+    if (!conditionValue) {
+        mask = outerMask;
+        return false;
+    }
+    mask = builder.CreateAnd(loopMask, conditionValue);
+    builder.CreateCondBr(builder.CreateOrReduce(mask), thenBB, endBB);
+
+    builder.SetInsertPoint(thenBB);
+
+    PushBreakBB(endBB);
+    PushContinueBB(loopExprBB);
+    bool s = GenerateStmt(thenStmt);
+    PopContinueBB();
+    PopBreakBB();
+
+    if (s && !builder.GetInsertBlock()->getTerminator())
+        builder.CreateBr(loopExprBB);
+    builder.SetInsertPoint(loopExprBB);
+    if (s && loopExpr)
+        s = GenerateExpr(loopExpr) != nullptr;
+    llvm::Value* activeMask = mask;
+    mask = outerMask;
+    if (!s)
+        return false;
+    builder.CreateBr(conditionBB);
+
+    // Every lane still active at the end of an iteration, or continuing, test the condition again.
+    for (llvm::BasicBlock* predecessor : llvm::predecessors(conditionBB))
+        if (predecessor != entryBB)
+            loopMask->addIncoming(activeMask, predecessor);
+
+    builder.SetInsertPoint(endBB);
+    return true;
 }
\ No newline at end of file
@@ -8,12 +8,17 @@
 
 
 VCL::CodeGenFunction::CodeGenFunction(CodeGenModule& cgm) 
-    : cgm{ cgm }, builder{ cgm.GetLLVMContext() }, locals{}, breakBBStack{}, continueBBStack{}, strictIEEE{ false } {
+    : cgm{ cgm }, builder{ cgm.GetLLVMContext() }, locals{}, breakBBStack{}, continueBBStack{}, loopMaskStack{}, mask{ nullptr }, entryMask{ nullptr }, strictIEEE{ false }, allowApproxFunc{ false } {
     
 }
 
-llvm::Function* VCL::CodeGenFunction::Generate(FunctionDecl* decl, bool imported) {
+llvm::Function* VCL::CodeGenFunction::Generate(FunctionDecl* decl, bool imported, bool masked) {
     llvm::FunctionType* functionType = cgm.GetCGT().ConvertFunctionType(QualType{ decl->GetType() });
+    if (masked) {
+        llvm::SmallVector<llvm::Type*> paramTypes{ functionType->param_begin(), functionType->param_end() };
+        paramTypes.push_back(llvm::FixedVectorType::get(llvm::Type::getInt1Ty(cgm.GetLLVMContext()), cgm.GetTarget().GetVectorWidthInElement()));
+        functionType = llvm::FunctionType::get(functionType->getReturnType(), paramTypes, false);
+    }
 
     AttributeDefinition* entryPointAD = cgm.GetAttributeTable().GetDefinition(
         cgm.GetIdentifierTable().Get("EntryPoint"));
@@ -26,18 +31,25 @@ llvm::Function* VCL::CodeGenFunction::Generate(FunctionDecl* decl, bool imported
         cgm.GetIdentifierTable().Get("AllowApproxFunctions"));
 
     strictIEEE = decl->HasAttribute(strictIEEEAD) != nullptr;
-    bool allowApproxFunc = decl->HasAttribute(allowApproxFuncAD) != nullptr;
+    allowApproxFunc = decl->HasAttribute(allowApproxFuncAD) != nullptr;
 
     ASTContext& context = imported ? cgm.GetImportedDeclModule(decl)->GetCompilerInstance()->GetASTContext() : cgm.GetASTContext();
     std::string functionName = decl->GetIdentifierInfo()->GetName().str();
 
     if (!decl->HasAttribute(noMangleAD) && !decl->HasAttribute(entryPointAD))
         functionName = Mangler::MangleFunctionDecl(context, decl);
+    if (masked)
+        functionName += ".masked";
 
     function = llvm::cast<llvm::Function>(cgm.GetLLVMModule().getOrInsertFunction(functionName, functionType).getCallee());
     function->setLinkage(llvm::GlobalValue::InternalLinkage);
 
-    if (decl->HasAttribute(entryPointAD)) {
+    if (masked) {
+        // Registered before the body is generated, so that a recursive call find it.
+        cgm.AddMaskedFunction(decl, function);
+        entryMask = function->getArg(function->arg_size() - 1);
+        entryMask->setName("mask");
+    } else if (decl->HasAttribute(entryPointAD)) {
         function->setLinkage(llvm::GlobalValue::ExternalLinkage);
         function->setDSOLocal(true);
     } else if (imported) {
@@ -57,6 +69,16 @@ llvm::Function* VCL::CodeGenFunction::Generate(FunctionDecl* decl, bool imported
         function->addFnAttr("approx-func-fp-math", "true");
     }
 
+    // Division and square root of float32 become a reciprocal (square root) estimate refined by one Newton step,
+    // within a few ULP with the x86 rcp and rsqrt.
+    llvm::FastMathFlags fastMathFlags{};
+    if (allowApproxFunc && !strictIEEE) {
+        function->addFnAttr("reciprocal-estimates", "divf:1,vec-divf:1,sqrtf:1,vec-sqrtf:1");
+        fastMathFlags.setApproxFunc();
+        fastMathFlags.setAllowReciprocal();
+    }
+    builder.setFastMathFlags(fastMathFlags);
+
     int i = 0;
     for (auto it = decl->Begin(); it != decl->End(); ++it) {
         if (it->GetDeclClass() == Decl::ParamDeclClass) {
@@ -66,11 +88,12 @@ llvm::Function* VCL::CodeGenFunction::Generate(FunctionDecl* decl, bool imported
         }
     }
 
-    if (decl->GetBody() == nullptr || (imported && !decl->HasFunctionFlag(FunctionDecl::IsTemplateSpecialization)))
+    if (decl->GetBody() == nullptr || (imported && !decl->HasFunctionFlag(FunctionDecl::IsTemplateSpecialization) && !cgm.GetEmitImportedDefinitions()))
         return function;
 
     llvm::BasicBlock* bb = llvm::BasicBlock::Create(cgm.GetLLVMContext(), "entry", function);
     builder.SetInsertPoint(bb);
+    mask = entryMask;
 
     i = 0;
     for (auto it = decl->Begin(); it != decl->End(); ++it) {
@@ -143,12 +166,37 @@ llvm::Value* VCL::CodeGenFunction::GetDeclValue(Decl* decl) {
     return cgm.GetGlobalDeclValue(decl);
 }
 
+llvm::Value* VCL::CodeGenFunction::GenerateLoad(llvm::Type* type, llvm::Value* ptr) {
+    // Inactive lanes may hold any index, they must not be read.
+    if (ptr->getType()->isVectorTy()) {
+        llvm::Align align = cgm.GetLLVMModule().getDataLayout().getABITypeAlign(type->getScalarType());
+        return builder.CreateMaskedGather(type, ptr, align, mask);
+    }
+    return builder.CreateLoad(type, ptr);
+}
+
+llvm::Instruction* VCL::CodeGenFunction::GenerateStore(llvm::Value* value, llvm::Value* ptr) {
+    // Lanes writing the same element are stored in order, the last one wins.
+    if (ptr->getType()->isVectorTy()) {
+        llvm::Align align = cgm.GetLLVMModule().getDataLayout().getABITypeAlign(value->getType()->getScalarType());
+        return builder.CreateMaskedScatter(value, ptr, align, mask);
+    }
+    // Inactive lanes keep their previous value, scalars are shared by every lane and always stored.
+    if (mask && value->getType()->isVectorTy()) {
+        llvm::Value* previous = builder.CreateLoad(value->getType(), ptr);
+        value = builder.CreateSelect(mask, value, previous);
+    }
+    return builder.CreateStore(value, ptr);
+}
+
 void VCL::CodeGenFunction::PushBreakBB(llvm::BasicBlock* breakBB) {
     breakBBStack.push_back(breakBB);
+    loopMaskStack.push_back(mask);
 }
 
 void VCL::CodeGenFunction::PopBreakBB() {
     breakBBStack.pop_back();
+    loopMaskStack.pop_back();
 }
 
 void VCL::CodeGenFunction::PushContinueBB(llvm::BasicBlock* continueBB) {
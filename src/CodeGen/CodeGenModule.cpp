@@ -19,6 +19,9 @@ VCL::CodeGenModule::CodeGenModule(llvm::Module& module, ASTContext& ast, Diagnos
 }
 
 bool VCL::CodeGenModule::LinkNow() {
+    if (emitImportedDefinitions)
+        return true;
+
     llvm::Linker linker{ module };
 
     for (auto module : importedModules) {
@@ -50,6 +53,17 @@ bool VCL::CodeGenModule::Emit(bool verifyModule) {
             return false;
     }
 
+    if (!EmitReflection())
+        return false;
+
+    for (auto& [decl, function] : blockEntryPoints) {
+        if (!EmitBlockEntryPoint(decl, function))
+            return false;
+    }
+
+    if (useInstanceContext && !LowerInstanceContext())
+        return false;
+
     if (verifyModule) {
         if (llvm::verifyModule(module, &llvm::errs())) {
             diagnosticReporter.Error(Diagnostic::InternalError)
@@ -104,8 +118,10 @@ bool VCL::CodeGenModule::EmitGlobalVarDecl(VarDecl* decl, bool imported) {
         isConstant = true;
     if (decl->HasInAttribute() || decl->HasOutAttribute())
         linkageType = llvm::GlobalVariable::LinkageTypes::ExternalLinkage;
-    else if (imported)
+    else if (imported && !emitImportedDefinitions)
         linkageType = llvm::GlobalVariable::LinkageTypes::ExternalLinkage;
+    else if (imported)
+        linkageType = llvm::GlobalVariable::LinkageTypes::InternalLinkage;
 
     std::string globalName = decl->GetIdentifierInfo()->GetName().str();
     if (linkageType != llvm::GlobalVariable::LinkageTypes::ExternalLinkage) {
@@ -121,7 +137,7 @@ bool VCL::CodeGenModule::EmitGlobalVarDecl(VarDecl* decl, bool imported) {
 
     llvm::GlobalVariable* gv = (llvm::GlobalVariable*)entry;
 
-    if (!decl->HasInAttribute() && !imported)
+    if (!decl->HasInAttribute() && (!imported || emitImportedDefinitions))
         gv->setInitializer(initializerValue);
     
     gv->setConstant(isConstant);
@@ -133,6 +149,9 @@ bool VCL::CodeGenModule::EmitGlobalVarDecl(VarDecl* decl, bool imported) {
 
     globals.insert(std::make_pair(decl, gv));
 
+    if (useInstanceContext && !imported && (decl->HasInAttribute() || decl->HasOutAttribute()))
+        contextGlobals.push_back(std::make_pair(decl, gv));
+
     return true;
 }
 
@@ -142,6 +161,9 @@ bool VCL::CodeGenModule::EmitFunctionDecl(FunctionDecl* decl, bool imported) {
     if (function == nullptr)
         return false;
     auto insertResult = globals.insert(std::make_pair(decl, function));
+    AttributeDefinition* blockAD = attributeTable.GetDefinition(identifierTable.Get("Block"));
+    if (!imported && decl->HasAttribute(blockAD))
+        blockEntryPoints.push_back(std::make_pair(decl, function));
     return insertResult.second;
 }
 
@@ -214,4 +236,22 @@ llvm::GlobalValue* VCL::CodeGenModule::GetGlobalDeclValue(Decl* decl) {
     }
 
     return nullptr;
+}
+
+llvm::Function* VCL::CodeGenModule::GetMaskedFunction(FunctionDecl* decl) {
+    if (auto it = maskedFunctions.find(decl); it != maskedFunctions.end())
+        return it->second;
+
+    // The masked function is generated here from the body, which may use what another module keeps to itself.
+    bool imported = IsDeclImported(decl);
+    if (!decl->GetBody() || (imported && !emitImportedDefinitions && !decl->HasFunctionFlag(FunctionDecl::IsTemplateSpecialization))) {
+        diagnosticReporter.Error(Diagnostic::VaryingCallUnavailable, decl->GetIdentifierInfo()->GetName().str())
+            .AddHint(DiagnosticHint{ decl->GetSourceRange() })
+            .SetCompilerInfo(__FILE__, __func__, __LINE__)
+            .Report();
+        return nullptr;
+    }
+
+    CodeGenFunction cgf{ *this };
+    return cgf.Generate(decl, imported, true);
 }
\ No newline at end of file
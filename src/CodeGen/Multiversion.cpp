@@ -0,0 +1,233 @@
+#include <VCL/CodeGen/Multiversion.hpp>
+
+#include <VCL/CodeGen/Reflection.hpp>
+
+#include <llvm/Linker/Linker.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/DerivedTypes.h>
+#include <llvm/IR/InlineAsm.h>
+#include <llvm/IR/IRBuilder.h>
+
+
+namespace {
+
+    // Each version must stay a subset of the features its CPU level check in EmitCPULevel.
+    constexpr VCL::TargetVersion versions[] = {
+        { "sse2", "x86-64", "+sse2" },
+        { "avx2", "x86-64", "+avx2,+fma" },
+        { "avx512", "x86-64", "+avx512f,+avx2,+fma" }
+    };
+
+}
+
+VCL::Multiversioner::Multiversioner(llvm::Module& module, DiagnosticReporter& diagnosticReporter)
+    : module{ module }, diagnosticReporter{ diagnosticReporter } {}
+
+llvm::ArrayRef<VCL::TargetVersion> VCL::Multiversioner::GetVersions() {
+    return versions;
+}
+
+bool VCL::Multiversioner::IsSupported(const llvm::Triple& triple) {
+    return triple.getArch() == llvm::Triple::x86_64;
+}
+
+bool VCL::Multiversioner::AddVersion(std::unique_ptr<llvm::Module> version, const TargetVersion& target, uint32_t vectorWidthInByte) {
+    const llvm::DataLayout& layout = version->getDataLayout();
+    std::string suffix = "." + target.name.str();
+
+    for (llvm::Function& function : *version) {
+        if (function.isDeclaration())
+            continue;
+        function.addFnAttr("target-cpu", target.cpu);
+        function.addFnAttr("target-features", target.features);
+        if (function.hasExternalLinkage()) {
+            std::string name = function.getName().str();
+            function.setName(name + suffix);
+            llvm::SmallVector<std::string>& names = entryPoints[name];
+            if (names.size() != vectorWidthsInByte.size()) {
+                diagnosticReporter.Error(Diagnostic::InternalError)
+                    .SetCompilerInfo(__FILE__, __func__, __LINE__)
+                    .Report();
+                return false;
+            }
+            names.push_back(function.getName().str());
+        }
+        // Imported functions are compiled again for each version, never merge them across versions.
+        if (!function.hasLocalLinkage())
+            function.setLinkage(llvm::GlobalValue::InternalLinkage);
+    }
+
+    // Vector variables are wider in the most capable versions, only the widest definition is kept.
+    for (llvm::GlobalVariable& global : version->globals()) {
+        if (global.isDeclaration())
+            continue;
+        if (!global.hasExternalLinkage()) {
+            global.setLinkage(llvm::GlobalValue::InternalLinkage);
+            continue;
+        }
+        uint64_t size = layout.getTypeAllocSize(global.getValueType());
+        auto [it, inserted] = globalDefinitions.insert({ global.getName().str(), GlobalDefinition{} });
+        if (inserted || it->second.size < size) {
+            it->second = GlobalDefinition{ global.getValueType(), global.getInitializer(), global.isConstant(), global.getAlign(), size };
+        }
+        global.setInitializer(nullptr);
+    }
+
+    // Vector sizes differ between versions, the host can't rely on any one layout.
+    if (llvm::NamedMDNode* reflectionMD = version->getNamedMetadata(ModuleReflection::MetadataName); reflectionMD)
+        version->eraseNamedMetadata(reflectionMD);
+
+    vectorWidthsInByte.push_back(vectorWidthInByte);
+
+    llvm::Linker linker{ module };
+    if (linker.linkInModule(std::move(version))) {
+        diagnosticReporter.Error(Diagnostic::InternalError)
+            .SetCompilerInfo(__FILE__, __func__, __LINE__)
+            .Report();
+        return false;
+    }
+    return true;
+}
+
+bool VCL::Multiversioner::EmitDispatchers() {
+    llvm::LLVMContext& context = module.getContext();
+    llvm::PointerType* ptrType = llvm::PointerType::getUnqual(context);
+    llvm::Type* i32 = llvm::Type::getInt32Ty(context);
+    llvm::IRBuilder<> builder{ context };
+
+    for (auto& [name, definition] : globalDefinitions) {
+        llvm::GlobalVariable* declaration = module.getNamedGlobal(name);
+        llvm::GlobalVariable* global = new llvm::GlobalVariable(module, definition.type, definition.isConstant,
+            llvm::GlobalValue::ExternalLinkage, definition.initializer);
+        global->setAlignment(definition.alignment);
+        if (declaration) {
+            global->takeName(declaration);
+            declaration->replaceAllUsesWith(global);
+            declaration->eraseFromParent();
+        } else {
+            global->setName(name);
+        }
+    }
+
+    llvm::Function* cpuLevel = EmitCPULevel();
+
+    // Pick the most capable version whose level is supported, levels are the index in GetVersions.
+    auto selectVersion = [&](llvm::Value* level, llvm::ArrayRef<llvm::Value*> values) {
+        llvm::Value* selected = values[0];
+        for (uint32_t i = 1; i < values.size(); ++i)
+            selected = builder.CreateSelect(builder.CreateICmpUGE(level, llvm::ConstantInt::get(i32, i)), values[i], selected);
+        return selected;
+    };
+
+    for (auto& [name, names] : entryPoints) {
+        llvm::SmallVector<llvm::Value*> functions{};
+        for (std::string& versionName : names) {
+            llvm::Function* function = module.getFunction(versionName);
+            if (!function || (!functions.empty() && function->getFunctionType() != ((llvm::Function*)functions[0])->getFunctionType())) {
+                diagnosticReporter.Error(Diagnostic::InternalError)
+                    .SetCompilerInfo(__FILE__, __func__, __LINE__)
+                    .Report();
+                return false;
+            }
+            functions.push_back(function);
+        }
+        if (functions.size() != vectorWidthsInByte.size()) {
+            diagnosticReporter.Error(Diagnostic::InternalError)
+                .SetCompilerInfo(__FILE__, __func__, __LINE__)
+                .Report();
+            return false;
+        }
+
+        llvm::FunctionType* type = ((llvm::Function*)functions[0])->getFunctionType();
+        llvm::Function* dispatcher = llvm::Function::Create(type, llvm::GlobalValue::ExternalLinkage, name, module);
+        dispatcher->setDSOLocal(true);
+        llvm::Function* resolver = llvm::Function::Create(type, llvm::GlobalValue::InternalLinkage, name + ".resolve", module);
+        llvm::GlobalVariable* slot = new llvm::GlobalVariable(module, ptrType, false,
+            llvm::GlobalValue::InternalLinkage, resolver, name + ".slot");
+        slot->setAlignment(llvm::Align{ 8 });
+
+        auto emitTailCall = [&](llvm::Function* caller, llvm::Value* callee) {
+            llvm::SmallVector<llvm::Value*> args{};
+            for (llvm::Argument& arg : caller->args())
+                args.push_back(&arg);
+            llvm::CallInst* call = builder.CreateCall(type, callee, args);
+            call->setTailCallKind(llvm::CallInst::TCK_MustTail);
+            if (type->getReturnType()->isVoidTy())
+                builder.CreateRetVoid();
+            else
+                builder.CreateRet(call);
+        };
+
+        // Every call go through the slot, which point to the resolver until the first call completes it.
+        builder.SetInsertPoint(llvm::BasicBlock::Create(context, "entry", dispatcher));
+        llvm::LoadInst* target = builder.CreateAlignedLoad(ptrType, slot, llvm::Align{ 8 });
+        target->setAtomic(llvm::AtomicOrdering::Acquire);
+        emitTailCall(dispatcher, target);
+
+        builder.SetInsertPoint(llvm::BasicBlock::Create(context, "entry", resolver));
+        llvm::Value* selected = selectVersion(builder.CreateCall(cpuLevel), functions);
+        builder.CreateAlignedStore(selected, slot, llvm::Align{ 8 })->setAtomic(llvm::AtomicOrdering::Release);
+        emitTailCall(resolver, selected);
+    }
+
+    llvm::Function* vectorWidth = llvm::Function::Create(llvm::FunctionType::get(i32, false),
+        llvm::GlobalValue::ExternalLinkage, "GetVectorWidthInElement", module);
+    vectorWidth->setDSOLocal(true);
+    builder.SetInsertPoint(llvm::BasicBlock::Create(context, "entry", vectorWidth));
+    llvm::SmallVector<llvm::Value*> widths{};
+    for (uint32_t widthInByte : vectorWidthsInByte)
+        widths.push_back(llvm::ConstantInt::get(i32, widthInByte / 4));
+    builder.CreateRet(selectVersion(builder.CreateCall(cpuLevel), widths));
+
+    return true;
+}
+
+llvm::Function* VCL::Multiversioner::EmitCPULevel() {
+    llvm::LLVMContext& context = module.getContext();
+    llvm::Type* i32 = llvm::Type::getInt32Ty(context);
+    llvm::StructType* cpuidType = llvm::StructType::get(context, { i32, i32, i32, i32 });
+    llvm::StructType* xgetbvType = llvm::StructType::get(context, { i32, i32 });
+
+    llvm::InlineAsm* cpuid = llvm::InlineAsm::get(llvm::FunctionType::get(cpuidType, { i32, i32 }, false),
+        "cpuid", "={ax},={bx},={cx},={dx},{ax},{cx},~{dirflag},~{fpsr},~{flags}", false);
+    llvm::InlineAsm* xgetbv = llvm::InlineAsm::get(llvm::FunctionType::get(xgetbvType, { i32 }, false),
+        "xgetbv", "={ax},={dx},{cx},~{dirflag},~{fpsr},~{flags}", false);
+
+    // uint32 vcl.cpu.level(), 0 for SSE2, 1 for AVX2 + FMA, 2 for AVX-512F, checking the OS save the wider registers.
+    llvm::Function* function = llvm::Function::Create(llvm::FunctionType::get(i32, false),
+        llvm::GlobalValue::InternalLinkage, "vcl.cpu.level", module);
+    llvm::BasicBlock* entryBB = llvm::BasicBlock::Create(context, "entry", function);
+    llvm::BasicBlock* xcr0BB = llvm::BasicBlock::Create(context, "xcr0", function);
+    llvm::BasicBlock* leaf7BB = llvm::BasicBlock::Create(context, "leaf7", function);
+    llvm::BasicBlock* baseBB = llvm::BasicBlock::Create(context, "base", function);
+
+    auto constant = [&](uint32_t value) { return llvm::ConstantInt::get(i32, value); };
+    auto hasBits = [&](llvm::IRBuilder<>& builder, llvm::Value* value, uint32_t bits) {
+        return builder.CreateICmpEQ(builder.CreateAnd(value, constant(bits)), constant(bits));
+    };
+
+    llvm::IRBuilder<> builder{ entryBB };
+    llvm::Value* maxLeaf = builder.CreateExtractValue(builder.CreateCall(cpuid, { constant(0), constant(0) }), 0);
+    llvm::Value* leaf1Ecx = builder.CreateExtractValue(builder.CreateCall(cpuid, { constant(1), constant(0) }), 2);
+    // FMA (12), OSXSAVE (27) and AVX (28).
+    llvm::Value* hasAVX = hasBits(builder, leaf1Ecx, (1u << 12) | (1u << 27) | (1u << 28));
+    llvm::Value* hasLeaf7 = builder.CreateICmpUGE(maxLeaf, constant(7));
+    builder.CreateCondBr(builder.CreateAnd(hasAVX, hasLeaf7), xcr0BB, baseBB);
+
+    builder.SetInsertPoint(xcr0BB);
+    llvm::Value* xcr0 = builder.CreateExtractValue(builder.CreateCall(xgetbv, { constant(0) }), 0);
+    // SSE and AVX state.
+    builder.CreateCondBr(hasBits(builder, xcr0, 0x6), leaf7BB, baseBB);
+
+    builder.SetInsertPoint(leaf7BB);
+    llvm::Value* leaf7Ebx = builder.CreateExtractValue(builder.CreateCall(cpuid, { constant(7), constant(0) }), 1);
+    llvm::Value* hasAVX2 = hasBits(builder, leaf7Ebx, 1u << 5);
+    // AVX-512F (16) along with opmask and ZMM state.
+    llvm::Value* hasAVX512 = builder.CreateAnd(hasBits(builder, leaf7Ebx, 1u << 16), hasBits(builder, xcr0, 0xE6));
+    builder.CreateRet(builder.CreateSelect(hasAVX512, constant(2), builder.CreateSelect(hasAVX2, constant(1), constant(0))));
+
+    builder.SetInsertPoint(baseBB);
+    builder.CreateRet(constant(0));
+
+    return function;
+}
\ No newline at end of file
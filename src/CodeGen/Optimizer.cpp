@@ -2,10 +2,19 @@
 
 #include <VCL/CodeGen/CodeGenModule.hpp>
 
+#include <llvm/Analysis/TargetLibraryInfo.h>
+#include <llvm/CodeGen/ReplaceWithVeclib.h>
 #include <llvm/Passes/PassBuilder.h>
+#include <llvm/TargetParser/Triple.h>
 
 
 bool VCL::Optimizer::Optimize(CodeGenModule& cgm) {
+    if (!cgm.LinkNow())
+        return false;
+    return Optimize(cgm.GetLLVMModule());
+}
+
+bool VCL::Optimizer::Optimize(llvm::Module& module) {
     llvm::LoopAnalysisManager lam{};
     llvm::FunctionAnalysisManager fam{};
     llvm::CGSCCAnalysisManager cgam{};
@@ -13,6 +22,14 @@ bool VCL::Optimizer::Optimize(CodeGenModule& cgm) {
 
     llvm::PassBuilder pb{};
 
+    // Registered before the default analyses, which then keep this one.
+    llvm::Triple triple{ module.getTargetTriple() };
+    llvm::TargetLibraryInfoImpl tlii{ triple };
+    if (vectorLibrary == VectorLibrary::Libmvec) {
+        tlii.addVectorizableFunctionsFromVecLib(llvm::TargetLibraryInfoImpl::LIBMVEC_X86, triple);
+        fam.registerPass([&tlii]() { return llvm::TargetLibraryAnalysis{ tlii }; });
+    }
+
     pb.registerModuleAnalyses(mam);
     pb.registerCGSCCAnalyses(cgam);
     pb.registerFunctionAnalyses(fam);
@@ -21,10 +38,10 @@ bool VCL::Optimizer::Optimize(CodeGenModule& cgm) {
     pb.crossRegisterProxies(lam, fam, cgam, mam);
 
     llvm::ModulePassManager mpm = pb.buildPerModuleDefaultPipeline(llvm::OptimizationLevel::O3);
+    // Vec<T> math is emitted as intrinsics on whole vectors, the vectorizer alone would never see it.
+    if (vectorLibrary == VectorLibrary::Libmvec)
+        mpm.addPass(llvm::createModuleToFunctionPassAdaptor(llvm::ReplaceWithVeclib{}));
 
-    if (!cgm.LinkNow())
-        return false;
-
-    mpm.run(cgm.GetLLVMModule(), mam);
+    mpm.run(module, mam);
     return true;
 }
\ No newline at end of file
@@ -7,4 +7,8 @@ void VCL::AttributeTable::AddDefaults(IdentifierTable& table) {
     AddDefinition(table.Get("NoMangle"), 0, 0);
     AddDefinition(table.Get("StrictIEEE"), 0, 0);
     AddDefinition(table.Get("AllowApproxFunctions"), 0, 0);
+    // [Block(advanced...)] add a '<EntryPoint>Block(count)' wrapper running the entry point count times. Every varying
+    // in/out, inputs included, then read or write a strided buffer whose address is stored in '<EntryPoint>Block.<name>',
+    // except the advanced inputs which move from their bound first value at every step.
+    AddDefinition(table.Get("Block"), 0, 8);
 }
\ No newline at end of file
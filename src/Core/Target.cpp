@@ -38,12 +38,18 @@ VCL::Target::Target(TargetOptions& options) {
     llvm::InitializeNativeTargetAsmPrinter();
     
     auto triple = llvm::Triple{ options.GetTriple() };
-    std::string error;
     const llvm::Target* target = llvm::TargetRegistry::lookupTarget(triple, error);
+    // Unknown or not registered triple, left invalid for the caller to report.
+    if (!target)
+        return;
 
     llvm::TargetOptions targetOptions{};
     llvm::TargetMachine* targetMachine = 
-        target->createTargetMachine(triple, options.GetCPU(), options.GetFeatures(), targetOptions, std::nullopt, std::nullopt, llvm::CodeGenOptLevel::Aggressive);
+        target->createTargetMachine(triple, options.GetCPU(), options.GetFeatures(), targetOptions, options.GetRelocModel(), std::nullopt, llvm::CodeGenOptLevel::Aggressive);
+    if (!targetMachine) {
+        error = "no target machine for '" + triple.str() + "'";
+        return;
+    }
     tm = std::unique_ptr<llvm::TargetMachine>{ targetMachine };
 
     CacheTargetMetadata();
@@ -3,6 +3,7 @@
 #include <llvm/Target/TargetMachine.h>
 #include <llvm/Support/TargetSelect.h>
 #include <llvm/TargetParser/Host.h>
+#include <llvm/TargetParser/Triple.h>
 #include <llvm/ADT/StringMap.h>
 #include <llvm/ADT/IntrusiveRefCntPtr.h>
 #include <llvm/MC/TargetRegistry.h>
@@ -23,4 +24,13 @@ VCL::TargetOptions::TargetOptions() {
         features.AddFeature(feature.first(), feature.second);
 
     this->features = features.getString();
+}
+
+void VCL::TargetOptions::SetTriple(std::string& triple) {
+    // Host CPU and features are meaningless for another target.
+    if (llvm::Triple::normalize(triple) != llvm::Triple::normalize(llvm::sys::getProcessTriple())) {
+        cpu = "generic";
+        features.clear();
+    }
+    this->triple = triple;
 }
\ No newline at end of file
@@ -124,8 +124,17 @@ bool VCL::CompilerContext::HasTarget() {
     return target != nullptr;
 }
 
-void VCL::CompilerContext::CreateTarget() {
+bool VCL::CompilerContext::CreateTarget() {
+    assert(HasDiagnosticEngine() && "missing diagnostic engine");
     target = llvm::makeIntrusiveRefCnt<Target>(invocation->GetTargetOptions());
+    if (!target->IsValid()) {
+        GetDiagnosticReporter().Error(Diagnostic::InvalidTarget, invocation->GetTargetOptions().GetTriple().str(), target->GetError().str())
+            .SetCompilerInfo(__FILE__, __func__, __LINE__)
+            .Report();
+        target = nullptr;
+        return false;
+    }
+    return true;
 }
 
 void VCL::CompilerContext::CopyTarget(CompilerContext& other) {
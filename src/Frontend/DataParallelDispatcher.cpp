@@ -0,0 +1,223 @@
+#include <VCL/Frontend/DataParallelDispatcher.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+
+namespace {
+
+    /** In memory representation of a Span, see CodeGenTypes::ConvertSpanType. */
+    struct SpanValue {
+        uint8_t* data;
+        uint64_t count;
+    };
+
+    void* AlignContext(std::vector<uint8_t>& buffer, const VCL::InstanceContextLayout& layout) {
+        if (buffer.size() < layout.GetSize() + layout.GetAlignment())
+            buffer.resize(layout.GetSize() + layout.GetAlignment());
+        uintptr_t alignment = layout.GetAlignment();
+        return (void*)(((uintptr_t)buffer.data() + alignment - 1) & ~(alignment - 1));
+    }
+
+}
+
+struct VCL::DataParallelDispatcher::Job {
+    struct Span {
+        uint64_t offset;
+        uint64_t elementSize;
+        uint8_t* data;
+    };
+
+    void(*entryPoint)(void*);
+    const InstanceContextLayout* layout;
+    const uint8_t* context;
+    llvm::SmallVector<Span> spans{};
+    uint64_t elementCount = 0;
+    uint64_t chunkElementCount = 0;
+    uint64_t chunkCount = 0;
+    std::vector<uint8_t> lastContext{};
+};
+
+VCL::DataParallelDispatcher::DataParallelDispatcher(uint32_t threadCount, uint32_t vectorWidthInElement)
+        : threadCount{ threadCount == 0 ? std::max(std::thread::hardware_concurrency(), 1u) : threadCount },
+          vectorWidthInElement{ std::max(vectorWidthInElement, 1u) } {
+    workers.reserve(this->threadCount);
+    for (uint32_t i = 0; i < this->threadCount; ++i)
+        workers.push_back(std::make_unique<Worker>());
+    threads.reserve(this->threadCount);
+    for (uint32_t i = 0; i < this->threadCount; ++i)
+        threads.emplace_back([this, i]() { Run(i); });
+}
+
+VCL::DataParallelDispatcher::~DataParallelDispatcher() {
+    {
+        std::lock_guard<std::mutex> lock{ mutex };
+        running = false;
+    }
+    condition.notify_all();
+    for (std::thread& thread : threads)
+        thread.join();
+}
+
+bool VCL::DataParallelDispatcher::Dispatch(const KernelHandle<void(void*)>& kernel, const InstanceContextLayout& layout, void* context, llvm::ArrayRef<SpanBinding> spans) {
+    if (!kernel || !context || spans.empty())
+        return false;
+
+    std::lock_guard<std::mutex> dispatchLock{ dispatchMutex };
+
+    Job current{};
+    current.entryPoint = kernel.GetEntryPoint();
+    current.layout = &layout;
+    current.context = (const uint8_t*)context;
+
+    uint64_t bytesPerElement = 0;
+    for (const SpanBinding& binding : spans) {
+        const InstanceContextLayout::Field* field = layout.GetField(binding.name);
+        if (!field || field->size < sizeof(SpanValue) || binding.elementSize == 0)
+            return false;
+        SpanValue value{};
+        std::memcpy(&value, (uint8_t*)context + field->offset, sizeof(SpanValue));
+        if (&binding != spans.begin() && value.count != current.elementCount)
+            return false;
+        current.elementCount = value.count;
+        current.spans.push_back({ field->offset, binding.elementSize, value.data });
+        bytesPerElement += binding.elementSize;
+    }
+
+    if (current.elementCount == 0)
+        return true;
+
+    // Fit every span slice of a chunk in the cache budget, rounded down to whole vectors.
+    uint64_t chunkElementCount = std::max<uint64_t>(chunkSizeInByte / bytesPerElement, 1);
+    chunkElementCount = std::max<uint64_t>(chunkElementCount / vectorWidthInElement, 1) * vectorWidthInElement;
+    current.chunkElementCount = chunkElementCount;
+    current.chunkCount = (current.elementCount + chunkElementCount - 1) / chunkElementCount;
+
+    // Give each worker a contiguous range of chunks, idle workers steal from the back of the others.
+    for (uint32_t i = 0; i < threadCount; ++i) {
+        uint64_t begin = current.chunkCount * i / threadCount;
+        uint64_t end = current.chunkCount * (i + 1) / threadCount;
+        std::lock_guard<std::mutex> lock{ workers[i]->mutex };
+        for (uint64_t chunk = begin; chunk < end; ++chunk)
+            workers[i]->chunks.push_back(chunk);
+    }
+
+    {
+        std::unique_lock<std::mutex> lock{ mutex };
+        job = &current;
+        activeCount = threadCount;
+        ++generation;
+        condition.notify_all();
+        doneCondition.wait(lock, [this]() { return activeCount == 0; });
+        job = nullptr;
+    }
+
+    // Report scalar outputs from the last chunk, spans outputs are already in place.
+    void* lastContext = AlignContext(current.lastContext, layout);
+    for (const InstanceContextLayout::Field& field : layout.GetFields()) {
+        if (!field.out)
+            continue;
+        bool isBound = std::any_of(current.spans.begin(), current.spans.end(), [&](const Job::Span& span) {
+            return span.offset == field.offset;
+        });
+        if (!isBound)
+            std::memcpy((uint8_t*)context + field.offset, (uint8_t*)lastContext + field.offset, field.size);
+    }
+
+    return true;
+}
+
+std::vector<VCL::DataParallelDispatcher::WorkerStats> VCL::DataParallelDispatcher::GetStats() {
+    std::lock_guard<std::mutex> dispatchLock{ dispatchMutex };
+    std::vector<WorkerStats> stats{};
+    stats.reserve(threadCount);
+    for (std::unique_ptr<Worker>& worker : workers)
+        stats.push_back(worker->stats);
+    return stats;
+}
+
+void VCL::DataParallelDispatcher::ResetStats() {
+    std::lock_guard<std::mutex> dispatchLock{ dispatchMutex };
+    for (std::unique_ptr<Worker>& worker : workers)
+        worker->stats = WorkerStats{};
+}
+
+void VCL::DataParallelDispatcher::Run(uint32_t index) {
+    uint64_t seenGeneration = 0;
+    while (true) {
+        Job* current = nullptr;
+        {
+            std::unique_lock<std::mutex> lock{ mutex };
+            condition.wait(lock, [&]() { return !running || generation != seenGeneration; });
+            if (!running)
+                return;
+            seenGeneration = generation;
+            current = job;
+        }
+        RunJob(index, *current);
+        {
+            std::lock_guard<std::mutex> lock{ mutex };
+            if (--activeCount == 0)
+                doneCondition.notify_all();
+        }
+    }
+}
+
+void VCL::DataParallelDispatcher::RunJob(uint32_t index, Job& job) {
+    Worker& worker = *workers[index];
+    const InstanceContextLayout& layout = *job.layout;
+    uint8_t* context = (uint8_t*)AlignContext(worker.context, layout);
+
+    auto start = std::chrono::steady_clock::now();
+
+    uint64_t chunk;
+    bool stolen;
+    while (PopChunk(index, chunk, stolen)) {
+        uint64_t begin = chunk * job.chunkElementCount;
+        uint64_t count = std::min(job.chunkElementCount, job.elementCount - begin);
+
+        std::memcpy(context, job.context, layout.GetSize());
+        for (const Job::Span& span : job.spans) {
+            SpanValue value{ span.data + begin * span.elementSize, count };
+            std::memcpy(context + span.offset, &value, sizeof(SpanValue));
+        }
+
+        job.entryPoint(context);
+
+        // Only one worker ever run the last chunk, no need to synchronize.
+        if (chunk == job.chunkCount - 1)
+            std::memcpy(AlignContext(job.lastContext, layout), context, layout.GetSize());
+
+        ++worker.stats.chunkCount;
+        worker.stats.elementCount += count;
+        if (stolen)
+            ++worker.stats.stolenCount;
+    }
+
+    worker.stats.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool VCL::DataParallelDispatcher::PopChunk(uint32_t index, uint64_t& chunk, bool& stolen) {
+    {
+        Worker& worker = *workers[index];
+        std::lock_guard<std::mutex> lock{ worker.mutex };
+        if (!worker.chunks.empty()) {
+            chunk = worker.chunks.front();
+            worker.chunks.pop_front();
+            stolen = false;
+            return true;
+        }
+    }
+    for (uint32_t i = 1; i < threadCount; ++i) {
+        Worker& victim = *workers[(index + i) % threadCount];
+        std::lock_guard<std::mutex> lock{ victim.mutex };
+        if (!victim.chunks.empty()) {
+            chunk = victim.chunks.back();
+            victim.chunks.pop_back();
+            stolen = true;
+            return true;
+        }
+    }
+    return false;
+}
\ No newline at end of file
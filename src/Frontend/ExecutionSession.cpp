@@ -3,15 +3,29 @@
 #include <llvm/Target/TargetMachine.h>
 #include <llvm/Support/TargetSelect.h>
 #include <llvm/TargetParser/Host.h>
+#include <llvm/Object/ObjectFile.h>
+#include <llvm/Support/DynamicLibrary.h>
 
+#include <algorithm>
 #include <cmath>
+#include <future>
 
 
-VCL::ExecutionSession::ExecutionSession() : lastError{ llvm::Error::success() } {
+VCL::ExecutionSession::ExecutionSession() : ExecutionSession{ std::unique_ptr<ThreadPoolTaskDispatcher>{} } {}
+
+VCL::ExecutionSession::ExecutionSession(uint32_t threadCount) : ExecutionSession{ std::make_unique<ThreadPoolTaskDispatcher>(threadCount) } {}
+
+VCL::ExecutionSession::ExecutionSession(std::unique_ptr<ThreadPoolTaskDispatcher> dispatcher) : moduleCount{ 0 }, 
+        threadCount{ dispatcher ? dispatcher->GetThreadCount() : 0 }, lastError{ llvm::Error::success() } {
     llvm::InitializeNativeTarget();
     llvm::InitializeNativeTargetAsmPrinter();
 
-    if (auto r = llvm::orc::SelfExecutorProcessControl::Create(); !r)
+    // Without a dispatcher, materialization run in place on the calling thread. Passing none would let
+    // SelfExecutorProcessControl install its own thread pool.
+    std::unique_ptr<llvm::orc::TaskDispatcher> taskDispatcher = std::move(dispatcher);
+    if (!taskDispatcher)
+        taskDispatcher = std::make_unique<llvm::orc::InPlaceTaskDispatcher>();
+    if (auto r = llvm::orc::SelfExecutorProcessControl::Create(nullptr, std::move(taskDispatcher)); !r)
         throw std::runtime_error{ llvm::toString(r.takeError()) };
     else
         session = std::make_unique<llvm::orc::ExecutionSession>(std::move(*r));
@@ -35,12 +49,15 @@ VCL::ExecutionSession::ExecutionSession() : lastError{ llvm::Error::success() }
     compileLayer = std::make_unique<llvm::orc::IRCompileLayer>(*session, *linkingLayer, std::make_unique<llvm::orc::ConcurrentIRCompiler>(std::move(*jtmb)));
 
     main = &session->createBareJITDylib("Main");
+    searchOrder.push_back(main);
     gdbListener = llvm::JITEventListener::createGDBRegistrationListener();
 }
 
 VCL::ExecutionSession::ExecutionSession(ExecutionSession&& other) : session{ std::move(other.session) }, layout{ std::move(other.layout) },
-        mangle{ std::move(other.mangle) }, linkingLayer{ std::move(other.linkingLayer) }, compileLayer{ std::move(other.compileLayer) }, main{ other.main },
-        gdbListener{ other.gdbListener }, lastError{ std::move(other.lastError) } {
+        mangle{ std::move(other.mangle) }, linkingLayer{ std::move(other.linkingLayer) }, compileLayer{ std::move(other.compileLayer) },
+        objectCache{ std::move(other.objectCache) }, lazyCallThroughManager{ std::move(other.lazyCallThroughManager) }, 
+        codLayer{ std::move(other.codLayer) }, main{ other.main }, searchOrder{ std::move(other.searchOrder) }, 
+        entryPoints{ std::move(other.entryPoints) }, moduleCount{ other.moduleCount }, threadCount{ other.threadCount }, gdbListener{ other.gdbListener }, lastError{ std::move(other.lastError) } {
     other.session = nullptr;
 }
 
@@ -49,21 +66,246 @@ VCL::ExecutionSession::~ExecutionSession() {
         llvm::cantFail(session->endSession());
 }
 
-bool VCL::ExecutionSession::SubmitModule(llvm::orc::ThreadSafeModule&& module) {
-    llvm::Error err = compileLayer->add(*main, std::move(module));
-    if (err)
+VCL::ModuleHandle VCL::ExecutionSession::SubmitModule(llvm::orc::ThreadSafeModule&& module) {
+    llvm::orc::JITDylib& dylib = session->createBareJITDylib("Module" + std::to_string(moduleCount++));
+    // Inputs and intrinsics are defined in Main.
+    dylib.addToLinkOrder(*main);
+
+    llvm::orc::ResourceTrackerSP tracker = dylib.createResourceTracker();
+    std::shared_ptr<std::vector<std::string>> symbols = std::make_shared<std::vector<std::string>>();
+    llvm::Error err = AddModule(tracker, std::move(module), *symbols);
+
+    if (err) {
         lastError = std::move(err);
-    return !err;
+        llvm::consumeError(session->removeJITDylib(dylib));
+        return ModuleHandle{};
+    }
+
+    searchOrder.push_back(&dylib);
+    return ModuleHandle{ &dylib, tracker, symbols };
+}
+
+llvm::Error VCL::ExecutionSession::AddModule(llvm::orc::ResourceTrackerSP tracker, llvm::orc::ThreadSafeModule&& module, 
+        std::vector<std::string>& symbols) {
+    std::string key = module.withModuleDo([](llvm::Module& module) { return module.getModuleIdentifier(); });
+    bool cached = module.withModuleDo([](llvm::Module& module) { return module.getNamedMetadata(ObjectCache::CachedMetadataName) != nullptr; });
+    if (objectCache) {
+        if (ObjectCache::IsKey(key) && (cached || objectCache->Contains(key))) {
+            if (std::unique_ptr<llvm::MemoryBuffer> object = objectCache->Load(key); object) {
+                // Cached modules are empty, recover in/out variables from the object symbol table.
+                if (auto file = llvm::object::ObjectFile::createObjectFile(object->getMemBufferRef()); file) {
+                    for (const llvm::object::SymbolRef& symbol : (*file)->symbols()) {
+                        auto flags = symbol.getFlags();
+                        auto type = symbol.getType();
+                        auto name = symbol.getName();
+                        if (!flags || !type || !name) {
+                            llvm::consumeError(flags.takeError());
+                            llvm::consumeError(type.takeError());
+                            llvm::consumeError(name.takeError());
+                            continue;
+                        }
+                        if (!(*flags & llvm::object::SymbolRef::SF_Global))
+                            continue;
+                        if ((*flags & llvm::object::SymbolRef::SF_Undefined) || *type == llvm::object::SymbolRef::ST_Data)
+                            symbols.push_back(name->str());
+                    }
+                } else {
+                    llvm::consumeError(file.takeError());
+                }
+                return linkingLayer->add(tracker, std::move(object));
+            }
+        }
+    }
+
+    // The module was emitted empty for an object that is no longer in the cache.
+    if (cached)
+        return llvm::make_error<llvm::StringError>("cached object '" + key + "' could not be loaded", llvm::inconvertibleErrorCode());
+
+    module.withModuleDo([&symbols](llvm::Module& module) {
+        for (llvm::GlobalVariable& gv : module.globals())
+            if (gv.hasExternalLinkage())
+                symbols.push_back(gv.getName().str());
+    });
+
+    if (codLayer)
+        return codLayer->add(tracker, std::move(module));
+    return compileLayer->add(tracker, std::move(module));
+}
+
+std::vector<VCL::ModuleHandle> VCL::ExecutionSession::SubmitModules(std::vector<llvm::orc::ThreadSafeModule>&& modules) {
+    std::vector<ModuleHandle> handles{};
+    std::vector<llvm::orc::SymbolLookupSet> lookupSets{};
+    handles.reserve(modules.size());
+    lookupSets.reserve(modules.size());
+
+    for (llvm::orc::ThreadSafeModule& module : modules) {
+        llvm::orc::SymbolLookupSet lookupSet{};
+        module.withModuleDo([this, &lookupSet](llvm::Module& module) {
+            for (llvm::GlobalValue& gv : module.global_values())
+                if (!gv.isDeclaration() && gv.hasExternalLinkage())
+                    lookupSet.add(session->intern(gv.getName()), llvm::orc::SymbolLookupFlags::WeaklyReferencedSymbol);
+        });
+        handles.push_back(SubmitModule(std::move(module)));
+        lookupSets.push_back(std::move(lookupSet));
+    }
+    modules.clear();
+
+    // Lazy modules compile on first call, nothing to force.
+    if (codLayer)
+        return handles;
+
+    // Issue every lookup before waiting on any, each module is then materialized by its own task.
+    std::vector<std::promise<llvm::Error>> promises{ handles.size() };
+    std::vector<std::future<llvm::Error>> futures{};
+    futures.reserve(handles.size());
+
+    for (size_t i = 0; i < handles.size(); ++i) {
+        futures.push_back(promises[i].get_future());
+        if (!handles[i] || lookupSets[i].empty()) {
+            promises[i].set_value(llvm::Error::success());
+            continue;
+        }
+        session->lookup(llvm::orc::LookupKind::Static, llvm::orc::makeJITDylibSearchOrder({ handles[i].GetJITDylib() }),
+            std::move(lookupSets[i]), llvm::orc::SymbolState::Ready,
+            [&promise = promises[i]](llvm::Expected<llvm::orc::SymbolMap> r) { promise.set_value(r.takeError()); },
+            llvm::orc::NoDependenciesToRegister);
+    }
+
+    for (size_t i = 0; i < handles.size(); ++i) {
+        if (llvm::Error err = futures[i].get(); err) {
+            lastError = std::move(err);
+            RemoveModule(handles[i]);
+        }
+    }
+
+    return handles;
+}
+
+bool VCL::ExecutionSession::RemoveModule(ModuleHandle& handle) {
+    if (!handle)
+        return false;
+
+    llvm::orc::JITDylib* dylib = handle.GetJITDylib();
+    searchOrder.erase(std::remove(searchOrder.begin(), searchOrder.end(), dylib), searchOrder.end());
+    entryPoints.erase(dylib);
+    handle = ModuleHandle{};
+
+    if (llvm::Error err = session->removeJITDylib(*dylib); err) {
+        lastError = std::move(err);
+        return false;
+    }
+    return true;
+}
+
+VCL::ModuleHandle VCL::ExecutionSession::ReplaceModule(ModuleHandle& handle, llvm::orc::ThreadSafeModule&& module) {
+    ModuleHandle newHandle = SubmitModule(std::move(module));
+    if (!newHandle)
+        return newHandle;
+
+    // Take the old module place in the search order, newly resolved symbols now come from the new module.
+    llvm::orc::JITDylib* dylib = newHandle.GetJITDylib();
+    searchOrder.pop_back();
+    auto it = std::find(searchOrder.begin(), searchOrder.end(), handle.GetJITDylib());
+    if (it != searchOrder.end())
+        *it = dylib;
+    else
+        searchOrder.push_back(dylib);
+
+    // Resolve every slot taken on the old module before publishing any of them.
+    auto slots = entryPoints.find(handle.GetJITDylib());
+    if (slots == entryPoints.end())
+        return newHandle;
+
+    llvm::SmallVector<std::pair<EntryPointSlot*, void*>> resolved{};
+    for (auto& entryPoint : slots->second) {
+        auto r = session->lookup(llvm::orc::makeJITDylibSearchOrder({ dylib }), session->intern(entryPoint.getKey()));
+        if (!r) {
+            llvm::Error err = r.takeError();
+            if (it != searchOrder.end())
+                *it = handle.GetJITDylib();
+            RemoveModule(newHandle);
+            lastError = std::move(err);
+            return ModuleHandle{};
+        }
+        resolved.push_back({ entryPoint.getValue().get(), r->getAddress().toPtr<void*>() });
+    }
+
+    for (auto& [slot, address] : resolved)
+        slot->store(address, std::memory_order_release);
+
+    // The slots now follow the new module.
+    llvm::StringMap<std::unique_ptr<EntryPointSlot>> moved = std::move(slots->second);
+    entryPoints.erase(slots);
+    entryPoints[dylib] = std::move(moved);
+
+    return newHandle;
 }
 
 void* VCL::ExecutionSession::Lookup(llvm::StringRef name) {
-    if (auto r = session->lookup({ main }, name); !r) {
+    if (auto r = session->lookup(llvm::orc::makeJITDylibSearchOrder(searchOrder), session->intern(name)); !r) {
+        lastError = std::move(r.takeError());
+        return nullptr;
+    } else
+        return r.get().getAddress().toPtr<void*>();
+}
+
+void* VCL::ExecutionSession::Lookup(const ModuleHandle& module, llvm::StringRef name) {
+    if (!module)
+        return nullptr;
+
+    if (auto r = session->lookup(llvm::orc::makeJITDylibSearchOrder({ module.GetJITDylib(), main }), session->intern(name)); !r) {
         lastError = std::move(r.takeError());
         return nullptr;
     } else
         return r.get().getAddress().toPtr<void*>();
 }
 
+VCL::EntryPointSlot* VCL::ExecutionSession::LookupEntryPoint(const ModuleHandle& module, llvm::StringRef name) {
+    if (!module)
+        return nullptr;
+
+    llvm::StringMap<std::unique_ptr<EntryPointSlot>>& slots = entryPoints[module.GetJITDylib()];
+    if (auto it = slots.find(name); it != slots.end())
+        return it->getValue().get();
+
+    // Only the module own definition, an entry point of another module must not be taken for it.
+    void* address = nullptr;
+    if (auto r = session->lookup(llvm::orc::makeJITDylibSearchOrder({ module.GetJITDylib() }), session->intern(name)); !r) {
+        lastError = std::move(r.takeError());
+        return nullptr;
+    } else
+        address = r->getAddress().toPtr<void*>();
+
+    std::unique_ptr<EntryPointSlot>& slot = slots[name];
+    slot = std::make_unique<EntryPointSlot>(address);
+    return slot.get();
+}
+
+bool VCL::ExecutionSession::ResolveKernel(const ModuleHandle& module, llvm::StringRef entryPoint, void*& address, 
+        llvm::StringMap<void*>& symbols) {
+    if (!module)
+        return false;
+
+    // Undefined symbols of a cached object may be functions provided elsewhere, only keep what resolve.
+    llvm::orc::SymbolLookupSet lookupSet{ session->intern(entryPoint) };
+    for (const std::string& name : module.GetSymbols())
+        lookupSet.add(session->intern(name), llvm::orc::SymbolLookupFlags::WeaklyReferencedSymbol);
+
+    auto r = session->lookup(llvm::orc::makeJITDylibSearchOrder({ module.GetJITDylib(), main }), std::move(lookupSet));
+    if (!r) {
+        lastError = r.takeError();
+        return false;
+    }
+
+    for (auto& [name, symbol] : *r) {
+        if (*name == entryPoint)
+            address = symbol.getAddress().toPtr<void*>();
+        else
+            symbols[*name] = symbol.getAddress().toPtr<void*>();
+    }
+    return address != nullptr;
+}
+
 bool VCL::ExecutionSession::DefineSymbolPtr(llvm::StringRef name, void* ptr) {
     llvm::orc::ExecutorSymbolDef symbol{
         llvm::orc::ExecutorAddr::fromPtr(ptr),
@@ -78,6 +320,52 @@ bool VCL::ExecutionSession::DefineSymbolPtr(llvm::StringRef name, void* ptr) {
     return !err;
 }
 
+bool VCL::ExecutionSession::EnableObjectCache(llvm::StringRef directory, uint64_t maxSize) {
+    auto jtmb = llvm::orc::JITTargetMachineBuilder::detectHost();
+
+    if (!jtmb) {
+        lastError = jtmb.takeError();
+        return false;
+    }
+
+    objectCache = std::make_unique<ObjectCache>(directory, maxSize);
+    compileLayer = std::make_unique<llvm::orc::IRCompileLayer>(*session, *linkingLayer, 
+        std::make_unique<llvm::orc::ConcurrentIRCompiler>(std::move(*jtmb), objectCache.get()));
+
+    // The compile on demand layer reference the compile layer, rebuild it on top of the new one.
+    if (codLayer) {
+        codLayer = nullptr;
+        return EnableLazyCompilation();
+    }
+    return true;
+}
+
+bool VCL::ExecutionSession::EnableLazyCompilation() {
+    const llvm::Triple& triple = session->getExecutorProcessControl().getTargetTriple();
+
+    if (!lazyCallThroughManager) {
+        auto r = llvm::orc::createLocalLazyCallThroughManager(triple, *session, llvm::orc::ExecutorAddr{});
+        if (!r) {
+            lastError = r.takeError();
+            return false;
+        }
+        lazyCallThroughManager = std::move(*r);
+    }
+
+    auto stubsManagerBuilder = llvm::orc::createLocalIndirectStubsManagerBuilder(triple);
+    if (!stubsManagerBuilder) {
+        lastError = llvm::make_error<llvm::StringError>("lazy compilation is not supported on " + triple.str(), 
+            llvm::inconvertibleErrorCode());
+        return false;
+    }
+
+    codLayer = std::make_unique<llvm::orc::CompileOnDemandLayer>(*session, *compileLayer, *lazyCallThroughManager, 
+        std::move(stubsManagerBuilder));
+    // Only extract the requested functions, everything else stay behind a lazy stub until first call.
+    codLayer->setPartitionFunction(llvm::orc::CompileOnDemandLayer::compileRequested);
+    return true;
+}
+
 void VCL::ExecutionSession::EnableGDBListener() {
     linkingLayer->registerJITEventListener(*gdbListener);
 }
@@ -86,6 +374,14 @@ void VCL::ExecutionSession::DisableGDBListener() {
     linkingLayer->unregisterJITEventListener(*gdbListener);
 }
 
+void VCL::ExecutionSession::RegisterJITEventListener(llvm::JITEventListener& listener) {
+    linkingLayer->registerJITEventListener(listener);
+}
+
+void VCL::ExecutionSession::UnregisterJITEventListener(llvm::JITEventListener& listener) {
+    linkingLayer->unregisterJITEventListener(listener);
+}
+
 void VCL::ExecutionSession::DefineDefaultMemIntrinsic() {
     llvm::orc::SymbolMap symbolMap{ 2 };
 
@@ -109,7 +405,7 @@ void VCL::ExecutionSession::DefineDefaultMemIntrinsic() {
     }
 
 void VCL::ExecutionSession::DefineDefaultMathIntrinsic() {
-    llvm::orc::SymbolMap symbolMap{ 44 };
+    llvm::orc::SymbolMap symbolMap{ 52 };
 
     // Float
     ADD_MATH_SYMBOL("sqrtf",    &sqrtf);
@@ -131,6 +427,9 @@ void VCL::ExecutionSession::DefineDefaultMathIntrinsic() {
     ADD_MATH_SYMBOL("ceilf",    &ceilf);
     ADD_MATH_SYMBOL("floorf",   &floorf);
     ADD_MATH_SYMBOL("roundf",   &roundf);
+    ADD_MATH_SYMBOL("rintf",    &rintf);
+    ADD_MATH_SYMBOL("truncf",   &truncf);
+    ADD_MATH_SYMBOL("fmodf",    &fmodf);
     ADD_MATH_SYMBOL("atan2f",    &atan2f);
     ADD_MATH_SYMBOL("powf",     &powf);
     ADD_MATH_SYMBOL("fmaf",     &fmaf);
@@ -155,10 +454,45 @@ void VCL::ExecutionSession::DefineDefaultMathIntrinsic() {
     ADD_MATH_SYMBOL("ceil",     static_cast<double(*)(double)>(&ceil));
     ADD_MATH_SYMBOL("floor",    static_cast<double(*)(double)>(&floor));
     ADD_MATH_SYMBOL("round",    static_cast<double(*)(double)>(&round));
+    ADD_MATH_SYMBOL("rint",     static_cast<double(*)(double)>(&rint));
+    ADD_MATH_SYMBOL("trunc",    static_cast<double(*)(double)>(&trunc));
+    ADD_MATH_SYMBOL("fmod",     static_cast<double(*)(double, double)>(&fmod));
     ADD_MATH_SYMBOL("atan2",    static_cast<double(*)(double, double)>(&atan2));
     ADD_MATH_SYMBOL("pow",      static_cast<double(*)(double, double)>(&pow));
     ADD_MATH_SYMBOL("fma",      static_cast<double(*)(double, double, double)>(&fma));
     ADD_MATH_SYMBOL("sincos",   static_cast<void(*)(double, double*, double*)>(&sincos));
 
+    lastError = main->define(llvm::orc::absoluteSymbols(symbolMap));
+}
+
+void VCL::ExecutionSession::DefineLibmvecIntrinsic() {
+    std::string message{};
+    llvm::sys::DynamicLibrary library = llvm::sys::DynamicLibrary::getPermanentLibrary("libmvec.so.1", &message);
+    if (!library.isValid()) {
+        lastError = llvm::make_error<llvm::StringError>(message, llvm::inconvertibleErrorCode());
+        return;
+    }
+
+    constexpr std::pair<llvm::StringLiteral, uint32_t> functions[] = {
+        { "sin", 1 }, { "cos", 1 }, { "tan", 1 }, { "asin", 1 }, { "acos", 1 }, { "atan", 1 },
+        { "sinh", 1 }, { "cosh", 1 }, { "tanh", 1 }, { "exp", 1 }, { "exp2", 1 }, { "exp10", 1 },
+        { "log", 1 }, { "log2", 1 }, { "log10", 1 }, { "atan2", 2 }, { "pow", 2 }
+    };
+    // x86-64 vector function ABI, SSE4, AVX, AVX2 and AVX-512 with their register size in byte.
+    constexpr std::pair<char, uint32_t> isas[] = { { 'b', 16 }, { 'c', 32 }, { 'd', 32 }, { 'e', 64 } };
+
+    // _ZGV<isa>N<lanes><'v' per argument>_<name>, every variant the installed glibc doesn't provide is skipped.
+    llvm::orc::SymbolMap symbolMap{};
+    for (auto& [function, argCount] : functions) {
+        for (auto& [isa, widthInByte] : isas) {
+            for (bool isFloat : { false, true }) {
+                std::string name = "_ZGV" + std::string(1, isa) + "N" + std::to_string(widthInByte / (isFloat ? 4 : 8)) +
+                    std::string(argCount, 'v') + "_" + function.str() + (isFloat ? "f" : "");
+                if (void* ptr = library.getAddressOfSymbol(name.c_str()); ptr)
+                    ADD_MATH_SYMBOL(name, ptr);
+            }
+        }
+    }
+
     lastError = main->define(llvm::orc::absoluteSymbols(symbolMap));
 }
\ No newline at end of file
@@ -3,14 +3,20 @@
 #include <VCL/Frontend/CompilerContext.hpp>
 #include <VCL/Frontend/CompilerInstance.hpp>
 #include <VCL/Core/Source.hpp>
+#include <VCL/Core/Hasher.hpp>
+#include <VCL/Core/Target.hpp>
+#include <VCL/Core/Diagnostic.hpp>
 #include <VCL/Lex/Lexer.hpp>
 #include <VCL/Lex/TokenStream.hpp>
 #include <VCL/Sema/Sema.hpp>
 #include <VCL/Parse/Parser.hpp>
 #include <VCL/CodeGen/CodeGenModule.hpp>
 #include <VCL/CodeGen/Optimizer.hpp>
+#include <VCL/CodeGen/Multiversion.hpp>
 
 #include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
+#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/Support/raw_ostream.h>
 
 #include <assert.h>
 
@@ -83,13 +89,31 @@ bool VCL::EmitLLVMAction::Execute() {
     
     if (!parser.Parse())
         return false;
+
+    Hasher hasher{};
+    hasher.Hash(ObjectCache::HashCompilerInstance(*instance));
+    hasher.Hash((uint64_t)runOptimization);
+    hasher.Hash((uint64_t)useInstanceContext);
+    hasher.Hash((uint64_t)multiversioning);
+    hasher.Hash((uint64_t)mathAccuracy);
+    hasher.Hash((uint64_t)instance->GetCompilerContext().GetInvocation()->GetTargetOptions().GetVectorLibrary());
+    std::string key = ObjectCache::MakeKey(hasher.Get());
     
     module = llvm::orc::ThreadSafeModule{ 
-        instance->GetCompilerContext().GetLLVMContext().withContextDo([](llvm::LLVMContext* context){
-            return std::make_unique<llvm::Module>("module", *context);
+        instance->GetCompilerContext().GetLLVMContext().withContextDo([&key](llvm::LLVMContext* context){
+            return std::make_unique<llvm::Module>(key, *context);
         }),
         instance->GetCompilerContext().GetLLVMContext() };
 
+    cached = objectCache && objectCache->Contains(key);
+    if (cached) {
+        module.withModuleDo([](llvm::Module& module) { module.getOrInsertNamedMetadata(ObjectCache::CachedMetadataName); });
+        return true;
+    }
+
+    if (multiversioning)
+        return module.withModuleDo([this](llvm::Module& module) { return EmitMultiversion(module); });
+
     return module.withModuleDo([this](llvm::Module& module){
         CodeGenModule cgm{
             module, 
@@ -99,13 +123,100 @@ bool VCL::EmitLLVMAction::Execute() {
             instance->GetImportModuleTable(),
             instance->GetCompilerContext().GetAttributeTable(),
             instance->GetCompilerContext().GetIdentifierTable() };
+        cgm.SetUseInstanceContext(useInstanceContext);
+        cgm.SetMathAccuracy(mathAccuracy);
         if (!cgm.Emit())
             return false;
         if (runOptimization) {
             Optimizer optimizer{};
+            optimizer.SetVectorLibrary(instance->GetCompilerContext().GetInvocation()->GetTargetOptions().GetVectorLibrary());
             return optimizer.Optimize(cgm);
         } else {
             return true;
         }
     });
+}
+
+bool VCL::EmitLLVMAction::EmitMultiversion(llvm::Module& module) {
+    CompilerContext& cc = instance->GetCompilerContext();
+    llvm::TargetMachine* tm = cc.GetTarget().GetTargetMachine();
+
+    if (!Multiversioner::IsSupported(tm->getTargetTriple())) {
+        cc.GetDiagnosticReporter().Error(Diagnostic::MultiversionUnsupportedTarget, tm->getTargetTriple().str())
+            .SetCompilerInfo(__FILE__, __func__, __LINE__)
+            .Report();
+        return false;
+    }
+    // The instance context layout depend on the vector width, it would differ between versions.
+    if (useInstanceContext) {
+        cc.GetDiagnosticReporter().Error(Diagnostic::MultiversionInstanceContext)
+            .SetCompilerInfo(__FILE__, __func__, __LINE__)
+            .Report();
+        return false;
+    }
+
+    module.setDataLayout(tm->createDataLayout());
+    module.setTargetTriple(tm->getTargetTriple().str());
+
+    Multiversioner multiversioner{ module, cc.GetDiagnosticReporter() };
+    for (const TargetVersion& version : Multiversioner::GetVersions()) {
+        TargetOptions options = cc.GetInvocation()->GetTargetOptions();
+        std::string cpu = version.cpu.str();
+        std::string features = version.features.str();
+        options.SetCPU(cpu);
+        options.SetFeatures(features);
+        llvm::IntrusiveRefCntPtr<Target> target = llvm::makeIntrusiveRefCnt<Target>(options);
+
+        std::unique_ptr<llvm::Module> versionModule = std::make_unique<llvm::Module>(module.getModuleIdentifier(), module.getContext());
+        CodeGenModule cgm{
+            *versionModule, 
+            instance->GetASTContext(), 
+            cc.GetDiagnosticReporter(),
+            *target,
+            instance->GetImportModuleTable(),
+            cc.GetAttributeTable(),
+            cc.GetIdentifierTable() };
+        cgm.SetEmitImportedDefinitions(true);
+        cgm.SetMathAccuracy(mathAccuracy);
+        if (!cgm.Emit())
+            return false;
+        if (!multiversioner.AddVersion(std::move(versionModule), version, target->GetVectorWidthInByte()))
+            return false;
+    }
+
+    if (!multiversioner.EmitDispatchers())
+        return false;
+
+    // No vector library, its variants are picked by width alone and could require more than the features of a version.
+    if (runOptimization) {
+        Optimizer optimizer{};
+        return optimizer.Optimize(module);
+    }
+    return true;
+}
+
+bool VCL::EmitObjectAction::Execute() {
+    // Cached objects are built by the JIT for the host, never reuse them ahead of time.
+    SetObjectCache(nullptr);
+
+    if (!EmitLLVMAction::Execute())
+        return false;
+
+    object.clear();
+
+    return module.withModuleDo([this](llvm::Module& module) {
+        llvm::TargetMachine* tm = instance->GetCompilerContext().GetTarget().GetTargetMachine();
+        llvm::raw_svector_ostream os{ object };
+        llvm::legacy::PassManager pm{};
+
+        if (tm->addPassesToEmitFile(pm, os, nullptr, llvm::CodeGenFileType::ObjectFile)) {
+            instance->GetCompilerContext().GetDiagnosticReporter().Error(Diagnostic::InternalError)
+                .SetCompilerInfo(__FILE__, __func__, __LINE__)
+                .Report();
+            return false;
+        }
+
+        pm.run(module);
+        return true;
+    });
 }
\ No newline at end of file
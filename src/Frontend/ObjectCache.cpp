@@ -0,0 +1,230 @@
+#include <VCL/Frontend/ObjectCache.hpp>
+
+#include <VCL/Core/Hasher.hpp>
+#include <VCL/Core/Source.hpp>
+#include <VCL/Core/Target.hpp>
+#include <VCL/AST/ConstantValue.hpp>
+#include <VCL/Frontend/CompilerContext.hpp>
+#include <VCL/Frontend/CompilerInstance.hpp>
+#include <VCL/Sema/ModuleTable.hpp>
+#include <VCL/Sema/DefineTable.hpp>
+
+#include <llvm/Config/llvm-config.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/ADT/SmallVector.h>
+
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include <iomanip>
+
+
+VCL::ObjectCache::ObjectCache(llvm::StringRef directory, uint64_t maxSize) : directory{ directory.str() }, maxSize{ maxSize } {
+    llvm::sys::fs::create_directories(directory);
+}
+
+void VCL::ObjectCache::notifyObjectCompiled(const llvm::Module* module, llvm::MemoryBufferRef buffer) {
+    if (!IsKey(module->getModuleIdentifier()))
+        return;
+    Store(module->getModuleIdentifier(), buffer);
+}
+
+std::unique_ptr<llvm::MemoryBuffer> VCL::ObjectCache::getObject(const llvm::Module* module) {
+    if (!IsKey(module->getModuleIdentifier()))
+        return nullptr;
+    return Load(module->getModuleIdentifier());
+}
+
+bool VCL::ObjectCache::Contains(llvm::StringRef key) {
+    llvm::SmallString<256> path{};
+    GetObjectPath(key, path);
+    return llvm::sys::fs::exists(path);
+}
+
+std::unique_ptr<llvm::MemoryBuffer> VCL::ObjectCache::Load(llvm::StringRef key) {
+    llvm::SmallString<256> path{};
+    GetObjectPath(key, path);
+
+    std::lock_guard<std::mutex> lock{ mutex };
+    auto r = llvm::MemoryBuffer::getFile(path, false, false);
+    if (!r) {
+        ++missCount;
+        return nullptr;
+    }
+    ++hitCount;
+    // Touch the object so eviction stay least recently used.
+    if (auto fd = llvm::sys::fs::openNativeFileForRead(path); fd) {
+        llvm::sys::fs::setLastAccessAndModificationTime(*fd, std::chrono::system_clock::now());
+        llvm::sys::fs::closeFile(*fd);
+    } else {
+        llvm::consumeError(fd.takeError());
+    }
+    return std::move(*r);
+}
+
+bool VCL::ObjectCache::Store(llvm::StringRef key, llvm::MemoryBufferRef buffer) {
+    llvm::SmallString<256> path{};
+    GetObjectPath(key, path);
+
+    std::lock_guard<std::mutex> lock{ mutex };
+
+    // Write to a temporary file first so a concurrent reader never see a partial object.
+    int fd;
+    llvm::SmallString<256> tmpPath{};
+    if (llvm::sys::fs::createUniqueFile(path + ".%%%%%%.tmp", fd, tmpPath))
+        return false;
+    {
+        llvm::raw_fd_ostream os{ fd, true };
+        os << buffer.getBuffer();
+        if (os.has_error()) {
+            os.clear_error();
+            llvm::sys::fs::remove(tmpPath);
+            return false;
+        }
+    }
+    if (llvm::sys::fs::rename(tmpPath, path)) {
+        llvm::sys::fs::remove(tmpPath);
+        return false;
+    }
+
+    PruneUnlocked(key);
+    return true;
+}
+
+void VCL::ObjectCache::Prune() {
+    std::lock_guard<std::mutex> lock{ mutex };
+    PruneUnlocked("");
+}
+
+void VCL::ObjectCache::Clear() {
+    std::lock_guard<std::mutex> lock{ mutex };
+
+    std::error_code ec{};
+    for (llvm::sys::fs::directory_iterator it{ directory, ec }, end; it != end && !ec; it.increment(ec)) {
+        llvm::StringRef path = it->path();
+        if (llvm::sys::path::extension(path) != ".o" || !IsKey(llvm::sys::path::stem(path)))
+            continue;
+        llvm::sys::fs::remove(path);
+    }
+}
+
+uint64_t VCL::ObjectCache::HashCompilerInstance(CompilerInstance& instance) {
+    Hasher hasher{};
+    hasher.Hash(CompilerVersion);
+    hasher.Hash(llvm::StringRef{ LLVM_VERSION_STRING });
+
+    if (instance.HasSource()) {
+        hasher.Hash(instance.GetSource()->GetBufferIdentifier());
+        hasher.Hash(instance.GetSource()->GetBufferRef().getBuffer());
+    }
+
+    if (instance.GetCompilerContext().HasTarget()) {
+        llvm::TargetMachine* tm = instance.GetCompilerContext().GetTarget().GetTargetMachine();
+        hasher.Hash(tm->getTargetTriple().str());
+        hasher.Hash(tm->getTargetCPU());
+        hasher.Hash(tm->getTargetFeatureString());
+    }
+
+    // Tables are keyed by pointer, sort the entries so the hash doesn't depend on iteration order.
+    if (instance.HasImportModuleTable()) {
+        llvm::SmallVector<std::pair<std::string, uint64_t>> imports{};
+        for (auto& [identifierInfo, module] : instance.GetImportModuleTable())
+            imports.push_back({ identifierInfo->GetName().str(), HashCompilerInstance(*module->GetCompilerInstance()) });
+        std::sort(imports.begin(), imports.end());
+        for (auto& [name, hash] : imports) {
+            hasher.Hash(name);
+            hasher.Hash(hash);
+        }
+    }
+
+    if (instance.HasDefineTable()) {
+        llvm::SmallVector<std::pair<std::string, uint64_t>> defines{};
+        for (auto& [identifierInfo, value] : instance.GetDefineTable()) {
+            Hasher valueHasher{};
+            valueHasher.Hash((uint64_t)value->GetConstantValueClass());
+            switch (value->GetConstantValueClass()) {
+                case ConstantValue::ConstantScalarClass: {
+                    ConstantScalar* scalar = (ConstantScalar*)value;
+                    valueHasher.Hash((uint64_t)scalar->GetKind());
+                    valueHasher.Hash(scalar->Get<uint64_t>());
+                    break;
+                }
+                case ConstantValue::ConstantStringClass:
+                    valueHasher.Hash(((ConstantString*)value)->GetString());
+                    break;
+                case ConstantValue::ConstantIdentifierClass:
+                    valueHasher.Hash(((ConstantIdentifier*)value)->GetIdentifierInfo()->GetName());
+                    break;
+                default:
+                    break;
+            }
+            defines.push_back({ identifierInfo->GetName().str(), valueHasher.Get() });
+        }
+        std::sort(defines.begin(), defines.end());
+        for (auto& [name, hash] : defines) {
+            hasher.Hash(name);
+            hasher.Hash(hash);
+        }
+    }
+
+    return hasher.Get();
+}
+
+std::string VCL::ObjectCache::MakeKey(uint64_t hash) {
+    std::stringstream r{};
+    r << "vcl_" << std::setw(16) << std::setfill('0') << std::hex << hash;
+    return r.str();
+}
+
+bool VCL::ObjectCache::IsKey(llvm::StringRef key) {
+    return key.size() == 20 && key.starts_with("vcl_") &&
+        key.drop_front(4).find_first_not_of("0123456789abcdef") == llvm::StringRef::npos;
+}
+
+void VCL::ObjectCache::GetObjectPath(llvm::StringRef key, llvm::SmallVectorImpl<char>& path) {
+    path.clear();
+    llvm::sys::path::append(path, directory, key + ".o");
+}
+
+void VCL::ObjectCache::PruneUnlocked(llvm::StringRef keep) {
+    struct Entry {
+        std::string path;
+        uint64_t size;
+        llvm::sys::TimePoint<> lastAccess;
+    };
+
+    llvm::SmallVector<Entry> entries{};
+    uint64_t totalSize = 0;
+
+    std::error_code ec{};
+    for (llvm::sys::fs::directory_iterator it{ directory, ec }, end; it != end && !ec; it.increment(ec)) {
+        llvm::StringRef path = it->path();
+        if (llvm::sys::path::extension(path) != ".o" || !IsKey(llvm::sys::path::stem(path)))
+            continue;
+        llvm::sys::fs::file_status status{};
+        if (llvm::sys::fs::status(path, status))
+            continue;
+        entries.push_back({ path.str(), status.getSize(), status.getLastModificationTime() });
+        totalSize += status.getSize();
+    }
+
+    if (totalSize <= maxSize)
+        return;
+
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+        return a.lastAccess < b.lastAccess;
+    });
+
+    for (Entry& entry : entries) {
+        if (totalSize <= maxSize)
+            break;
+        if (!keep.empty() && llvm::sys::path::stem(entry.path) == keep)
+            continue;
+        if (llvm::sys::fs::remove(entry.path))
+            continue;
+        totalSize -= entry.size;
+        ++evictionCount;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,24 @@
+#include <VCL/Frontend/ParameterBlock.hpp>
+
+#include <llvm/Support/MathExtras.h>
+
+
+VCL::ParameterBlock::ParameterBlock(size_t size, size_t alignment) 
+        : size{ size }, stride{ llvm::alignTo(std::max(size, (size_t)1), std::max(alignment, (size_t)1)) } {
+    alignment = std::max(alignment, (size_t)1);
+    buffer = std::make_unique<uint8_t[]>(stride * SlotCount + alignment);
+    storage = (uint8_t*)llvm::alignTo((uintptr_t)buffer.get(), alignment);
+}
+
+bool VCL::ParameterBlock::Latch() {
+    if (!(middle.load(std::memory_order_relaxed) & DirtyBit))
+        return false;
+    front = middle.exchange(front, std::memory_order_acq_rel) & IndexMask;
+    std::memcpy(GetBoundPtr(), GetSlot(BufferSlot + front), size);
+    return true;
+}
+
+void VCL::ParameterBlock::Publish() {
+    std::memcpy(GetSlot(BufferSlot + back), GetSlot(StagingSlot), size);
+    back = middle.exchange(back | DirtyBit, std::memory_order_acq_rel) & IndexMask;
+}
\ No newline at end of file
@@ -0,0 +1,292 @@
+#include <VCL/Frontend/Storage.hpp>
+
+#include <llvm/Support/MemAlloc.h>
+#include <llvm/Support/Memory.h>
+#include <llvm/Support/Process.h>
+#include <llvm/Support/MathExtras.h>
+
+#include <fstream>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#endif
+
+
+namespace {
+
+    struct NumaNode {
+        uint32_t id;
+        std::vector<uint32_t> cpus;
+    };
+
+    /** Parse a sysfs list like '0-3,8-11'. */
+    std::vector<uint32_t> ParseList(llvm::StringRef list) {
+        std::vector<uint32_t> result{};
+        llvm::SmallVector<llvm::StringRef> ranges{};
+        list.trim().split(ranges, ',', -1, false);
+        for (llvm::StringRef range : ranges) {
+            auto [first, last] = range.split('-');
+            uint32_t begin, end;
+            if (first.getAsInteger(10, begin))
+                return {};
+            if (last.empty())
+                end = begin;
+            else if (last.getAsInteger(10, end))
+                return {};
+            for (uint32_t i = begin; i <= end; ++i)
+                result.push_back(i);
+        }
+        return result;
+    }
+
+    std::string ReadFile(const std::string& filename) {
+        std::ifstream in{ filename };
+        std::string content{};
+        std::getline(in, content);
+        return content;
+    }
+
+    const std::vector<NumaNode>& GetTopology() {
+        static const std::vector<NumaNode> nodes = []() {
+            std::vector<NumaNode> result{};
+#if defined(__linux__)
+            for (uint32_t id : ParseList(ReadFile("/sys/devices/system/node/online"))) {
+                std::vector<uint32_t> cpus = ParseList(ReadFile("/sys/devices/system/node/node" + std::to_string(id) + "/cpulist"));
+                // Memory only nodes have no thread to touch their pages.
+                if (!cpus.empty())
+                    result.push_back(NumaNode{ id, std::move(cpus) });
+            }
+#endif
+            if (result.empty())
+                result.push_back(NumaNode{ 0, {} });
+            return result;
+        }();
+        return nodes;
+    }
+
+    constexpr size_t HugePageSize = 2 * 1024 * 1024;
+
+    /** Map at least size bytes, which is updated to the mapped size. */
+    uint8_t* MapBuffer(size_t& size, VCL::BufferPolicy::HugePages hugePages) {
+        using HugePages = VCL::BufferPolicy::HugePages;
+#if defined(__linux__)
+        if (hugePages == HugePages::Explicit) {
+            size_t hugeSize = llvm::alignTo(size, HugePageSize);
+            void* ptr = mmap(nullptr, hugeSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (ptr != MAP_FAILED) {
+                size = hugeSize;
+                return (uint8_t*)ptr;
+            }
+            hugePages = HugePages::Transparent;
+        }
+        if (hugePages == HugePages::Transparent) {
+            // Map one more huge page to start on a huge page boundary, and trim the excess.
+            size_t hugeSize = llvm::alignTo(size, HugePageSize);
+            size_t mappedSize = hugeSize + HugePageSize;
+            void* ptr = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (ptr == MAP_FAILED)
+                return nullptr;
+            uint8_t* base = (uint8_t*)ptr;
+            uint8_t* aligned = (uint8_t*)llvm::alignTo((uintptr_t)base, HugePageSize);
+            if (aligned != base)
+                munmap(base, aligned - base);
+            if (size_t tail = (base + mappedSize) - (aligned + hugeSize); tail != 0)
+                munmap(aligned + hugeSize, tail);
+            madvise(aligned, hugeSize, MADV_HUGEPAGE);
+            size = hugeSize;
+            return aligned;
+        }
+        size = llvm::alignTo(size, llvm::sys::Process::getPageSizeEstimate());
+        void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        return ptr != MAP_FAILED ? (uint8_t*)ptr : nullptr;
+#else
+        unsigned flags = llvm::sys::Memory::MF_READ | llvm::sys::Memory::MF_WRITE;
+        if (hugePages != HugePages::None)
+            flags |= llvm::sys::Memory::MF_HUGE_HINT;
+        std::error_code ec{};
+        llvm::sys::MemoryBlock block = llvm::sys::Memory::allocateMappedMemory(size, nullptr, flags, ec);
+        if (ec)
+            return nullptr;
+        size = block.allocatedSize();
+        return (uint8_t*)block.base();
+#endif
+    }
+
+    void UnmapBuffer(void* ptr, size_t size) {
+#if defined(__linux__)
+        munmap(ptr, size);
+#else
+        llvm::sys::MemoryBlock block{ ptr, size };
+        llvm::sys::Memory::releaseMappedMemory(block);
+#endif
+    }
+
+}
+
+
+VCL::StorageManager::~StorageManager() {
+    for (auto& [ptr, allocation] : largeAllocations)
+        llvm::deallocate_buffer(ptr, allocation.size, allocation.alignment);
+    for (auto& [ptr, size] : buffers)
+        UnmapBuffer(ptr, size);
+}
+
+void* VCL::StorageManager::Allocate(size_t size, size_t alignment) {
+    size = std::max(size, (size_t)1);
+    alignment = std::max(alignment, (size_t)target.GetVectorWidthInByte());
+    ++stats.allocationCount;
+
+    uint32_t sizeClass = GetSizeClass(size, alignment);
+    if (sizeClass == SizeClassCount) {
+        void* ptr = llvm::allocate_buffer(size, alignment);
+        largeAllocations.insert({ ptr, LargeAllocation{ size, alignment } });
+        largeBytes += size;
+        stats.usedBytes += size;
+        return ptr;
+    }
+
+    size_t classSize = GetSizeClassSize(sizeClass);
+    stats.usedBytes += classSize;
+    if (FreeBlock* block = freeLists[sizeClass]; block) {
+        freeLists[sizeClass] = block->next;
+        stats.pooledBytes -= classSize;
+        ++stats.reuseCount;
+        return block;
+    }
+    // Class sizes are multiples of the vector width, so is the alignment of every block.
+    return allocator.Allocate(classSize, llvm::Align{ target.GetVectorWidthInByte() });
+}
+
+void VCL::StorageManager::Free(void* ptr, size_t size) {
+    if (!ptr)
+        return;
+    ++stats.freeCount;
+
+    if (auto it = largeAllocations.find(ptr); it != largeAllocations.end()) {
+        llvm::deallocate_buffer(ptr, it->second.size, it->second.alignment);
+        largeBytes -= it->second.size;
+        stats.usedBytes -= it->second.size;
+        largeAllocations.erase(it);
+        return;
+    }
+
+    uint32_t sizeClass = GetSizeClass(std::max(size, (size_t)1), target.GetVectorWidthInByte());
+    size_t classSize = GetSizeClassSize(sizeClass);
+    FreeBlock* block = (FreeBlock*)ptr;
+    block->next = freeLists[sizeClass];
+    freeLists[sizeClass] = block;
+    stats.usedBytes -= classSize;
+    stats.pooledBytes += classSize;
+}
+
+void VCL::StorageManager::Reset() {
+    for (auto& [ptr, allocation] : largeAllocations)
+        llvm::deallocate_buffer(ptr, allocation.size, allocation.alignment);
+    largeAllocations.clear();
+    largeBytes = 0;
+    for (auto& [ptr, size] : buffers)
+        UnmapBuffer(ptr, size);
+    buffers.clear();
+    bufferBytes = 0;
+
+    // Rewinding the allocator keep its first slab, the free lists would point into released ones.
+    allocator.Reset();
+    freeLists.fill(nullptr);
+    stats.usedBytes = 0;
+    stats.pooledBytes = 0;
+}
+
+uint32_t VCL::StorageManager::GetSizeClass(size_t size, size_t alignment) const {
+    if (alignment > target.GetVectorWidthInByte())
+        return SizeClassCount;
+    uint32_t sizeClass = 0;
+    while (sizeClass < SizeClassCount && GetSizeClassSize(sizeClass) < size)
+        ++sizeClass;
+    return sizeClass;
+}
+
+VCL::BufferView VCL::StorageManager::AllocateBuffer(uint64_t elementCount, uint64_t elementSize, const BufferPolicy& policy) {
+    if (elementCount == 0 || elementSize == 0)
+        return {};
+
+    size_t mappedSize = elementCount * elementSize;
+    uint8_t* ptr = MapBuffer(mappedSize, policy.hugePages);
+    if (!ptr)
+        return {};
+
+    // Regions start on a page, huge if asked for, and on a whole vector of elements.
+    uint64_t pageSize = policy.hugePages != BufferPolicy::HugePages::None ? HugePageSize : llvm::sys::Process::getPageSizeEstimate();
+    uint64_t granule = std::lcm(pageSize, elementSize) / elementSize;
+    granule = std::lcm(granule, (uint64_t)target.GetVectorWidthInElement());
+    uint64_t granuleCount = (elementCount + granule - 1) / granule;
+
+    const std::vector<NumaNode>& nodes = GetTopology();
+    uint64_t regionCount = policy.numaAware ? nodes.size() : 1;
+    llvm::SmallVector<BufferView::Region> regions{};
+    for (uint64_t i = 0; i < regionCount; ++i) {
+        uint64_t begin = std::min(granuleCount * i / regionCount * granule, elementCount);
+        uint64_t end = std::min(granuleCount * (i + 1) / regionCount * granule, elementCount);
+        if (end > begin)
+            regions.push_back(BufferView::Region{ begin, end - begin, nodes[i].id });
+    }
+
+    // Pages are placed on the node of the thread touching them first.
+    if (policy.numaAware && nodes.size() > 1) {
+        uint64_t touchStride = llvm::sys::Process::getPageSizeEstimate();
+        std::vector<std::thread> threads{};
+        for (const BufferView::Region& region : regions) {
+            threads.emplace_back([=]() {
+                PinCurrentThreadToNode(region.node);
+                volatile uint8_t* begin = ptr + region.firstElement * elementSize;
+                uint64_t size = region.elementCount * elementSize;
+                for (uint64_t offset = 0; offset < size; offset += touchStride)
+                    begin[offset] = 0;
+            });
+        }
+        for (std::thread& thread : threads)
+            thread.join();
+    }
+
+    buffers.insert({ ptr, mappedSize });
+    bufferBytes += mappedSize;
+    stats.usedBytes += mappedSize;
+    ++stats.allocationCount;
+    return BufferView{ ptr, elementCount, elementSize, mappedSize, std::move(regions) };
+}
+
+void VCL::StorageManager::Free(BufferView& view) {
+    auto it = buffers.find(view.GetPtr());
+    if (it == buffers.end())
+        return;
+    UnmapBuffer(it->first, it->second);
+    bufferBytes -= it->second;
+    stats.usedBytes -= it->second;
+    ++stats.freeCount;
+    buffers.erase(it);
+    view = BufferView{};
+}
+
+uint32_t VCL::StorageManager::GetNodeCount() {
+    return GetTopology().size();
+}
+
+bool VCL::StorageManager::PinCurrentThreadToNode(uint32_t node) {
+#if defined(__linux__)
+    for (const NumaNode& numaNode : GetTopology()) {
+        if (numaNode.id != node || numaNode.cpus.empty())
+            continue;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (uint32_t cpu : numaNode.cpus)
+            CPU_SET(cpu, &set);
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+    }
+#endif
+    return false;
+}
\ No newline at end of file
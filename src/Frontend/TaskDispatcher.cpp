@@ -0,0 +1,59 @@
+#include <VCL/Frontend/TaskDispatcher.hpp>
+
+#include <algorithm>
+
+
+VCL::ThreadPoolTaskDispatcher::ThreadPoolTaskDispatcher(uint32_t threadCount) 
+        : threadCount{ threadCount == 0 ? std::max(std::thread::hardware_concurrency(), 1u) : threadCount } {
+    workers.reserve(this->threadCount);
+    for (uint32_t i = 0; i < this->threadCount; ++i)
+        workers.emplace_back([this]() { Run(); });
+}
+
+VCL::ThreadPoolTaskDispatcher::~ThreadPoolTaskDispatcher() {
+    shutdown();
+}
+
+void VCL::ThreadPoolTaskDispatcher::dispatch(std::unique_ptr<llvm::orc::Task> task) {
+    {
+        std::lock_guard<std::mutex> lock{ mutex };
+        if (running) {
+            tasks.push_back(std::move(task));
+        }
+    }
+    // Dispatcher already shut down, run in place rather than dropping the task.
+    if (task) {
+        task->run();
+        return;
+    }
+    condition.notify_one();
+}
+
+void VCL::ThreadPoolTaskDispatcher::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock{ mutex };
+        if (!running)
+            return;
+        running = false;
+    }
+    condition.notify_all();
+    for (std::thread& worker : workers)
+        worker.join();
+    workers.clear();
+}
+
+void VCL::ThreadPoolTaskDispatcher::Run() {
+    while (true) {
+        std::unique_ptr<llvm::orc::Task> task = nullptr;
+        {
+            std::unique_lock<std::mutex> lock{ mutex };
+            condition.wait(lock, [this]() { return !running || !tasks.empty(); });
+            // Drain the queue before stopping, pending materializations still have to complete.
+            if (tasks.empty())
+                return;
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task->run();
+    }
+}
\ No newline at end of file
@@ -67,6 +67,12 @@ VCL::TemplateSpecializationType* VCL::Sema::CreateLanesTemplateSpecializationTyp
     return GetASTContext().GetTypeCache().GetOrCreateTemplateSpecializationType(decl, argList);
 }
 
+VCL::TemplateSpecializationType* VCL::Sema::CreateSpanTemplateSpecializationType(Type* ofType) {
+    TemplateArgumentList* argList = TemplateArgumentList::Create(GetASTContext(), { TemplateArgument{ ofType } }, SourceRange{});
+    TemplateDecl* decl = LookupTemplateDecl(SymbolRef{ identifierTable.GetKeyword(TokenKind::Keyword_Span) });
+    return GetASTContext().GetTypeCache().GetOrCreateTemplateSpecializationType(decl, argList);
+}
+
 void VCL::Sema::AddIntrinsicTypes() {
     IdentifierInfo* ofTypeIdentifier = identifierTable.Get("T");
     IdentifierInfo* ofSizeIdentifier = identifierTable.Get("Size");
@@ -177,6 +183,65 @@ void VCL::Sema::AddIntrinsicFunction(FunctionDecl::IntrinsicID intrinsicID, llvm
             functionDecl->InsertBack(paramDecl);
             break;
         }
+        case FunctionDecl::IntrinsicID::Reverse:
+        case FunctionDecl::IntrinsicID::Shuffle:
+        case FunctionDecl::IntrinsicID::Rotate:
+        case FunctionDecl::IntrinsicID::Slide:
+        case FunctionDecl::IntrinsicID::Broadcast: {
+            TypeCache& typeCache = GetASTContext().GetTypeCache();
+            returnType = CreateVectorTemplateSpecializationType(ofTypeType);
+            paramsType.push_back(returnType);
+            if (intrinsicID == FunctionDecl::IntrinsicID::Slide)
+                paramsType.push_back(returnType);
+            if (intrinsicID == FunctionDecl::IntrinsicID::Shuffle)
+                paramsType.push_back(typeCache.GetOrCreateVectorType(typeCache.GetOrCreateBuiltinType(BuiltinType::Int32)));
+            else if (intrinsicID != FunctionDecl::IntrinsicID::Reverse)
+                paramsType.push_back(typeCache.GetOrCreateBuiltinType(BuiltinType::Int32));
+            for (size_t i = 0; i < paramsType.size(); ++i) {
+                std::string paramName = "Arg_" + std::to_string(i);
+                IdentifierInfo* paramIdentifier = identifierTable.Get(paramName);
+                ParamDecl* paramDecl = ParamDecl::Create(GetASTContext(), paramsType[i], paramIdentifier, VarDecl::VarAttrBitfield{}, SourceRange{});
+                functionDecl->InsertBack(paramDecl);
+            }
+            break;
+        }
+        // The state is read as the value before the first lane and receive the last lane, to carry it from call to call.
+        case FunctionDecl::IntrinsicID::PrefixSum:
+        case FunctionDecl::IntrinsicID::LinearRecurrence: {
+            returnType = CreateVectorTemplateSpecializationType(ofTypeType);
+            paramsType.push_back(returnType);
+            if (intrinsicID == FunctionDecl::IntrinsicID::LinearRecurrence)
+                paramsType.push_back(returnType);
+            paramsType.push_back(GetASTContext().GetTypeCache().GetOrCreateReferenceType(ofTypeType));
+            for (size_t i = 0; i < paramsType.size(); ++i) {
+                std::string paramName = "Arg_" + std::to_string(i);
+                IdentifierInfo* paramIdentifier = identifierTable.Get(paramName);
+                ParamDecl* paramDecl = ParamDecl::Create(GetASTContext(), paramsType[i], paramIdentifier, VarDecl::VarAttrBitfield{}, SourceRange{});
+                functionDecl->InsertBack(paramDecl);
+            }
+            break;
+        }
+        case FunctionDecl::IntrinsicID::ReduceAdd:
+        case FunctionDecl::IntrinsicID::ReduceMul:
+        case FunctionDecl::IntrinsicID::ReduceMin:
+        case FunctionDecl::IntrinsicID::ReduceMax: {
+            Type* argType = CreateVectorTemplateSpecializationType(ofTypeType);
+            paramsType.push_back(argType);
+            IdentifierInfo* paramIdentifier = identifierTable.Get("Arg_0");
+            ParamDecl* paramDecl = ParamDecl::Create(GetASTContext(), argType, paramIdentifier, VarDecl::VarAttrBitfield{}, SourceRange{});
+            functionDecl->InsertBack(paramDecl);
+            break;
+        }
+        // Take the whole Vec<bool> as T, the result of a comparison is not a Vec<T> specialization to deduce from.
+        case FunctionDecl::IntrinsicID::ReduceAny:
+        case FunctionDecl::IntrinsicID::ReduceAll: {
+            returnType = GetASTContext().GetTypeCache().GetOrCreateBuiltinType(BuiltinType::Bool);
+            paramsType.push_back(ofTypeType);
+            IdentifierInfo* paramIdentifier = identifierTable.Get("Arg_0");
+            ParamDecl* paramDecl = ParamDecl::Create(GetASTContext(), ofTypeType, paramIdentifier, VarDecl::VarAttrBitfield{}, SourceRange{});
+            functionDecl->InsertBack(paramDecl);
+            break;
+        }
         case FunctionDecl::IntrinsicID::Length: {
             returnType = GetASTContext().GetTypeCache().GetOrCreateBuiltinType(BuiltinType::UInt64);
             paramsType.push_back(ofTypeType);
@@ -204,6 +269,50 @@ void VCL::Sema::AddIntrinsicFunction(FunctionDecl::IntrinsicID intrinsicID, llvm
             functionDecl->InsertBack(param2Decl);
             break;
         }
+        // Width elements of a span from an index, in the lanes of the mask.
+        case FunctionDecl::IntrinsicID::MaskedLoad:
+        case FunctionDecl::IntrinsicID::MaskedStore: {
+            TypeCache& typeCache = GetASTContext().GetTypeCache();
+            bool isLoad = intrinsicID == FunctionDecl::IntrinsicID::MaskedLoad;
+            returnType = isLoad ? (Type*)CreateVectorTemplateSpecializationType(ofTypeType) : typeCache.GetOrCreateBuiltinType(BuiltinType::Void);
+            paramsType.push_back(CreateSpanTemplateSpecializationType(ofTypeType));
+            paramsType.push_back(typeCache.GetOrCreateBuiltinType(BuiltinType::UInt64));
+            if (!isLoad)
+                paramsType.push_back(CreateVectorTemplateSpecializationType(ofTypeType));
+            paramsType.push_back(typeCache.GetOrCreateVectorType(typeCache.GetOrCreateBuiltinType(BuiltinType::Bool)));
+            for (size_t i = 0; i < paramsType.size(); ++i) {
+                std::string paramName = "Arg_" + std::to_string(i);
+                IdentifierInfo* paramIdentifier = identifierTable.Get(paramName);
+                ParamDecl* paramDecl = ParamDecl::Create(GetASTContext(), paramsType[i], paramIdentifier, VarDecl::VarAttrBitfield{}, SourceRange{});
+                functionDecl->InsertBack(paramDecl);
+            }
+            break;
+        }
+        // Lanes below a count of remaining elements, T is the integral type of the count.
+        case FunctionDecl::IntrinsicID::LaneMask: {
+            returnType = GetASTContext().GetTypeCache().GetOrCreateVectorType(GetASTContext().GetTypeCache().GetOrCreateBuiltinType(BuiltinType::Bool));
+            paramsType.push_back(ofTypeType);
+            IdentifierInfo* paramIdentifier = identifierTable.Get("Arg_0");
+            ParamDecl* paramDecl = ParamDecl::Create(GetASTContext(), ofTypeType, paramIdentifier, VarDecl::VarAttrBitfield{}, SourceRange{});
+            functionDecl->InsertBack(paramDecl);
+            break;
+        }
+        case FunctionDecl::IntrinsicID::Gather:
+        case FunctionDecl::IntrinsicID::Scatter: {
+            bool isGather = intrinsicID == FunctionDecl::IntrinsicID::Gather;
+            returnType = isGather ? (Type*)CreateVectorTemplateSpecializationType(ofTypeType) : GetASTContext().GetTypeCache().GetOrCreateBuiltinType(BuiltinType::Void);
+            paramsType.push_back(CreateSpanTemplateSpecializationType(ofTypeType));
+            paramsType.push_back(GetASTContext().GetTypeCache().GetOrCreateVectorType(GetASTContext().GetTypeCache().GetOrCreateBuiltinType(BuiltinType::Int32)));
+            if (!isGather)
+                paramsType.push_back(CreateVectorTemplateSpecializationType(ofTypeType));
+            for (size_t i = 0; i < paramsType.size(); ++i) {
+                std::string paramName = "Arg_" + std::to_string(i);
+                IdentifierInfo* paramIdentifier = identifierTable.Get(paramName);
+                ParamDecl* paramDecl = ParamDecl::Create(GetASTContext(), paramsType[i], paramIdentifier, VarDecl::VarAttrBitfield{}, SourceRange{});
+                functionDecl->InsertBack(paramDecl);
+            }
+            break;
+        }
         default:
             diagnosticReporter.Error(Diagnostic::MissingImplementation)
                 .SetCompilerInfo(__FILE__, __func__, __LINE__)
@@ -247,6 +356,7 @@ void VCL::Sema::AddIntrinsicTemplateDecl() {
     AddIntrinsicMathFunction(FunctionDecl::IntrinsicID::Floor, "floor", 1);
     AddIntrinsicMathFunction(FunctionDecl::IntrinsicID::Ceil, "ceil", 1);
     AddIntrinsicMathFunction(FunctionDecl::IntrinsicID::Round, "round", 1);
+    AddIntrinsicMathFunction(FunctionDecl::IntrinsicID::Fract, "fract", 1);
     AddIntrinsicMathFunction(FunctionDecl::IntrinsicID::Abs, "abs", 1);
     
     AddIntrinsicMathFunction(FunctionDecl::IntrinsicID::ATan2, "atan2", 2);
@@ -259,8 +369,26 @@ void VCL::Sema::AddIntrinsicTemplateDecl() {
 
     AddIntrinsicFunction(FunctionDecl::IntrinsicID::Unpack, "unpack");
     AddIntrinsicFunction(FunctionDecl::IntrinsicID::Pack, "pack");
+    AddIntrinsicFunction(FunctionDecl::IntrinsicID::Reverse, "reverse");
+    AddIntrinsicFunction(FunctionDecl::IntrinsicID::Shuffle, "shuffle");
+    AddIntrinsicFunction(FunctionDecl::IntrinsicID::Rotate, "rotate");
+    AddIntrinsicFunction(FunctionDecl::IntrinsicID::Slide, "slide");
+    AddIntrinsicFunction(FunctionDecl::IntrinsicID::Broadcast, "broadcast");
+    AddIntrinsicFunction(FunctionDecl::IntrinsicID::ReduceAdd, "reduce_add");
+    AddIntrinsicFunction(FunctionDecl::IntrinsicID::ReduceMul, "reduce_mul");
+    AddIntrinsicFunction(FunctionDecl::IntrinsicID::ReduceMin, "reduce_min");
+    AddIntrinsicFunction(FunctionDecl::IntrinsicID::ReduceMax, "reduce_max");
+    AddIntrinsicFunction(FunctionDecl::IntrinsicID::ReduceAny, "reduce_any");
+    AddIntrinsicFunction(FunctionDecl::IntrinsicID::ReduceAll, "reduce_all");
+    AddIntrinsicFunction(FunctionDecl::IntrinsicID::PrefixSum, "prefix_sum");
+    AddIntrinsicFunction(FunctionDecl::IntrinsicID::LinearRecurrence, "linear_recurrence");
     AddIntrinsicFunction(FunctionDecl::IntrinsicID::Length, "length");
     AddIntrinsicFunction(FunctionDecl::IntrinsicID::Select, "select");
+    AddIntrinsicFunction(FunctionDecl::IntrinsicID::Gather, "gather");
+    AddIntrinsicFunction(FunctionDecl::IntrinsicID::Scatter, "scatter");
+    AddIntrinsicFunction(FunctionDecl::IntrinsicID::MaskedLoad, "masked_load");
+    AddIntrinsicFunction(FunctionDecl::IntrinsicID::MaskedStore, "masked_store");
+    AddIntrinsicFunction(FunctionDecl::IntrinsicID::LaneMask, "lane_mask");
 }
 
 void VCL::Sema::PushASTContext(ASTContext& astContext) {
@@ -389,6 +517,7 @@ bool VCL::Sema::ValidateIntrinsicFunctionDeclSpecialization(FunctionDecl* decl)
         case FunctionDecl::IntrinsicID::Floor:
         case FunctionDecl::IntrinsicID::Ceil:
         case FunctionDecl::IntrinsicID::Round:
+        case FunctionDecl::IntrinsicID::Fract:
         case FunctionDecl::IntrinsicID::FMod:
         case FunctionDecl::IntrinsicID::Pow: {
             Type* type = functionType->GetReturnType().GetType();
@@ -433,7 +562,56 @@ bool VCL::Sema::ValidateIntrinsicFunctionDeclSpecialization(FunctionDecl* decl)
         }
         case FunctionDecl::IntrinsicID::Unpack:
         case FunctionDecl::IntrinsicID::Pack:
+        case FunctionDecl::IntrinsicID::Reverse:
+        case FunctionDecl::IntrinsicID::Shuffle:
+        case FunctionDecl::IntrinsicID::Rotate:
+        case FunctionDecl::IntrinsicID::Slide:
+        case FunctionDecl::IntrinsicID::Broadcast:
             return true;
+        case FunctionDecl::IntrinsicID::ReduceAdd:
+        case FunctionDecl::IntrinsicID::ReduceMul:
+        case FunctionDecl::IntrinsicID::ReduceMin:
+        case FunctionDecl::IntrinsicID::ReduceMax: {
+            Type* type = Type::GetCanonicalType(functionType->GetReturnType().GetType());
+            if (type->GetTypeClass() == Type::BuiltinTypeClass) {
+                BuiltinType::Kind kind = ((BuiltinType*)type)->GetKind();
+                if (kind != BuiltinType::Void && kind != BuiltinType::Bool)
+                    return true;
+            }
+
+            diagnosticReporter.Error(Diagnostic::ReduceIntrinsicBadSpecialization, decl->GetIdentifierInfo()->GetName().str(), TypePrinter::Print(type))
+                .SetCompilerInfo(__FILE__, __func__, __LINE__)
+                .Report();
+            return false;
+        }
+        case FunctionDecl::IntrinsicID::PrefixSum:
+        case FunctionDecl::IntrinsicID::LinearRecurrence: {
+            Type* type = Type::GetCanonicalType(functionType->GetParamsType().back().GetType());
+            if (type->GetTypeClass() == Type::BuiltinTypeClass) {
+                BuiltinType::Kind kind = ((BuiltinType*)type)->GetKind();
+                if (kind != BuiltinType::Void && kind != BuiltinType::Bool)
+                    return true;
+            }
+
+            diagnosticReporter.Error(Diagnostic::ScanIntrinsicBadSpecialization, decl->GetIdentifierInfo()->GetName().str(), TypePrinter::Print(type))
+                .SetCompilerInfo(__FILE__, __func__, __LINE__)
+                .Report();
+            return false;
+        }
+        case FunctionDecl::IntrinsicID::ReduceAny:
+        case FunctionDecl::IntrinsicID::ReduceAll: {
+            Type* type = Type::GetCanonicalType(functionType->GetParamsType()[0].GetType());
+            if (type->GetTypeClass() == Type::VectorTypeClass) {
+                Type* elementType = Type::GetCanonicalType(((VectorType*)type)->GetElementType().GetType());
+                if (elementType->GetTypeClass() == Type::BuiltinTypeClass && ((BuiltinType*)elementType)->GetKind() == BuiltinType::Bool)
+                    return true;
+            }
+
+            diagnosticReporter.Error(Diagnostic::ReduceIntrinsicBadSpecialization, decl->GetIdentifierInfo()->GetName().str(), TypePrinter::Print(type))
+                .SetCompilerInfo(__FILE__, __func__, __LINE__)
+                .Report();
+            return false;
+        }
         case FunctionDecl::IntrinsicID::Length: {
             Type* type = Type::GetCanonicalType(functionType->GetParamsType()[0].GetType());
             Type::TypeClass typeClass = type->GetTypeClass();
@@ -448,6 +626,30 @@ bool VCL::Sema::ValidateIntrinsicFunctionDeclSpecialization(FunctionDecl* decl)
         }
         case FunctionDecl::IntrinsicID::Select:
             return true;
+        case FunctionDecl::IntrinsicID::LaneMask: {
+            Type* type = Type::GetCanonicalType(functionType->GetParamsType()[0].GetType());
+            if (type->GetTypeClass() != Type::BuiltinTypeClass || !Type::IsTypeIntegral(type)) {
+                diagnosticReporter.Error(Diagnostic::LaneMaskIntrinsicBadSpecialization, TypePrinter::Print(type))
+                    .SetCompilerInfo(__FILE__, __func__, __LINE__)
+                    .Report();
+                return false;
+            }
+            return true;
+        }
+        case FunctionDecl::IntrinsicID::Gather:
+        case FunctionDecl::IntrinsicID::Scatter:
+        case FunctionDecl::IntrinsicID::MaskedLoad:
+        case FunctionDecl::IntrinsicID::MaskedStore: {
+            Type* type = Type::GetCanonicalType(functionType->GetParamsType()[0].GetType());
+            type = Type::GetCanonicalType(((SpanType*)type)->GetElementType().GetType());
+            if (type->GetTypeClass() != Type::BuiltinTypeClass || ((BuiltinType*)type)->GetKind() == BuiltinType::Void) {
+                diagnosticReporter.Error(Diagnostic::GatherBadElementType, TypePrinter::Print(type))
+                    .SetCompilerInfo(__FILE__, __func__, __LINE__)
+                    .Report();
+                return false;
+            }
+            return true;
+        }
         default:
             diagnosticReporter.Error(Diagnostic::MissingImplementation)
                 .SetCompilerInfo(__FILE__, __func__, __LINE__)
@@ -832,15 +1034,26 @@ VCL::ReturnStmt* VCL::Sema::ActOnReturnStmt(Expr* expr, SourceRange range) {
     return ReturnStmt::Create(GetASTContext(), expr, range);
 }
 
+VCL::Expr* VCL::Sema::ActOnCondition(Expr* condition) {
+    condition = ActOnLoad(condition);
+    // Conditions on vectors are varying, each lane takes its own path through the statement.
+    TypeCache& typeCache = GetASTContext().GetTypeCache();
+    QualType toType = QualType{ typeCache.GetOrCreateBuiltinType(BuiltinType::Bool) };
+    Type* type = condition->GetResultType().GetType();
+    if (!type->IsDependent() && Type::GetCanonicalType(type)->GetTypeClass() == Type::VectorTypeClass)
+        toType = QualType{ typeCache.GetOrCreateVectorType(toType) };
+    return ActOnCast(condition, toType, condition->GetSourceRange());
+}
+
 VCL::IfStmt* VCL::Sema::ActOnIfStmt(Expr* condition, Stmt* thenStmt, Stmt* elseStmt, SourceRange range) {
-    condition = ActOnCast(ActOnLoad(condition), GetASTContext().GetTypeCache().GetOrCreateBuiltinType(BuiltinType::Bool), condition->GetSourceRange());
+    condition = ActOnCondition(condition);
     if (!condition)
         return nullptr;
     return IfStmt::Create(GetASTContext(), condition, thenStmt, elseStmt, range);
 }
 
 VCL::WhileStmt* VCL::Sema::ActOnWhileStmt(Expr* condition, Stmt* thenStmt, SourceRange range) {
-    condition = ActOnCast(ActOnLoad(condition), GetASTContext().GetTypeCache().GetOrCreateBuiltinType(BuiltinType::Bool), condition->GetSourceRange());
+    condition = ActOnCondition(condition);
     if (!condition)
         return nullptr;
     return WhileStmt::Create(GetASTContext(), condition, thenStmt, range);
@@ -848,7 +1061,7 @@ VCL::WhileStmt* VCL::Sema::ActOnWhileStmt(Expr* condition, Stmt* thenStmt, Sourc
 
 VCL::ForStmt* VCL::Sema::ActOnForStmt(Stmt* startStmt, Expr* condition, Expr* loopExpr, Stmt* thenStmt, SourceRange range) {
     if (condition) {
-        condition = ActOnCast(ActOnLoad(condition), GetASTContext().GetTypeCache().GetOrCreateBuiltinType(BuiltinType::Bool), condition->GetSourceRange());
+        condition = ActOnCondition(condition);
         if (!condition)
             return nullptr;
     }
@@ -1500,6 +1713,10 @@ VCL::Expr* VCL::Sema::ActOnSubscriptExpr(Expr* expr, Expr* index, SourceRange ra
         return nullptr;
     }
 
+    // A vector of indices address one element per lane, only spans support gathering and scattering them.
+    bool isVectorIndex = !index->GetResultType().GetType()->IsDependent() &&
+        Type::GetCanonicalType(index->GetResultType().GetType())->GetTypeClass() == Type::VectorTypeClass;
+
     if (expr->GetResultType().GetType()->IsDependent()) {
         QualType resultType = GetASTContext().GetTypeCache().GetOrCreateDependentType();
         return SubscriptExpr::Create(GetASTContext(), expr, index, resultType, range);
@@ -1512,6 +1729,13 @@ VCL::Expr* VCL::Sema::ActOnSubscriptExpr(Expr* expr, Expr* index, SourceRange ra
         resultType = spe->GetTemplateArgumentList()->GetArgs()[0].GetType();
     }
     Type* exprTrueType = Type::GetCanonicalType(type);
+    if (isVectorIndex && exprTrueType->GetTypeClass() != Type::SpanTypeClass) {
+        diagnosticReporter.Error(Diagnostic::VectorIndexMustSubscriptSpan)
+            .SetCompilerInfo(__FILE__, __func__, __LINE__)
+            .AddHint(DiagnosticHint{ index->GetSourceRange() })
+            .Report();
+        return nullptr;
+    }
     switch (exprTrueType->GetTypeClass()) {
         case Type::LanesTypeClass: {
             if (resultType.GetAsOpaquePtr() == 0)
@@ -1526,6 +1750,17 @@ VCL::Expr* VCL::Sema::ActOnSubscriptExpr(Expr* expr, Expr* index, SourceRange ra
         case Type::SpanTypeClass: {
             if (resultType.GetAsOpaquePtr() == 0)
                 resultType = ((SpanType*)exprTrueType)->GetElementType();
+            if (isVectorIndex) {
+                Type* elementType = Type::GetCanonicalType(resultType.GetType());
+                if (elementType->GetTypeClass() != Type::BuiltinTypeClass || ((BuiltinType*)elementType)->GetKind() == BuiltinType::Void) {
+                    diagnosticReporter.Error(Diagnostic::GatherBadElementType, TypePrinter::Print(resultType))
+                        .SetCompilerInfo(__FILE__, __func__, __LINE__)
+                        .AddHint(DiagnosticHint{ expr->GetSourceRange() })
+                        .Report();
+                    return nullptr;
+                }
+                resultType = QualType{ GetASTContext().GetTypeCache().GetOrCreateVectorType(resultType.GetType()), resultType.GetQualifiers() };
+            }
             return SubscriptExpr::Create(GetASTContext(), expr, index, resultType, range);
         }
         default:
@@ -92,7 +92,7 @@ bool VCL::TemplateArgumentDeducer::DeduceForType(Type* baseType, Type* substitut
     switch (baseType->GetTypeClass())
     {
         case Type::ReferenceTypeClass:
-            DeduceForType(((ReferenceType*)baseType)->GetType().GetType(), substitutedType);
+            return DeduceForType(((ReferenceType*)baseType)->GetType().GetType(), substitutedType);
         case Type::TemplateTypeParamTypeClass: {
             TemplateTypeParamType* type = (TemplateTypeParamType*)baseType;
             if (!substitutionMap.count(type->GetTemplateTypeParamDecl())) {
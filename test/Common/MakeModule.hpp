@@ -12,7 +12,7 @@
 #include "ExpectedDiagnostic.hpp"
 
 
-inline llvm::orc::ThreadSafeModule MakeModule(llvm::StringRef path) {
+inline llvm::orc::ThreadSafeModule MakeModule(llvm::StringRef path, bool useInstanceContext = false) {
     ExpectedNoDiagnostic consumer{};
     VCL::CompilerContext cc{};
     cc.GetInvocation()->GetDiagnosticOptions().SetDiagnosticConsumer(&consumer);
@@ -29,6 +29,7 @@ inline llvm::orc::ThreadSafeModule MakeModule(llvm::StringRef path) {
     REQUIRE(source != nullptr);
 
     VCL::EmitLLVMAction act{};
+    act.SetUseInstanceContext(useInstanceContext);
 
     std::shared_ptr<VCL::CompilerInstance> instance = cc.CreateInstance();
     instance->BeginSource(source);
@@ -15,6 +15,7 @@
 #include "../Common/ExpectedDiagnostic.hpp"
 #include "../Common/MakeModule.hpp"
 
+#include <algorithm>
 #include <format>
 
 
@@ -310,3 +311,115 @@ TEST_CASE("Complex Control Flow", "[Frontend][ControlFlow]") {
         REQUIRE(*o_for_basic == loop_count);
     }
 }
+
+
+TEST_CASE("Varying Control Flow", "[Frontend][ControlFlow]") {
+    ExpectedNoDiagnostic consumer{};
+    VCL::CompilerContext cc{};
+    cc.GetInvocation()->GetDiagnosticOptions().SetDiagnosticConsumer(&consumer);
+    cc.CreateDiagnosticEngine();
+    cc.CreateIdentifierTable();
+    cc.CreateAttributeTable();
+    cc.CreateDirectiveRegistry();
+    cc.CreateSourceManager();
+    cc.CreateTypeCache();
+    cc.CreateTarget();
+    cc.CreateLLVMContext();
+
+    VCL::Source* source = cc.GetSourceManager().LoadFromDisk("VCL/varyingcontrolflow.vcl");
+    REQUIRE(source != nullptr);
+
+    VCL::EmitLLVMAction act{};
+
+    std::shared_ptr<VCL::CompilerInstance> instance = cc.CreateInstance();
+    instance->BeginSource(source);
+    REQUIRE(instance->ExecuteAction(act));
+    instance->EndSource();
+
+    VCL::ExecutionSession session{};
+    REQUIRE(session.SubmitModule(act.MoveModule()));
+
+    VCL::StorageManager storage{ cc.GetTarget() };
+
+    SECTION("Value Check") {
+        uint32_t vectorWidth = cc.GetTarget().GetVectorWidthInElement();
+
+        VCL::Float32VectorView x = storage.AllocateFloat32Vector();
+        VCL::Int32VectorView n = storage.AllocateInt32Vector();
+        for (size_t i = 0; i < vectorWidth; ++i) {
+            x[i] = GENERATE(Catch::Generators::take(1,
+                    Catch::Generators::random(-100.0f, 100.0f)));
+            n[i] = GENERATE(Catch::Generators::take(1,
+                    Catch::Generators::random(-2, 20)));
+        }
+
+        REQUIRE(session.DefineSymbolPtr("x", x.GetPtr()));
+        REQUIRE(session.DefineSymbolPtr("n", n.GetPtr()));
+
+        VCL::Float32VectorView o_varying_if = (float*)session.Lookup("o_varying_if");
+        VCL::Float32VectorView o_varying_nested = (float*)session.Lookup("o_varying_nested");
+        VCL::Int32VectorView o_varying_while = (int32_t*)session.Lookup("o_varying_while");
+        VCL::Int32VectorView o_varying_for = (int32_t*)session.Lookup("o_varying_for");
+        int32_t* o_uniform_count = (int32_t*)session.Lookup("o_uniform_count");
+        REQUIRE(o_uniform_count != nullptr);
+        VCL::Float32VectorView o_varying_call = (float*)session.Lookup("o_varying_call");
+
+        void* main = session.Lookup("Main");
+        REQUIRE(main != nullptr);
+        ((void(*)())main)();
+
+        int32_t maxCount = 0;
+        for (size_t i = 0; i < vectorWidth; ++i) {
+            INFO(std::format("lane={}, x={}, n={}", i, x[i], n[i]));
+            REQUIRE(o_varying_if[i] == (x[i] > 0.0f ? x[i] * 2.0f : -x[i]));
+            REQUIRE(o_varying_nested[i] == (x[i] > -50.0f ? (x[i] < 50.0f ? 1.0f : 2.0f) : 3.0f));
+
+            int32_t count = std::max(n[i], 0);
+            REQUIRE(o_varying_while[i] == count);
+            REQUIRE(o_varying_for[i] == count * (count - 1) / 2);
+            REQUIRE(o_varying_call[i] == (x[i] > 0.0f ? x[i] : -1.0f));
+            maxCount = std::max(maxCount, count);
+        }
+
+        // The loop runs as long as any lane is active.
+        REQUIRE(*o_uniform_count == maxCount);
+    }
+
+    SECTION("Jump Out Of Varying Control Flow") {
+        ExpectedDiagnostic<VCL::Diagnostic::VaryingLoopJump> errorConsumer{};
+        VCL::CompilerContext errorCC{};
+        errorCC.GetInvocation()->GetDiagnosticOptions().SetDiagnosticConsumer(&errorConsumer);
+        errorCC.CreateDiagnosticEngine();
+        errorCC.CreateIdentifierTable();
+        errorCC.CreateAttributeTable();
+        errorCC.CreateDirectiveRegistry();
+        errorCC.CreateSourceManager();
+        errorCC.CreateTypeCache();
+        errorCC.CreateTarget();
+        errorCC.CreateLLVMContext();
+
+        VCL::Source* errorSource = errorCC.GetSourceManager().LoadFromMemory(R"(
+            in Vec<float32> x;
+            out Vec<float32> y;
+
+            [EntryPoint]
+            void Main() {
+                for (int32 i = 0; i < 4; i = i + 1) {
+                    if (x > 0.0)
+                        break;
+                    y += x;
+                }
+            }
+        )");
+        REQUIRE(errorSource != nullptr);
+
+        VCL::EmitLLVMAction errorAct{};
+
+        std::shared_ptr<VCL::CompilerInstance> errorInstance = errorCC.CreateInstance();
+        errorInstance->BeginSource(errorSource);
+        REQUIRE(!errorInstance->ExecuteAction(errorAct));
+        errorInstance->EndSource();
+
+        errorConsumer.Require();
+    }
+}
\ No newline at end of file
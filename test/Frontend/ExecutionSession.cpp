@@ -0,0 +1,455 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <VCL/Frontend/ExecutionSession.hpp>
+#include <VCL/Frontend/DataParallelDispatcher.hpp>
+#include <VCL/CodeGen/Multiversion.hpp>
+
+#include <llvm/Object/ObjectFile.h>
+
+#include <cmath>
+#include <mutex>
+#include <numeric>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../Common/ExpectedDiagnostic.hpp"
+#include "../Common/MakeModule.hpp"
+
+
+namespace {
+
+    /** Record the symbols defined by every linked object and the threads linking them. */
+    class ObjectListener : public llvm::JITEventListener {
+    public:
+        void notifyObjectLoaded(ObjectKey key, const llvm::object::ObjectFile& object, const llvm::RuntimeDyld::LoadedObjectInfo& info) override {
+            std::lock_guard<std::mutex> lock{ mutex };
+            threads.insert(std::this_thread::get_id());
+            for (const llvm::object::SymbolRef& symbol : object.symbols()) {
+                llvm::Expected<uint32_t> flags = symbol.getFlags();
+                llvm::Expected<llvm::StringRef> name = symbol.getName();
+                if (!flags || !name) {
+                    llvm::consumeError(flags.takeError());
+                    llvm::consumeError(name.takeError());
+                    continue;
+                }
+                if (!(*flags & llvm::object::SymbolRef::SF_Undefined))
+                    defined.insert(name->str());
+            }
+        }
+
+        /** Names may carry the platform global prefix. */
+        bool IsDefined(const std::string& name) {
+            std::lock_guard<std::mutex> lock{ mutex };
+            return defined.contains(name) || defined.contains("_" + name);
+        }
+
+        std::set<std::thread::id> GetThreads() {
+            std::lock_guard<std::mutex> lock{ mutex };
+            return threads;
+        }
+
+    private:
+        std::mutex mutex{};
+        std::set<std::string> defined{};
+        std::set<std::thread::id> threads{};
+    };
+
+}
+
+TEST_CASE("Lazy Compilation", "[Frontend]") {
+    VCL::ExecutionSession session{};
+    REQUIRE(session.GetThreadCount() == 0);
+    REQUIRE(session.EnableLazyCompilation());
+    REQUIRE(session.IsLazyCompilationEnabled());
+    REQUIRE(session.SubmitModule(MakeModule("VCL/controlflow.vcl")));
+
+    SECTION("Value Check") {
+        int32_t condition_value = 3;
+        int32_t loop_count = 10;
+
+        REQUIRE(session.DefineSymbolPtr("condition_value", &condition_value));
+        REQUIRE(session.DefineSymbolPtr("loop_count", &loop_count));
+
+        int32_t* o_if_elseif_else = (int32_t*)session.Lookup("o_if_elseif_else");
+        int32_t* o_while_basic = (int32_t*)session.Lookup("o_while_basic");
+        int32_t* o_for_nested = (int32_t*)session.Lookup("o_for_nested");
+
+        REQUIRE(o_if_elseif_else != nullptr);
+        REQUIRE(o_while_basic != nullptr);
+        REQUIRE(o_for_nested != nullptr);
+
+        void* main = session.Lookup("Main");
+        REQUIRE(main != nullptr);
+        ((void(*)())main)();
+
+        REQUIRE(*o_if_elseif_else == 3);
+        REQUIRE(*o_while_basic == loop_count);
+        REQUIRE(*o_for_nested == 12);
+    }
+
+    SECTION("Uncalled Functions") {
+        alignas(64) float x[16]{ 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f };
+        alignas(64) float y[16]{};
+        session.DefineDefaultMathIntrinsic();
+        REQUIRE(session.DefineSymbolPtr("x", x));
+        REQUIRE(session.DefineSymbolPtr("y", y));
+
+        ObjectListener listener{};
+        session.RegisterJITEventListener(listener);
+
+        // One entry point per math function, only the one called is compiled.
+        VCL::ModuleHandle handle = session.SubmitModule(MakeModule("VCL/mathbenchmark.vcl"));
+        REQUIRE(handle);
+        void* sin = session.Lookup(handle, "Sin");
+        REQUIRE(sin != nullptr);
+        REQUIRE(!listener.IsDefined("Sin"));
+
+        ((void(*)())sin)();
+        float* o = (float*)session.Lookup(handle, "o");
+        REQUIRE(o != nullptr);
+        REQUIRE(std::abs(o[0] - std::sin(1.0f)) <= 1e-6f);
+
+        REQUIRE(listener.IsDefined("Sin"));
+        for (const char* name : { "Cos", "Exp", "Log", "Pow" }) {
+            INFO(name);
+            REQUIRE(!listener.IsDefined(name));
+        }
+
+        session.UnregisterJITEventListener(listener);
+    }
+}
+
+TEST_CASE("Hot Swap", "[Frontend]") {
+    VCL::ExecutionSession session{};
+
+    int32_t condition_value = 3;
+    int32_t loop_count = 10;
+    float scalar_f32 = 1.0f;
+    int32_t scalar_i32 = 7;
+
+    REQUIRE(session.DefineSymbolPtr("condition_value", &condition_value));
+    REQUIRE(session.DefineSymbolPtr("loop_count", &loop_count));
+    REQUIRE(session.DefineSymbolPtr("scalar_f32", &scalar_f32));
+    REQUIRE(session.DefineSymbolPtr("scalar_i32", &scalar_i32));
+
+    VCL::ModuleHandle handle = session.SubmitModule(MakeModule("VCL/controlflow.vcl"));
+    REQUIRE(handle);
+
+    VCL::EntryPointSlot* slot = session.LookupEntryPoint(handle);
+    REQUIRE(slot != nullptr);
+    void* oldMain = slot->load();
+
+    int32_t* o_for_nested = (int32_t*)session.Lookup("o_for_nested");
+    REQUIRE(o_for_nested != nullptr);
+    ((void(*)())slot->load())();
+    REQUIRE(*o_for_nested == 12);
+
+    SECTION("Replace") {
+        VCL::ModuleHandle newHandle = session.ReplaceModule(handle, MakeModule("VCL/splatexpr.vcl"));
+        REQUIRE(newHandle);
+        REQUIRE(slot->load() != oldMain);
+
+        int32_t* o_splat_i32 = (int32_t*)session.Lookup("o_splat_i32");
+        REQUIRE(o_splat_i32 != nullptr);
+        ((void(*)())slot->load())();
+        REQUIRE(o_splat_i32[0] == scalar_i32);
+
+        REQUIRE(session.RemoveModule(handle));
+        REQUIRE(!handle);
+        REQUIRE(session.Lookup("o_for_nested") == nullptr);
+        llvm::consumeError(session.ConsumeLastError());
+    }
+
+    SECTION("Remove") {
+        REQUIRE(session.RemoveModule(handle));
+        REQUIRE(session.Lookup("Main") == nullptr);
+        llvm::consumeError(session.ConsumeLastError());
+    }
+}
+
+TEST_CASE("Hot Swap Independent Kernels", "[Frontend]") {
+    VCL::ExecutionSession session{};
+
+    int32_t condition_value = 3;
+    int32_t loop_count = 10;
+    float scalar_f32 = 1.0f;
+    int32_t scalar_i32 = 7;
+
+    REQUIRE(session.DefineSymbolPtr("condition_value", &condition_value));
+    REQUIRE(session.DefineSymbolPtr("loop_count", &loop_count));
+    REQUIRE(session.DefineSymbolPtr("scalar_f32", &scalar_f32));
+    REQUIRE(session.DefineSymbolPtr("scalar_i32", &scalar_i32));
+
+    // Both kernels define Main, each must get its own slot.
+    VCL::ModuleHandle first = session.SubmitModule(MakeModule("VCL/controlflow.vcl"));
+    VCL::ModuleHandle second = session.SubmitModule(MakeModule("VCL/splatexpr.vcl"));
+    REQUIRE(first);
+    REQUIRE(second);
+
+    VCL::EntryPointSlot* firstSlot = session.LookupEntryPoint(first);
+    VCL::EntryPointSlot* secondSlot = session.LookupEntryPoint(second);
+    REQUIRE(firstSlot != nullptr);
+    REQUIRE(secondSlot != nullptr);
+    REQUIRE(firstSlot != secondSlot);
+    REQUIRE(firstSlot->load() != secondSlot->load());
+    REQUIRE(session.LookupEntryPoint(first) == firstSlot);
+    void* firstMain = firstSlot->load();
+
+    int32_t* o_splat_i32 = (int32_t*)session.Lookup(second, "o_splat_i32");
+    REQUIRE(o_splat_i32 != nullptr);
+    ((void(*)())secondSlot->load())();
+    REQUIRE(o_splat_i32[0] == scalar_i32);
+
+    // The second kernel now run the code of the first one, on its own variables.
+    VCL::ModuleHandle replaced = session.ReplaceModule(second, MakeModule("VCL/controlflow.vcl"));
+    REQUIRE(replaced);
+    REQUIRE(session.LookupEntryPoint(replaced) == secondSlot);
+    REQUIRE(firstSlot->load() == firstMain);
+    REQUIRE(secondSlot->load() != firstMain);
+    REQUIRE(session.RemoveModule(second));
+
+    int32_t* o_for_nested = (int32_t*)session.Lookup(first, "o_for_nested");
+    int32_t* o_for_nested_replaced = (int32_t*)session.Lookup(replaced, "o_for_nested");
+    REQUIRE(o_for_nested != nullptr);
+    REQUIRE(o_for_nested_replaced != nullptr);
+    REQUIRE(o_for_nested != o_for_nested_replaced);
+
+    *o_for_nested = 0;
+    *o_for_nested_replaced = 0;
+    ((void(*)())firstSlot->load())();
+    REQUIRE(*o_for_nested == 12);
+    REQUIRE(*o_for_nested_replaced == 0);
+
+    ((void(*)())secondSlot->load())();
+    REQUIRE(*o_for_nested_replaced == 12);
+}
+
+TEST_CASE("Batch Submit", "[Frontend]") {
+    VCL::ExecutionSession session{ 4 };
+    REQUIRE(session.GetThreadCount() == 4);
+
+    ObjectListener listener{};
+    session.RegisterJITEventListener(listener);
+
+    int32_t condition_value = 3;
+    int32_t loop_count = 10;
+    float scalar_f32 = 1.0f;
+    int32_t scalar_i32 = 7;
+
+    // Modules are compiled on submission, inputs must be bound first.
+    REQUIRE(session.DefineSymbolPtr("condition_value", &condition_value));
+    REQUIRE(session.DefineSymbolPtr("loop_count", &loop_count));
+    REQUIRE(session.DefineSymbolPtr("scalar_f32", &scalar_f32));
+    REQUIRE(session.DefineSymbolPtr("scalar_i32", &scalar_i32));
+
+    // Each module has its own context so they can compile at the same time. The math
+    // module inputs are never bound, it fails to link.
+    std::vector<llvm::orc::ThreadSafeModule> modules{};
+    for (int i = 0; i < 3; ++i) {
+        modules.push_back(MakeModule("VCL/controlflow.vcl"));
+        modules.push_back(MakeModule("VCL/splatexpr.vcl"));
+    }
+    modules.push_back(MakeModule("VCL/math.vcl"));
+
+    std::vector<VCL::ModuleHandle> handles = session.SubmitModules(std::move(modules));
+    REQUIRE(handles.size() == 7);
+    for (size_t i = 0; i < 6; ++i) {
+        INFO(i);
+        REQUIRE(handles[i]);
+        REQUIRE(session.Lookup(handles[i], i % 2 == 0 ? "o_for_nested" : "o_splat_i32") != nullptr);
+    }
+    REQUIRE(!handles[6]);
+    llvm::Error err = session.ConsumeLastError();
+    bool failed = (bool)err;
+    llvm::consumeError(std::move(err));
+    REQUIRE(failed);
+
+    // Materializations ran on the pool, spread over its workers.
+    std::set<std::thread::id> threads = listener.GetThreads();
+    REQUIRE(!threads.contains(std::this_thread::get_id()));
+    REQUIRE(threads.size() > 1);
+
+    session.UnregisterJITEventListener(listener);
+}
+
+TEST_CASE("Kernel Handle", "[Frontend]") {
+    VCL::ExecutionSession session{};
+
+    int32_t condition_value = 3;
+    int32_t loop_count = 6;
+
+    REQUIRE(session.DefineSymbolPtr("condition_value", &condition_value));
+    REQUIRE(session.DefineSymbolPtr("loop_count", &loop_count));
+
+    VCL::ModuleHandle module = session.SubmitModule(MakeModule("VCL/controlflow.vcl"));
+    REQUIRE(module);
+
+    VCL::KernelHandle<void()> kernel = session.GetKernel<void()>(module);
+    REQUIRE(kernel);
+    REQUIRE(kernel.GetSymbol<int32_t>("condition_value") == &condition_value);
+    REQUIRE(kernel.GetSymbol<int32_t>("o_while_basic") != nullptr);
+    REQUIRE(kernel.GetSymbol<int32_t>("missing") == nullptr);
+
+    kernel();
+    REQUIRE(kernel.IsValid());
+    REQUIRE(*kernel.GetSymbol<int32_t>("o_while_basic") == loop_count);
+    REQUIRE(*kernel.GetSymbol<int32_t>("o_for_nested") == 12);
+
+    SECTION("Replace") {
+        // The handle stay on the old module until it is removed, then must be fetched from the new one.
+        VCL::ModuleHandle newModule = session.ReplaceModule(module, MakeModule("VCL/controlflow.vcl"));
+        REQUIRE(newModule);
+        REQUIRE(kernel.IsValid());
+        REQUIRE(session.RemoveModule(module));
+        REQUIRE(!kernel.IsValid());
+
+        kernel = session.GetKernel<void()>(newModule);
+        REQUIRE(kernel.IsValid());
+        kernel();
+        REQUIRE(*kernel.GetSymbol<int32_t>("o_for_nested") == 12);
+    }
+}
+
+struct SpanF32 {
+    float* ptr;
+    uint64_t size;
+};
+
+TEST_CASE("Data Parallel Dispatch", "[Frontend]") {
+    llvm::orc::ThreadSafeModule module = MakeModule("VCL/spanmap.vcl", true);
+    std::optional<VCL::InstanceContextLayout> layout = module.withModuleDo([](llvm::Module& module) {
+        return VCL::InstanceContextLayout::Get(module);
+    });
+    REQUIRE(layout.has_value());
+
+    VCL::ExecutionSession session{};
+    VCL::ModuleHandle handle = session.SubmitModule(std::move(module));
+    REQUIRE(handle);
+    VCL::KernelHandle<void(void*)> kernel = session.GetKernel<void(void*)>(handle);
+    REQUIRE(kernel);
+
+    constexpr uint64_t elementCount = 100003;
+    std::vector<float> values(elementCount);
+    std::vector<float> results(elementCount);
+    std::iota(values.begin(), values.end(), 0.0f);
+
+    std::vector<uint8_t> buffer(layout->GetSize() + layout->GetAlignment());
+    void* context = (void*)(((uintptr_t)buffer.data() + layout->GetAlignment() - 1) & ~(uintptr_t)(layout->GetAlignment() - 1));
+    *layout->GetFieldPtr<SpanF32>(context, "values") = SpanF32{ values.data(), elementCount };
+    *layout->GetFieldPtr<SpanF32>(context, "results") = SpanF32{ results.data(), elementCount };
+    *layout->GetFieldPtr<float>(context, "scale") = 2.0f;
+
+    VCL::DataParallelDispatcher dispatcher{ 4, 8 };
+    dispatcher.SetChunkSizeInByte(4096);
+    REQUIRE(dispatcher.GetThreadCount() == 4);
+
+    REQUIRE(dispatcher.Dispatch(kernel, *layout, context, {
+        { "values", sizeof(float) },
+        { "results", sizeof(float) }
+    }));
+
+    // 4096 bytes over two float spans, 512 elements per chunk.
+    constexpr uint64_t chunkElementCount = 512;
+    constexpr uint64_t chunkCount = (elementCount + chunkElementCount - 1) / chunkElementCount;
+
+    for (uint64_t i = 0; i < elementCount; ++i)
+        REQUIRE(results[i] == values[i] * 2.0f);
+    REQUIRE(*layout->GetFieldPtr<uint64_t>(context, "processed") == elementCount - (chunkCount - 1) * chunkElementCount);
+    REQUIRE(layout->GetFieldPtr<SpanF32>(context, "results")->ptr == results.data());
+
+    std::vector<VCL::DataParallelDispatcher::WorkerStats> stats = dispatcher.GetStats();
+    REQUIRE(stats.size() == 4);
+    uint64_t processedElementCount = 0;
+    uint64_t processedChunkCount = 0;
+    for (VCL::DataParallelDispatcher::WorkerStats& worker : stats) {
+        processedElementCount += worker.elementCount;
+        processedChunkCount += worker.chunkCount;
+    }
+    REQUIRE(processedElementCount == elementCount);
+    REQUIRE(processedChunkCount == chunkCount);
+
+    dispatcher.ResetStats();
+    REQUIRE(dispatcher.GetStats()[0].elementCount == 0);
+
+    SECTION("Mismatched Spans") {
+        layout->GetFieldPtr<SpanF32>(context, "results")->size = elementCount - 1;
+        REQUIRE(!dispatcher.Dispatch(kernel, *layout, context, {
+            { "values", sizeof(float) },
+            { "results", sizeof(float) }
+        }));
+    }
+}
+
+TEST_CASE("Multiversioning", "[Frontend]") {
+    if (!VCL::Multiversioner::IsSupported(llvm::Triple{ llvm::sys::getProcessTriple() }))
+        SKIP("multiversioning is only supported on x86-64");
+
+    ExpectedNoDiagnostic consumer{};
+    VCL::CompilerContext cc{};
+    cc.GetInvocation()->GetDiagnosticOptions().SetDiagnosticConsumer(&consumer);
+    cc.CreateDiagnosticEngine();
+    cc.CreateIdentifierTable();
+    cc.CreateAttributeTable();
+    cc.CreateDirectiveRegistry();
+    cc.CreateSourceManager();
+    cc.CreateTarget();
+    cc.CreateTypeCache();
+    cc.CreateLLVMContext();
+
+    VCL::Source* source = cc.GetSourceManager().LoadFromDisk("VCL/block.vcl");
+    REQUIRE(source != nullptr);
+
+    VCL::EmitLLVMAction act{};
+    act.SetMultiversioning(true);
+
+    std::shared_ptr<VCL::CompilerInstance> instance = cc.CreateInstance();
+    instance->BeginSource(source);
+    REQUIRE(instance->ExecuteAction(act));
+    instance->EndSource();
+
+    act.GetModule().withModuleDo([](llvm::Module& module) {
+        for (const VCL::TargetVersion& version : VCL::Multiversioner::GetVersions())
+            REQUIRE(module.getFunction(("Main." + version.name).str()) != nullptr);
+    });
+
+    VCL::ExecutionSession session{};
+    REQUIRE(session.SubmitModule(act.MoveModule()));
+
+    // Buffers are sized for the widest version, the running cpu select the actual width.
+    constexpr uint64_t maxVectorWidth = 16;
+    alignas(64) float input[maxVectorWidth]{};
+    alignas(64) float output[maxVectorWidth]{};
+    alignas(64) double time[maxVectorWidth]{};
+    alignas(64) double outputTime[maxVectorWidth]{};
+    float gain = 2.0f;
+
+    for (uint64_t i = 0; i < maxVectorWidth; ++i) {
+        input[i] = (float)i;
+        time[i] = (double)i;
+    }
+
+    REQUIRE(session.DefineSymbolPtr("input", input));
+    REQUIRE(session.DefineSymbolPtr("output", output));
+    REQUIRE(session.DefineSymbolPtr("time", time));
+    REQUIRE(session.DefineSymbolPtr("outputTime", outputTime));
+    REQUIRE(session.DefineSymbolPtr("gain", &gain));
+
+    void* getVectorWidth = session.Lookup("GetVectorWidthInElement");
+    REQUIRE(getVectorWidth != nullptr);
+    uint32_t vectorWidth = ((uint32_t(*)())getVectorWidth)();
+    REQUIRE(vectorWidth == cc.GetTarget().GetVectorWidthInElement());
+
+    void* main = session.Lookup("Main");
+    REQUIRE(main != nullptr);
+
+    // The first call resolve the version, the second one go straight to it.
+    for (int call = 0; call < 2; ++call) {
+        ((void(*)())main)();
+        for (uint32_t i = 0; i < vectorWidth; ++i) {
+            REQUIRE(output[i] == input[i] * gain);
+            REQUIRE(outputTime[i] == time[i]);
+        }
+    }
+}
\ No newline at end of file
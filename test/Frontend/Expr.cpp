@@ -15,7 +15,11 @@
 #include "../Common/ExpectedDiagnostic.hpp"
 #include "../Common/MakeModule.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <format>
+#include <limits>
+#include <vector>
 
 
 TEST_CASE("Numeric Cast", "[Frontend]") {
@@ -1091,4 +1095,468 @@ TEST_CASE("Subscript Expressions", "[Frontend]") {
         REQUIRE(valuesOut[0] == array[index]);
         REQUIRE(valuesOut[1] == span.ptr[index]);
     }
+}
+
+struct SpanFloat32Test {
+    float* ptr;
+    uint64_t size;
+};
+
+TEST_CASE("Gather Scatter Expressions", "[Frontend]") {
+    ExpectedNoDiagnostic consumer{};
+    VCL::CompilerContext cc{};
+    cc.GetInvocation()->GetDiagnosticOptions().SetDiagnosticConsumer(&consumer);
+    cc.CreateDiagnosticEngine();
+    cc.CreateIdentifierTable();
+    cc.CreateAttributeTable();
+    cc.CreateDirectiveRegistry();
+    cc.CreateSourceManager();
+    cc.CreateTypeCache();
+    cc.CreateTarget();
+    cc.CreateLLVMContext();
+
+    VCL::Source* source = cc.GetSourceManager().LoadFromDisk("VCL/gather.vcl");
+    REQUIRE(source != nullptr);
+
+    VCL::EmitLLVMAction act{};
+
+    std::shared_ptr<VCL::CompilerInstance> instance = cc.CreateInstance();
+    instance->BeginSource(source);
+    REQUIRE(instance->ExecuteAction(act));
+    instance->EndSource();
+
+    VCL::ExecutionSession session{};
+    REQUIRE(session.SubmitModule(act.MoveModule()));
+
+    VCL::StorageManager storage{ cc.GetTarget() };
+
+    SECTION("Value Check") {
+        constexpr uint32_t tableSize = 64;
+        uint32_t vectorWidth = cc.GetTarget().GetVectorWidthInElement();
+
+        std::vector<float> table(tableSize);
+        for (uint32_t i = 0; i < tableSize; ++i)
+            table[i] = GENERATE(Catch::Generators::take(1,
+                    Catch::Generators::random(-1000.0f, 1000.0f)));
+        std::vector<float> scattered(tableSize, 0.0f);
+        std::vector<int32_t> marked(tableSize, -1);
+
+        // Distinct indices, lanes writing the same element would make the scatter order matter.
+        int32_t offset = GENERATE(Catch::Generators::take(4,
+                Catch::Generators::random(0, (int32_t)tableSize - 1)));
+        VCL::Int32VectorView indices = storage.AllocateInt32Vector();
+        for (uint32_t i = 0; i < vectorWidth; ++i)
+            indices[i] = (i * 7 + offset) % tableSize;
+
+        SpanFloat32Test tableSpan{ table.data(), tableSize };
+        REQUIRE(session.DefineSymbolPtr("table", &tableSpan));
+        REQUIRE(session.DefineSymbolPtr("indices", indices.GetPtr()));
+
+        SpanFloat32Test* scatteredSpan = (SpanFloat32Test*)session.Lookup("scattered");
+        SpanTest* markedSpan = (SpanTest*)session.Lookup("marked");
+        REQUIRE(scatteredSpan != nullptr);
+        REQUIRE(markedSpan != nullptr);
+        *scatteredSpan = SpanFloat32Test{ scattered.data(), tableSize };
+        *markedSpan = SpanTest{ marked.data(), tableSize };
+
+        VCL::Float32VectorView o_subscript = (float*)session.Lookup("o_subscript");
+        VCL::Float32VectorView o_gather = (float*)session.Lookup("o_gather");
+
+        void* main = session.Lookup("Main");
+        REQUIRE(main != nullptr);
+        ((void(*)())main)();
+
+        std::vector<bool> written(tableSize, false);
+        for (uint32_t i = 0; i < vectorWidth; ++i) {
+            int32_t index = indices[i];
+            INFO(std::format("lane={}, index={}", i, index));
+            written[index] = true;
+            REQUIRE(o_subscript[i] == table[index]);
+            REQUIRE(o_gather[i] == table[index]);
+            REQUIRE(scattered[index] == table[index] * 2.0f);
+            REQUIRE(marked[index] == (index % 2 == 0 ? index : -1));
+        }
+        for (uint32_t i = 0; i < tableSize; ++i) {
+            INFO(std::format("index={}", i));
+            if (!written[i]) {
+                REQUIRE(scattered[i] == 0.0f);
+                REQUIRE(marked[i] == -1);
+            }
+        }
+    }
+
+    SECTION("Vector Index On Array") {
+        ExpectedDiagnostic<VCL::Diagnostic::VectorIndexMustSubscriptSpan> errorConsumer{};
+        VCL::CompilerContext errorCC{};
+        errorCC.GetInvocation()->GetDiagnosticOptions().SetDiagnosticConsumer(&errorConsumer);
+        errorCC.CreateDiagnosticEngine();
+        errorCC.CreateIdentifierTable();
+        errorCC.CreateAttributeTable();
+        errorCC.CreateDirectiveRegistry();
+        errorCC.CreateSourceManager();
+        errorCC.CreateTypeCache();
+        errorCC.CreateTarget();
+        errorCC.CreateLLVMContext();
+
+        VCL::Source* errorSource = errorCC.GetSourceManager().LoadFromMemory(R"(
+            in Array<float32, 16> table;
+            in Vec<int32> indices;
+            out Vec<float32> y;
+
+            [EntryPoint]
+            void Main() {
+                y = table[indices];
+            }
+        )");
+        REQUIRE(errorSource != nullptr);
+
+        VCL::EmitLLVMAction errorAct{};
+
+        std::shared_ptr<VCL::CompilerInstance> errorInstance = errorCC.CreateInstance();
+        errorInstance->BeginSource(errorSource);
+        REQUIRE(!errorInstance->ExecuteAction(errorAct));
+        errorInstance->EndSource();
+
+        errorConsumer.Require();
+    }
+}
+
+TEST_CASE("Reduction Expressions", "[Frontend]") {
+    ExpectedNoDiagnostic consumer{};
+    VCL::CompilerContext cc{};
+    cc.GetInvocation()->GetDiagnosticOptions().SetDiagnosticConsumer(&consumer);
+    cc.CreateDiagnosticEngine();
+    cc.CreateIdentifierTable();
+    cc.CreateAttributeTable();
+    cc.CreateDirectiveRegistry();
+    cc.CreateSourceManager();
+    cc.CreateTypeCache();
+    cc.CreateTarget();
+    cc.CreateLLVMContext();
+
+    VCL::Source* source = cc.GetSourceManager().LoadFromDisk("VCL/reduce.vcl");
+    REQUIRE(source != nullptr);
+
+    VCL::EmitLLVMAction act{};
+
+    std::shared_ptr<VCL::CompilerInstance> instance = cc.CreateInstance();
+    instance->BeginSource(source);
+    REQUIRE(instance->ExecuteAction(act));
+    instance->EndSource();
+
+    VCL::ExecutionSession session{};
+    REQUIRE(session.SubmitModule(act.MoveModule()));
+
+    VCL::StorageManager storage{ cc.GetTarget() };
+
+    SECTION("Value Check") {
+        uint32_t vectorWidth = cc.GetTarget().GetVectorWidthInElement();
+
+        VCL::Float32VectorView x = storage.AllocateFloat32Vector();
+        VCL::Int32VectorView n = storage.AllocateInt32Vector();
+        for (uint32_t i = 0; i < vectorWidth; ++i) {
+            x[i] = GENERATE(Catch::Generators::take(1,
+                    Catch::Generators::random(-100.0f, 100.0f)));
+            n[i] = GENERATE(Catch::Generators::take(1,
+                    Catch::Generators::random(-100, 100)));
+        }
+
+        REQUIRE(session.DefineSymbolPtr("x", x.GetPtr()));
+        REQUIRE(session.DefineSymbolPtr("n", n.GetPtr()));
+
+        float* o_add = (float*)session.Lookup("o_add");
+        float* o_ordered_add = (float*)session.Lookup("o_ordered_add");
+        float* o_mul = (float*)session.Lookup("o_mul");
+        float* o_min = (float*)session.Lookup("o_min");
+        float* o_max = (float*)session.Lookup("o_max");
+        int32_t* o_iadd = (int32_t*)session.Lookup("o_iadd");
+        int32_t* o_imin = (int32_t*)session.Lookup("o_imin");
+        int32_t* o_imax = (int32_t*)session.Lookup("o_imax");
+        bool* o_any = (bool*)session.Lookup("o_any");
+        bool* o_all = (bool*)session.Lookup("o_all");
+
+        void* main = session.Lookup("Main");
+        REQUIRE(main != nullptr);
+        ((void(*)())main)();
+
+        float sum = 0.0f;
+        float magnitude = 0.0f;
+        float product = 1.0f;
+        int32_t isum = 0;
+        bool any = false;
+        bool all = true;
+        for (uint32_t i = 0; i < vectorWidth; ++i) {
+            sum += x[i];
+            magnitude += std::abs(x[i]);
+            product *= x[i] / 100.0f;
+            isum += n[i];
+            any = any || x[i] > 90.0f;
+            all = all && n[i] > -90;
+        }
+
+        INFO(std::format("sum={}, product={}", sum, product));
+        // Reassociated sums only differ from the ordered one by rounding.
+        REQUIRE(*o_ordered_add == sum);
+        REQUIRE(std::abs(*o_add - sum) <= magnitude * vectorWidth * std::numeric_limits<float>::epsilon());
+        REQUIRE(std::abs(*o_mul - product) <= std::abs(product) * vectorWidth * 2 * std::numeric_limits<float>::epsilon());
+        REQUIRE(*o_min == *std::min_element(x.GetPtr(), x.GetPtr() + vectorWidth));
+        REQUIRE(*o_max == *std::max_element(x.GetPtr(), x.GetPtr() + vectorWidth));
+        REQUIRE(*o_iadd == isum);
+        REQUIRE(*o_imin == *std::min_element(n.GetPtr(), n.GetPtr() + vectorWidth));
+        REQUIRE(*o_imax == *std::max_element(n.GetPtr(), n.GetPtr() + vectorWidth));
+        REQUIRE(*o_any == any);
+        REQUIRE(*o_all == all);
+    }
+}
+
+TEST_CASE("Lane Shuffle Expressions", "[Frontend]") {
+    ExpectedNoDiagnostic consumer{};
+    VCL::CompilerContext cc{};
+    cc.GetInvocation()->GetDiagnosticOptions().SetDiagnosticConsumer(&consumer);
+    cc.CreateDiagnosticEngine();
+    cc.CreateIdentifierTable();
+    cc.CreateAttributeTable();
+    cc.CreateDirectiveRegistry();
+    cc.CreateSourceManager();
+    cc.CreateTypeCache();
+    cc.CreateTarget();
+    cc.CreateLLVMContext();
+
+    VCL::Source* source = cc.GetSourceManager().LoadFromDisk("VCL/shuffle.vcl");
+    REQUIRE(source != nullptr);
+
+    VCL::EmitLLVMAction act{};
+
+    std::shared_ptr<VCL::CompilerInstance> instance = cc.CreateInstance();
+    instance->BeginSource(source);
+    REQUIRE(instance->ExecuteAction(act));
+    instance->EndSource();
+
+    VCL::ExecutionSession session{};
+    REQUIRE(session.SubmitModule(act.MoveModule()));
+
+    VCL::StorageManager storage{ cc.GetTarget() };
+
+    SECTION("Value Check") {
+        int32_t vectorWidth = cc.GetTarget().GetVectorWidthInElement();
+
+        VCL::Float32VectorView a = storage.AllocateFloat32Vector();
+        VCL::Float32VectorView b = storage.AllocateFloat32Vector();
+        VCL::Int32VectorView indices = storage.AllocateInt32Vector();
+        for (int32_t i = 0; i < vectorWidth; ++i) {
+            a[i] = GENERATE(Catch::Generators::take(1,
+                    Catch::Generators::random(-100.0f, 100.0f)));
+            b[i] = GENERATE(Catch::Generators::take(1,
+                    Catch::Generators::random(-100.0f, 100.0f)));
+            indices[i] = GENERATE(Catch::Generators::take(1,
+                    Catch::Generators::random(-50, 50)));
+        }
+        int32_t k = GENERATE(Catch::Generators::take(8,
+                Catch::Generators::random(-20, 20)));
+
+        REQUIRE(session.DefineSymbolPtr("a", a.GetPtr()));
+        REQUIRE(session.DefineSymbolPtr("b", b.GetPtr()));
+        REQUIRE(session.DefineSymbolPtr("indices", indices.GetPtr()));
+        REQUIRE(session.DefineSymbolPtr("k", &k));
+
+        VCL::Float32VectorView o_reverse = (float*)session.Lookup("o_reverse");
+        VCL::Float32VectorView o_shuffle = (float*)session.Lookup("o_shuffle");
+        VCL::Float32VectorView o_shuffle_constant = (float*)session.Lookup("o_shuffle_constant");
+        VCL::Float32VectorView o_rotate = (float*)session.Lookup("o_rotate");
+        VCL::Float32VectorView o_rotate_dynamic = (float*)session.Lookup("o_rotate_dynamic");
+        VCL::Float32VectorView o_slide = (float*)session.Lookup("o_slide");
+        VCL::Float32VectorView o_slide_dynamic = (float*)session.Lookup("o_slide_dynamic");
+        VCL::Float32VectorView o_broadcast = (float*)session.Lookup("o_broadcast");
+        VCL::Float32VectorView o_broadcast_dynamic = (float*)session.Lookup("o_broadcast_dynamic");
+
+        void* main = session.Lookup("Main");
+        REQUIRE(main != nullptr);
+        ((void(*)())main)();
+
+        // Lane indices wrap around the vector width, slide offsets are clamped to it.
+        auto wrap = [&](int32_t lane) { return ((lane % vectorWidth) + vectorWidth) % vectorWidth; };
+        auto slide = [&](int32_t lane, int32_t offset) {
+            int32_t index = lane + std::clamp(offset, 0, vectorWidth);
+            return index < vectorWidth ? a[index] : b[index - vectorWidth];
+        };
+
+        for (int32_t i = 0; i < vectorWidth; ++i) {
+            INFO(std::format("lane={}, k={}, index={}", i, k, indices[i]));
+            REQUIRE(o_reverse[i] == a[vectorWidth - 1 - i]);
+            REQUIRE(o_shuffle[i] == a[wrap(indices[i])]);
+            REQUIRE(o_shuffle_constant[i] == a[1]);
+            REQUIRE(o_rotate[i] == a[wrap(i + 1)]);
+            REQUIRE(o_rotate_dynamic[i] == a[wrap(i + k)]);
+            REQUIRE(o_slide[i] == slide(i, 3));
+            REQUIRE(o_slide_dynamic[i] == slide(i, k));
+            REQUIRE(o_broadcast[i] == a[2]);
+            REQUIRE(o_broadcast_dynamic[i] == a[wrap(k)]);
+        }
+    }
+}
+
+TEST_CASE("Scan Expressions", "[Frontend]") {
+    ExpectedNoDiagnostic consumer{};
+    VCL::CompilerContext cc{};
+    cc.GetInvocation()->GetDiagnosticOptions().SetDiagnosticConsumer(&consumer);
+    cc.CreateDiagnosticEngine();
+    cc.CreateIdentifierTable();
+    cc.CreateAttributeTable();
+    cc.CreateDirectiveRegistry();
+    cc.CreateSourceManager();
+    cc.CreateTypeCache();
+    cc.CreateTarget();
+    cc.CreateLLVMContext();
+
+    VCL::Source* source = cc.GetSourceManager().LoadFromDisk("VCL/scan.vcl");
+    REQUIRE(source != nullptr);
+
+    VCL::EmitLLVMAction act{};
+
+    std::shared_ptr<VCL::CompilerInstance> instance = cc.CreateInstance();
+    instance->BeginSource(source);
+    REQUIRE(instance->ExecuteAction(act));
+    instance->EndSource();
+
+    VCL::ExecutionSession session{};
+    REQUIRE(session.SubmitModule(act.MoveModule()));
+
+    VCL::StorageManager storage{ cc.GetTarget() };
+
+    SECTION("Value Check") {
+        uint32_t vectorWidth = cc.GetTarget().GetVectorWidthInElement();
+
+        VCL::Float32VectorView x = storage.AllocateFloat32Vector();
+        VCL::Float32VectorView a = storage.AllocateFloat32Vector();
+        VCL::Int32VectorView n = storage.AllocateInt32Vector();
+        for (uint32_t i = 0; i < vectorWidth; ++i) {
+            x[i] = GENERATE(Catch::Generators::take(1,
+                    Catch::Generators::random(-1.0f, 1.0f)));
+            a[i] = GENERATE(Catch::Generators::take(1,
+                    Catch::Generators::random(0.5f, 0.99f)));
+            n[i] = GENERATE(Catch::Generators::take(1,
+                    Catch::Generators::random(-1000, 1000)));
+        }
+
+        REQUIRE(session.DefineSymbolPtr("x", x.GetPtr()));
+        REQUIRE(session.DefineSymbolPtr("a", a.GetPtr()));
+        REQUIRE(session.DefineSymbolPtr("n", n.GetPtr()));
+
+        VCL::Float32VectorView o_prefix_sum = (float*)session.Lookup("o_prefix_sum");
+        VCL::Int32VectorView o_prefix_sum_int = (int32_t*)session.Lookup("o_prefix_sum_int");
+        VCL::Float32VectorView o_recurrence = (float*)session.Lookup("o_recurrence");
+        VCL::Float32VectorView o_ordered = (float*)session.Lookup("o_ordered");
+        float* o_sum_state = (float*)session.Lookup("o_sum_state");
+        int32_t* o_int_state = (int32_t*)session.Lookup("o_int_state");
+        float* o_recurrence_state = (float*)session.Lookup("o_recurrence_state");
+        float* o_ordered_state = (float*)session.Lookup("o_ordered_state");
+
+        void* main = session.Lookup("Main");
+        REQUIRE(main != nullptr);
+        ((void(*)())main)();
+
+        // Two blocks through the scalar loops, the state of the first carried to the second.
+        std::vector<float> sum(vectorWidth);
+        std::vector<float> recurrence(vectorWidth);
+        std::vector<float> ordered(vectorWidth);
+        float sumState = 1.0f;
+        float recurrenceState = 0.5f;
+        float orderedState = 0.5f;
+        float magnitude = 1.0f;
+        for (uint32_t block = 0; block < 2; ++block) {
+            for (uint32_t i = 0; i < vectorWidth; ++i) {
+                sumState += x[i];
+                magnitude += std::abs(x[i]);
+                recurrenceState = a[i] * recurrenceState + x[i];
+                sum[i] = sumState;
+                recurrence[i] = recurrenceState;
+            }
+        }
+        for (uint32_t i = 0; i < vectorWidth; ++i) {
+            float product = a[i] * orderedState;
+            orderedState = product + x[i];
+            ordered[i] = orderedState;
+        }
+        int32_t intState = 3;
+
+        float tolerance = magnitude * vectorWidth * std::numeric_limits<float>::epsilon();
+        for (uint32_t i = 0; i < vectorWidth; ++i) {
+            intState += n[i];
+            INFO(std::format("lane={}, x={}, a={}, n={}", i, x[i], a[i], n[i]));
+            REQUIRE(std::abs(o_prefix_sum[i] - sum[i]) <= tolerance);
+            REQUIRE(o_prefix_sum_int[i] == intState);
+            REQUIRE(std::abs(o_recurrence[i] - recurrence[i]) <= tolerance);
+            REQUIRE(o_ordered[i] == ordered[i]);
+        }
+        REQUIRE(std::abs(*o_sum_state - sumState) <= tolerance);
+        REQUIRE(*o_int_state == intState);
+        REQUIRE(std::abs(*o_recurrence_state - recurrenceState) <= tolerance);
+        REQUIRE(*o_ordered_state == orderedState);
+    }
+}
+
+TEST_CASE("Masked Span Expressions", "[Frontend]") {
+    ExpectedNoDiagnostic consumer{};
+    VCL::CompilerContext cc{};
+    cc.GetInvocation()->GetDiagnosticOptions().SetDiagnosticConsumer(&consumer);
+    cc.CreateDiagnosticEngine();
+    cc.CreateIdentifierTable();
+    cc.CreateAttributeTable();
+    cc.CreateDirectiveRegistry();
+    cc.CreateSourceManager();
+    cc.CreateTypeCache();
+    cc.CreateTarget();
+    cc.CreateLLVMContext();
+
+    VCL::Source* source = cc.GetSourceManager().LoadFromDisk("VCL/maskedspan.vcl");
+    REQUIRE(source != nullptr);
+
+    VCL::EmitLLVMAction act{};
+
+    std::shared_ptr<VCL::CompilerInstance> instance = cc.CreateInstance();
+    instance->BeginSource(source);
+    REQUIRE(instance->ExecuteAction(act));
+    instance->EndSource();
+
+    VCL::ExecutionSession session{};
+    REQUIRE(session.SubmitModule(act.MoveModule()));
+
+    SECTION("Value Check") {
+        constexpr float sentinel = -12345.0f;
+        uint32_t vectorWidth = cc.GetTarget().GetVectorWidthInElement();
+
+        // Lengths which are not a multiple of the vector width leave a partial vector at the end.
+        uint64_t count = GENERATE(Catch::Generators::take(4,
+                Catch::Generators::random<uint64_t>(0, 100)));
+        float scale = GENERATE(Catch::Generators::take(1,
+                Catch::Generators::random(-10.0f, 10.0f)));
+
+        std::vector<float> values(count);
+        for (uint64_t i = 0; i < count; ++i)
+            values[i] = (float)i - 50.0f;
+        // Padding past the end of the span must stay untouched.
+        std::vector<float> results(count + vectorWidth, sentinel);
+
+        SpanFloat32Test valuesSpan{ values.data(), count };
+        REQUIRE(session.DefineSymbolPtr("values", &valuesSpan));
+        REQUIRE(session.DefineSymbolPtr("scale", &scale));
+
+        SpanFloat32Test* resultsSpan = (SpanFloat32Test*)session.Lookup("results");
+        REQUIRE(resultsSpan != nullptr);
+        *resultsSpan = SpanFloat32Test{ results.data(), count };
+
+        void* main = session.Lookup("Main");
+        REQUIRE(main != nullptr);
+        ((void(*)())main)();
+
+        INFO(std::format("count={}, scale={}", count, scale));
+        for (uint64_t i = 0; i < count; ++i) {
+            INFO(std::format("index={}", i));
+            REQUIRE(results[i] == values[i] * scale);
+        }
+        for (uint64_t i = count; i < results.size(); ++i) {
+            INFO(std::format("index={}", i));
+            REQUIRE(results[i] == sentinel);
+        }
+    }
 }
\ No newline at end of file
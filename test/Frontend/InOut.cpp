@@ -9,6 +9,8 @@
 #include <VCL/Frontend/CompilerInstance.hpp>
 #include <VCL/Frontend/FrontendActions.hpp>
 #include <VCL/Frontend/ExecutionSession.hpp>
+#include <VCL/CodeGen/InstanceContext.hpp>
+#include <VCL/CodeGen/Reflection.hpp>
 
 #include "../Common/ExpectedDiagnostic.hpp"
 #include "../Common/MakeModule.hpp"
@@ -113,4 +115,234 @@ TEST_CASE("Builtin Passthrough", "[Frontend]") {
 
         REQUIRE(ib == *ob);
     }
+}
+
+TEST_CASE("Instance Context", "[Frontend]") {
+    ExpectedNoDiagnostic consumer{};
+    VCL::CompilerContext cc{};
+    cc.GetInvocation()->GetDiagnosticOptions().SetDiagnosticConsumer(&consumer);
+    cc.CreateDiagnosticEngine();
+    cc.CreateIdentifierTable();
+    cc.CreateAttributeTable();
+    cc.CreateDirectiveRegistry();
+    cc.CreateSourceManager();
+    cc.CreateTarget();
+    cc.CreateTypeCache();
+    cc.CreateLLVMContext();
+
+    VCL::Source* source = cc.GetSourceManager().LoadFromDisk("VCL/builtinpassthrough.vcl");
+    REQUIRE(source != nullptr);
+
+    VCL::EmitLLVMAction act{};
+    act.SetUseInstanceContext(true);
+
+    std::shared_ptr<VCL::CompilerInstance> instance = cc.CreateInstance();
+    instance->BeginSource(source);
+    REQUIRE(instance->ExecuteAction(act));
+    instance->EndSource();
+
+    std::optional<VCL::InstanceContextLayout> layout = act.GetModule().withModuleDo([](llvm::Module& module) {
+        return VCL::InstanceContextLayout::Get(module);
+    });
+    REQUIRE(layout.has_value());
+    REQUIRE(layout->GetFields().size() == 22);
+    REQUIRE(layout->GetField("if32")->in);
+    REQUIRE(layout->GetField("of32")->out);
+
+    VCL::ExecutionSession session{};
+    REQUIRE(session.SubmitModule(act.MoveModule()));
+
+    // No in/out symbols are bound, everything goes through the context.
+    void* main = session.Lookup("Main");
+    REQUIRE(main != nullptr);
+
+    SECTION("Value Check") {
+        std::vector<uint8_t> contextA(layout->GetSize() + layout->GetAlignment());
+        std::vector<uint8_t> contextB(layout->GetSize() + layout->GetAlignment());
+        void* a = (void*)(((uintptr_t)contextA.data() + layout->GetAlignment() - 1) & ~(uintptr_t)(layout->GetAlignment() - 1));
+        void* b = (void*)(((uintptr_t)contextB.data() + layout->GetAlignment() - 1) & ~(uintptr_t)(layout->GetAlignment() - 1));
+
+        *layout->GetFieldPtr<float>(a, "if32") = 1.5f;
+        *layout->GetFieldPtr<int32_t>(a, "ii32") = 12;
+        *layout->GetFieldPtr<float>(b, "if32") = -4.0f;
+        *layout->GetFieldPtr<int32_t>(b, "ii32") = 7;
+
+        ((void(*)(void*))main)(a);
+        ((void(*)(void*))main)(b);
+
+        REQUIRE(*layout->GetFieldPtr<float>(a, "of32") == 1.5f);
+        REQUIRE(*layout->GetFieldPtr<int32_t>(a, "oi32") == 12);
+        REQUIRE(*layout->GetFieldPtr<float>(b, "of32") == -4.0f);
+        REQUIRE(*layout->GetFieldPtr<int32_t>(b, "oi32") == 7);
+    }
+}
+
+TEST_CASE("Block Entry Point", "[Frontend]") {
+    ExpectedNoDiagnostic consumer{};
+    VCL::CompilerContext cc{};
+    cc.GetInvocation()->GetDiagnosticOptions().SetDiagnosticConsumer(&consumer);
+    cc.CreateDiagnosticEngine();
+    cc.CreateIdentifierTable();
+    cc.CreateAttributeTable();
+    cc.CreateDirectiveRegistry();
+    cc.CreateSourceManager();
+    cc.CreateTarget();
+    cc.CreateTypeCache();
+    cc.CreateLLVMContext();
+
+    VCL::Source* source = cc.GetSourceManager().LoadFromDisk("VCL/block.vcl");
+    REQUIRE(source != nullptr);
+
+    VCL::EmitLLVMAction act{};
+
+    std::shared_ptr<VCL::CompilerInstance> instance = cc.CreateInstance();
+    instance->BeginSource(source);
+    REQUIRE(instance->ExecuteAction(act));
+    instance->EndSource();
+
+    VCL::ExecutionSession session{};
+    REQUIRE(session.SubmitModule(act.MoveModule()));
+
+    SECTION("Value Check") {
+        constexpr uint64_t stepCount = 4;
+        constexpr uint64_t maxVectorWidth = 16;
+        uint32_t vectorWidth = cc.GetTarget().GetVectorWidthInElement();
+        REQUIRE(vectorWidth <= maxVectorWidth);
+
+        // Varying inputs and outputs hold one vector per step, the advanced time only the first one.
+        alignas(64) float input[stepCount * maxVectorWidth]{};
+        alignas(64) float output[stepCount * maxVectorWidth]{};
+        alignas(64) double time[maxVectorWidth]{};
+        alignas(64) double outputTime[stepCount * maxVectorWidth]{};
+        float gain = 0.5f;
+
+        for (uint64_t i = 0; i < stepCount * vectorWidth; ++i)
+            input[i] = (float)i;
+        for (uint32_t i = 0; i < vectorWidth; ++i)
+            time[i] = 100.0 + i;
+
+        // Variables keep their single value for Main, the block read and write the buffers stored in its pointers.
+        REQUIRE(session.DefineSymbolPtr("input", input));
+        REQUIRE(session.DefineSymbolPtr("time", time));
+        REQUIRE(session.DefineSymbolPtr("gain", &gain));
+
+        void* mainBlock = session.Lookup("MainBlock");
+        if (!mainBlock) {
+            INFO(llvm::toString(session.ConsumeLastError()));
+            REQUIRE(false);
+        }
+
+        void** inputBuffer = (void**)session.Lookup("MainBlock.input");
+        void** outputBuffer = (void**)session.Lookup("MainBlock.output");
+        void** outputTimeBuffer = (void**)session.Lookup("MainBlock.outputTime");
+        REQUIRE(inputBuffer != nullptr);
+        REQUIRE(outputBuffer != nullptr);
+        REQUIRE(outputTimeBuffer != nullptr);
+        *inputBuffer = input;
+        *outputBuffer = output;
+        *outputTimeBuffer = outputTime;
+
+        ((void(*)(uint64_t))mainBlock)(stepCount);
+
+        for (uint64_t i = 0; i < stepCount * vectorWidth; ++i) {
+            REQUIRE(output[i] == input[i] * gain);
+            REQUIRE(outputTime[i] == 100.0 + i);
+        }
+        // The bound time is left untouched, the host advance it by the whole block.
+        REQUIRE(time[0] == 100.0);
+
+        // Main still run a single step on the first vector of each input, into the module outputs.
+        float* mainOutput = (float*)session.Lookup("output");
+        REQUIRE(mainOutput != nullptr);
+        REQUIRE(mainOutput != output);
+        void* main = session.Lookup("Main");
+        REQUIRE(main != nullptr);
+        ((void(*)())main)();
+        for (uint32_t i = 0; i < vectorWidth; ++i) {
+            REQUIRE(mainOutput[i] == input[i] * gain);
+            REQUIRE(output[vectorWidth + i] == input[vectorWidth + i] * gain);
+        }
+    }
+}
+
+TEST_CASE("Module Reflection", "[Frontend]") {
+    ExpectedNoDiagnostic consumer{};
+    VCL::CompilerContext cc{};
+    cc.GetInvocation()->GetDiagnosticOptions().SetDiagnosticConsumer(&consumer);
+    cc.CreateDiagnosticEngine();
+    cc.CreateIdentifierTable();
+    cc.CreateAttributeTable();
+    cc.CreateDirectiveRegistry();
+    cc.CreateSourceManager();
+    cc.CreateTarget();
+    cc.CreateTypeCache();
+    cc.CreateLLVMContext();
+
+    VCL::Source* source = cc.GetSourceManager().LoadFromDisk("VCL/reflection.vcl");
+    REQUIRE(source != nullptr);
+
+    VCL::EmitLLVMAction act{};
+
+    std::shared_ptr<VCL::CompilerInstance> instance = cc.CreateInstance();
+    instance->BeginSource(source);
+    REQUIRE(instance->ExecuteAction(act));
+    instance->EndSource();
+
+    std::optional<VCL::ModuleReflection> reflection = act.GetModule().withModuleDo([](llvm::Module& module) {
+        return VCL::ModuleReflection::Get(module);
+    });
+    REQUIRE(reflection.has_value());
+    REQUIRE(reflection->GetSymbols().size() == 4);
+
+    using TypeInfo = VCL::ModuleReflection::TypeInfo;
+    uint64_t vectorWidth = cc.GetTarget().GetVectorWidthInElement();
+    uint64_t vectorSize = cc.GetTarget().GetVectorWidthInByte();
+
+    SECTION("Record Of Vectors") {
+        const VCL::ModuleReflection::Symbol* input = reflection->GetSymbol("input");
+        REQUIRE(input != nullptr);
+        REQUIRE(input->in);
+        REQUIRE(!input->out);
+        REQUIRE(input->type->kind == TypeInfo::Kind::Record);
+        REQUIRE(input->type->size == 2 * vectorSize);
+        REQUIRE(input->type->fields.size() == 1);
+
+        const TypeInfo* channels = input->type->GetField("channels")->type;
+        REQUIRE(channels->kind == TypeInfo::Kind::Array);
+        REQUIRE(channels->elementCount == 2);
+        REQUIRE(channels->stride == vectorSize);
+        REQUIRE(channels->elementType->kind == TypeInfo::Kind::Vector);
+        REQUIRE(channels->elementType->elementCount == vectorWidth);
+        REQUIRE(channels->elementType->stride == sizeof(float));
+
+        // Same type, same description.
+        REQUIRE(reflection->GetSymbol("output")->type == input->type);
+        REQUIRE(reflection->GetSymbol("output")->out);
+
+        const TypeInfo* type = nullptr;
+        REQUIRE(reflection->GetOffset("input.channels[1]", &type) == vectorSize);
+        REQUIRE(type == channels->elementType);
+        REQUIRE(reflection->GetOffset("input.channels[1][1]") == vectorSize + sizeof(float));
+        REQUIRE(!reflection->GetOffset("input.channels[2]").has_value());
+        REQUIRE(!reflection->GetOffset("input.missing").has_value());
+    }
+
+    SECTION("Padded Record") {
+        const TypeInfo* header = reflection->GetSymbol("header")->type;
+        REQUIRE(header->name == "Header");
+        REQUIRE(header->GetField("flags")->offset == 0);
+        REQUIRE(header->GetField("gain")->offset == alignof(double));
+        REQUIRE(header->GetField("offset")->offset % header->GetField("offset")->type->alignment == 0);
+        REQUIRE(header->size % header->alignment == 0);
+        REQUIRE(header->size >= header->GetField("offset")->offset + vectorSize);
+    }
+
+    SECTION("Span") {
+        const TypeInfo* history = reflection->GetSymbol("history")->type;
+        REQUIRE(history->kind == TypeInfo::Kind::Span);
+        REQUIRE(history->size == sizeof(void*) + sizeof(uint64_t));
+        REQUIRE(history->stride == sizeof(double));
+        REQUIRE(history->elementType->name == "float64");
+        REQUIRE(!reflection->GetOffset("history[0]").has_value());
+    }
 }
\ No newline at end of file
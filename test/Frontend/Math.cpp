@@ -0,0 +1,466 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <catch2/generators/catch_generators_random.hpp>
+#include <catch2/generators/catch_generators_adapters.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include <VCL/Core/SourceManager.hpp>
+#include <VCL/Core/Source.hpp>
+#include <VCL/Core/Target.hpp>
+#include <VCL/Frontend/CompilerContext.hpp>
+#include <VCL/Frontend/CompilerInstance.hpp>
+#include <VCL/Frontend/FrontendActions.hpp>
+#include <VCL/Frontend/ExecutionSession.hpp>
+#include <VCL/Frontend/Storage.hpp>
+
+#include "../Common/ExpectedDiagnostic.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <format>
+#include <iterator>
+
+
+namespace {
+
+    /** Error of value in units of the last place of the float32 nearest to reference. */
+    double GetULPError(float value, double reference) {
+        float nearest = (float)reference;
+        double ulp = std::nextafter(std::abs(nearest), INFINITY) - std::abs(nearest);
+        return std::abs(value - reference) / ulp;
+    }
+
+    bool IsWithin(float value, double reference, double maxULP, double maxAbsoluteError = 0.0) {
+        return GetULPError(value, reference) <= maxULP || std::abs(value - reference) <= maxAbsoluteError;
+    }
+
+    bool IsWithinRelative(float value, double reference, double maxRelativeError) {
+        return std::abs(value - reference) <= maxRelativeError * std::abs(reference);
+    }
+
+}
+
+TEST_CASE("Vector Math Functions", "[Frontend][Math]") {
+    VCL::MathAccuracy accuracy = GENERATE(VCL::MathAccuracy::Libm, VCL::MathAccuracy::High, VCL::MathAccuracy::Fast);
+
+    ExpectedNoDiagnostic consumer{};
+    VCL::CompilerContext cc{};
+    cc.GetInvocation()->GetDiagnosticOptions().SetDiagnosticConsumer(&consumer);
+    cc.CreateDiagnosticEngine();
+    cc.CreateIdentifierTable();
+    cc.CreateAttributeTable();
+    cc.CreateDirectiveRegistry();
+    cc.CreateSourceManager();
+    cc.CreateTypeCache();
+    cc.CreateTarget();
+    cc.CreateLLVMContext();
+
+    VCL::Source* source = cc.GetSourceManager().LoadFromDisk("VCL/math.vcl");
+    REQUIRE(source != nullptr);
+
+    VCL::EmitLLVMAction act{};
+    act.SetMathAccuracy(accuracy);
+
+    std::shared_ptr<VCL::CompilerInstance> instance = cc.CreateInstance();
+    instance->BeginSource(source);
+    REQUIRE(instance->ExecuteAction(act));
+    instance->EndSource();
+
+    VCL::ExecutionSession session{};
+    session.DefineDefaultMathIntrinsic();
+    REQUIRE(session.SubmitModule(act.MoveModule()));
+
+    VCL::StorageManager storage{ cc.GetTarget() };
+    uint32_t vectorWidth = cc.GetTarget().GetVectorWidthInElement();
+
+    VCL::Float32VectorView angle = storage.AllocateFloat32Vector();
+    VCL::Float32VectorView e = storage.AllocateFloat32Vector();
+    VCL::Float32VectorView p = storage.AllocateFloat32Vector();
+    VCL::Float32VectorView y = storage.AllocateFloat32Vector();
+    for (size_t i = 0; i < vectorWidth; ++i) {
+        angle[i] = GENERATE(Catch::Generators::take(4,
+                Catch::Generators::random(-100.0f, 100.0f)));
+        e[i] = GENERATE(Catch::Generators::take(1,
+                Catch::Generators::random(-80.0f, 80.0f)));
+        p[i] = GENERATE(Catch::Generators::take(1,
+                Catch::Generators::random(0.01f, 100.0f)));
+        y[i] = GENERATE(Catch::Generators::take(1,
+                Catch::Generators::random(-4.0f, 4.0f)));
+    }
+
+    REQUIRE(session.DefineSymbolPtr("angle", angle.GetPtr()));
+    REQUIRE(session.DefineSymbolPtr("e", e.GetPtr()));
+    REQUIRE(session.DefineSymbolPtr("p", p.GetPtr()));
+    REQUIRE(session.DefineSymbolPtr("y", y.GetPtr()));
+
+    VCL::Float32VectorView o_sin = (float*)session.Lookup("o_sin");
+    VCL::Float32VectorView o_cos = (float*)session.Lookup("o_cos");
+    VCL::Float32VectorView o_tan = (float*)session.Lookup("o_tan");
+    VCL::Float32VectorView o_exp = (float*)session.Lookup("o_exp");
+    VCL::Float32VectorView o_exp2 = (float*)session.Lookup("o_exp2");
+    VCL::Float32VectorView o_log = (float*)session.Lookup("o_log");
+    VCL::Float32VectorView o_log2 = (float*)session.Lookup("o_log2");
+    VCL::Float32VectorView o_log10 = (float*)session.Lookup("o_log10");
+    VCL::Float32VectorView o_pow = (float*)session.Lookup("o_pow");
+    VCL::Float32VectorView o_fmod = (float*)session.Lookup("o_fmod");
+    VCL::Float32VectorView o_fract = (float*)session.Lookup("o_fract");
+
+    void* main = session.Lookup("Main");
+    REQUIRE(main != nullptr);
+    ((void(*)())main)();
+
+    // Bounds documented by MathAccuracy, libm is held to the High ones.
+    bool fast = accuracy == VCL::MathAccuracy::Fast;
+    for (size_t i = 0; i < vectorWidth; ++i) {
+        INFO(std::format("accuracy={}, lane={}, angle={}, e={}, p={}, y={}",
+            VCL::GetMathAccuracyName(accuracy).str(), i, angle[i], e[i], p[i], y[i]));
+        double tanAngle = (double)(angle[i] / 64.0f);
+        if (fast) {
+            REQUIRE(std::abs(o_sin[i] - std::sin((double)angle[i])) <= 1e-4);
+            REQUIRE(std::abs(o_cos[i] - std::cos((double)angle[i])) <= 1e-4);
+            REQUIRE(IsWithinRelative(o_exp[i], std::exp((double)e[i]), 1e-4));
+            REQUIRE(IsWithinRelative(o_exp2[i], std::exp2((double)e[i]), 1e-4));
+            REQUIRE(IsWithinRelative(o_pow[i], std::pow((double)p[i], (double)y[i]), 1e-4));
+        } else {
+            REQUIRE(IsWithin(o_sin[i], std::sin((double)angle[i]), 2.0, 1e-7));
+            REQUIRE(IsWithin(o_cos[i], std::cos((double)angle[i]), 2.0, 1e-7));
+            REQUIRE(IsWithin(o_exp[i], std::exp((double)e[i]), 2.0));
+            REQUIRE(IsWithin(o_exp2[i], std::exp2((double)e[i]), 2.0));
+            REQUIRE(IsWithin(o_pow[i], std::pow((double)p[i], (double)y[i]), 8.0));
+        }
+        REQUIRE(IsWithin(o_tan[i], std::tan(tanAngle), 4.0));
+        REQUIRE(IsWithin(o_log[i], std::log((double)p[i]), 2.0));
+        REQUIRE(IsWithin(o_log2[i], std::log2((double)p[i]), 2.0));
+        REQUIRE(IsWithin(o_log10[i], std::log10((double)p[i]), 2.0));
+
+        // Outside libm, fmod may land on the other side of a multiple of y, the same phase.
+        REQUIRE(std::abs(std::remainder(o_fmod[i] - std::fmod((double)angle[i], 2.5), 2.5)) <= 1e-5);
+        REQUIRE(o_fract[i] == angle[i] - std::floor(angle[i]));
+    }
+}
+
+TEST_CASE("Vector Math Special Values", "[Frontend][Math]") {
+    VCL::MathAccuracy accuracy = GENERATE(VCL::MathAccuracy::High, VCL::MathAccuracy::Fast);
+
+    ExpectedNoDiagnostic consumer{};
+    VCL::CompilerContext cc{};
+    cc.GetInvocation()->GetDiagnosticOptions().SetDiagnosticConsumer(&consumer);
+    cc.CreateDiagnosticEngine();
+    cc.CreateIdentifierTable();
+    cc.CreateAttributeTable();
+    cc.CreateDirectiveRegistry();
+    cc.CreateSourceManager();
+    cc.CreateTypeCache();
+    cc.CreateTarget();
+    cc.CreateLLVMContext();
+
+    VCL::Source* source = cc.GetSourceManager().LoadFromDisk("VCL/math.vcl");
+    REQUIRE(source != nullptr);
+
+    VCL::EmitLLVMAction act{};
+    act.SetMathAccuracy(accuracy);
+
+    std::shared_ptr<VCL::CompilerInstance> instance = cc.CreateInstance();
+    instance->BeginSource(source);
+    REQUIRE(instance->ExecuteAction(act));
+    instance->EndSource();
+
+    VCL::ExecutionSession session{};
+    session.DefineDefaultMathIntrinsic();
+    REQUIRE(session.SubmitModule(act.MoveModule()));
+
+    VCL::StorageManager storage{ cc.GetTarget() };
+    uint32_t vectorWidth = cc.GetTarget().GetVectorWidthInElement();
+
+    VCL::Float32VectorView angle = storage.AllocateFloat32Vector();
+    VCL::Float32VectorView e = storage.AllocateFloat32Vector();
+    VCL::Float32VectorView p = storage.AllocateFloat32Vector();
+    VCL::Float32VectorView y = storage.AllocateFloat32Vector();
+
+    REQUIRE(session.DefineSymbolPtr("angle", angle.GetPtr()));
+    REQUIRE(session.DefineSymbolPtr("e", e.GetPtr()));
+    REQUIRE(session.DefineSymbolPtr("p", p.GetPtr()));
+    REQUIRE(session.DefineSymbolPtr("y", y.GetPtr()));
+
+    VCL::Float32VectorView o_exp = (float*)session.Lookup("o_exp");
+    VCL::Float32VectorView o_exp2 = (float*)session.Lookup("o_exp2");
+    VCL::Float32VectorView o_log = (float*)session.Lookup("o_log");
+    VCL::Float32VectorView o_pow = (float*)session.Lookup("o_pow");
+    VCL::Float32VectorView o_fract = (float*)session.Lookup("o_fract");
+
+    void* main = session.Lookup("Main");
+    REQUIRE(main != nullptr);
+
+    // Values given to exp, log and pow(value, 2), as many runs as needed to go through all of them.
+    const float values[] = { 0.0f, -1.0f, 1.0f, INFINITY, 200.0f, -200.0f, NAN, 1e-40f };
+    for (size_t offset = 0; offset < std::size(values); offset += vectorWidth) {
+        for (size_t i = 0; i < vectorWidth; ++i) {
+            angle[i] = -1e-10f;
+            e[i] = values[(offset + i) % std::size(values)];
+            p[i] = values[(offset + i) % std::size(values)];
+            y[i] = 2.0f;
+        }
+
+        ((void(*)())main)();
+
+        for (size_t i = 0; i < vectorWidth; ++i) {
+            float value = values[(offset + i) % std::size(values)];
+            INFO(std::format("accuracy={}, value={}", VCL::GetMathAccuracyName(accuracy).str(), value));
+            double expected = std::exp((double)value);
+            if (std::isnan(value))
+                REQUIRE(std::isnan(o_exp[i]));
+            else if (expected > FLT_MAX)
+                REQUIRE(o_exp[i] == INFINITY);
+            else if (expected < 1e-30)
+                REQUIRE(o_exp[i] < 1e-30f);
+            else
+                REQUIRE(IsWithinRelative(o_exp[i], expected, 1e-4));
+
+            double expected2 = std::exp2((double)value);
+            if (std::isnan(value))
+                REQUIRE(std::isnan(o_exp2[i]));
+            else if (expected2 > FLT_MAX)
+                REQUIRE(o_exp2[i] == INFINITY);
+            else if (expected2 < 1e-30)
+                REQUIRE(o_exp2[i] < 1e-30f);
+            else
+                REQUIRE(IsWithinRelative(o_exp2[i], expected2, 1e-4));
+
+            if (std::isnan(value) || value < 0.0f)
+                REQUIRE(std::isnan(o_log[i]));
+            else if (value == 0.0f)
+                REQUIRE(o_log[i] == -INFINITY);
+            else if (std::isinf(value))
+                REQUIRE(o_log[i] == INFINITY);
+            else
+                REQUIRE(IsWithin(o_log[i], std::log((double)value), 2.0));
+
+            if (std::isnan(value))
+                REQUIRE(std::isnan(o_pow[i]));
+            else if (std::isinf(value))
+                REQUIRE(o_pow[i] == INFINITY);
+            else if (value * value < FLT_MIN)
+                REQUIRE(std::abs(o_pow[i]) < FLT_MIN);
+            else
+                REQUIRE(IsWithinRelative(o_pow[i], std::pow((double)value, 2.0), 1e-4));
+
+            // 1 - 1e-10 would round to 1.
+            REQUIRE(o_fract[i] == std::nextafter(1.0f, 0.0f));
+        }
+    }
+}
+
+TEST_CASE("Libmvec Vector Library", "[Frontend][Math]") {
+    ExpectedNoDiagnostic consumer{};
+    VCL::CompilerContext cc{};
+    cc.GetInvocation()->GetDiagnosticOptions().SetDiagnosticConsumer(&consumer);
+    cc.GetInvocation()->GetTargetOptions().SetVectorLibrary(VCL::VectorLibrary::Libmvec);
+    cc.CreateDiagnosticEngine();
+    cc.CreateIdentifierTable();
+    cc.CreateAttributeTable();
+    cc.CreateDirectiveRegistry();
+    cc.CreateSourceManager();
+    cc.CreateTypeCache();
+    cc.CreateTarget();
+    cc.CreateLLVMContext();
+
+    if (cc.GetTarget().GetTargetMachine()->getTargetTriple().getArch() != llvm::Triple::x86_64)
+        SKIP("libmvec is only mapped on x86-64");
+
+    VCL::ExecutionSession session{};
+    session.DefineDefaultMathIntrinsic();
+    session.DefineLibmvecIntrinsic();
+    if (llvm::Error err = session.ConsumeLastError(); err)
+        SKIP(llvm::toString(std::move(err)));
+
+    VCL::Source* source = cc.GetSourceManager().LoadFromDisk("VCL/math.vcl");
+    REQUIRE(source != nullptr);
+
+    // Math intrinsics are then left to the optimizer.
+    VCL::EmitLLVMAction act{};
+    act.SetMathAccuracy(VCL::MathAccuracy::Libm);
+
+    std::shared_ptr<VCL::CompilerInstance> instance = cc.CreateInstance();
+    instance->BeginSource(source);
+    REQUIRE(instance->ExecuteAction(act));
+    instance->EndSource();
+
+    bool callsLibmvec = act.GetModule().withModuleDo([](llvm::Module& module) {
+        for (llvm::Function& function : module)
+            if (function.isDeclaration() && function.getName().starts_with("_ZGV"))
+                return true;
+        return false;
+    });
+    // LLVM maps the SSE and AVX2 variants only, wider vectors are still split into libm calls.
+    if (cc.GetTarget().GetVectorWidthInElement() <= 8)
+        REQUIRE(callsLibmvec);
+
+    REQUIRE(session.SubmitModule(act.MoveModule()));
+
+    VCL::StorageManager storage{ cc.GetTarget() };
+    uint32_t vectorWidth = cc.GetTarget().GetVectorWidthInElement();
+
+    VCL::Float32VectorView angle = storage.AllocateFloat32Vector();
+    VCL::Float32VectorView e = storage.AllocateFloat32Vector();
+    VCL::Float32VectorView p = storage.AllocateFloat32Vector();
+    VCL::Float32VectorView y = storage.AllocateFloat32Vector();
+    for (size_t i = 0; i < vectorWidth; ++i) {
+        angle[i] = GENERATE(Catch::Generators::take(1,
+                Catch::Generators::random(-100.0f, 100.0f)));
+        e[i] = GENERATE(Catch::Generators::take(1,
+                Catch::Generators::random(-80.0f, 80.0f)));
+        p[i] = GENERATE(Catch::Generators::take(1,
+                Catch::Generators::random(0.01f, 100.0f)));
+        y[i] = GENERATE(Catch::Generators::take(1,
+                Catch::Generators::random(-4.0f, 4.0f)));
+    }
+
+    REQUIRE(session.DefineSymbolPtr("angle", angle.GetPtr()));
+    REQUIRE(session.DefineSymbolPtr("e", e.GetPtr()));
+    REQUIRE(session.DefineSymbolPtr("p", p.GetPtr()));
+    REQUIRE(session.DefineSymbolPtr("y", y.GetPtr()));
+
+    VCL::Float32VectorView o_sin = (float*)session.Lookup("o_sin");
+    VCL::Float32VectorView o_exp = (float*)session.Lookup("o_exp");
+    VCL::Float32VectorView o_log = (float*)session.Lookup("o_log");
+    VCL::Float32VectorView o_pow = (float*)session.Lookup("o_pow");
+
+    void* main = session.Lookup("Main");
+    REQUIRE(main != nullptr);
+    ((void(*)())main)();
+
+    // glibc documents libmvec within 4 ULP.
+    for (size_t i = 0; i < vectorWidth; ++i) {
+        INFO(std::format("lane={}, angle={}, e={}, p={}, y={}", i, angle[i], e[i], p[i], y[i]));
+        REQUIRE(IsWithin(o_sin[i], std::sin((double)angle[i]), 4.0, 1e-7));
+        REQUIRE(IsWithin(o_exp[i], std::exp((double)e[i]), 4.0));
+        REQUIRE(IsWithin(o_log[i], std::log((double)p[i]), 4.0));
+        REQUIRE(IsWithin(o_pow[i], std::pow((double)p[i], (double)y[i]), 4.0));
+    }
+}
+
+TEST_CASE("Approximate Functions", "[Frontend][Math]") {
+    ExpectedNoDiagnostic consumer{};
+    VCL::CompilerContext cc{};
+    cc.GetInvocation()->GetDiagnosticOptions().SetDiagnosticConsumer(&consumer);
+    cc.CreateDiagnosticEngine();
+    cc.CreateIdentifierTable();
+    cc.CreateAttributeTable();
+    cc.CreateDirectiveRegistry();
+    cc.CreateSourceManager();
+    cc.CreateTypeCache();
+    cc.CreateTarget();
+    cc.CreateLLVMContext();
+
+    VCL::Source* source = cc.GetSourceManager().LoadFromMemory(R"(
+        in Vec<float32> x;
+        out Vec<float32> o_tanh;
+        out Vec<float32> o_log2;
+        out Vec<float32> o_rsqrt;
+        out Vec<float32> o_rcp;
+
+        [EntryPoint, AllowApproxFunctions]
+        void Main() {
+            o_tanh = tanh(x);
+            o_log2 = log2(x);
+            o_rsqrt = 1.0 / sqrt(x);
+            o_rcp = 1.0 / x;
+        }
+    )");
+    REQUIRE(source != nullptr);
+
+    // The attribute take precedence over the module accuracy.
+    VCL::EmitLLVMAction act{};
+    act.SetMathAccuracy(VCL::MathAccuracy::Libm);
+
+    std::shared_ptr<VCL::CompilerInstance> instance = cc.CreateInstance();
+    instance->BeginSource(source);
+    REQUIRE(instance->ExecuteAction(act));
+    instance->EndSource();
+
+    VCL::ExecutionSession session{};
+    session.DefineDefaultMathIntrinsic();
+    REQUIRE(session.SubmitModule(act.MoveModule()));
+
+    VCL::StorageManager storage{ cc.GetTarget() };
+    uint32_t vectorWidth = cc.GetTarget().GetVectorWidthInElement();
+
+    VCL::Float32VectorView x = storage.AllocateFloat32Vector();
+    for (size_t i = 0; i < vectorWidth; ++i) {
+        x[i] = GENERATE(Catch::Generators::take(4,
+                Catch::Generators::random(0.01f, 10.0f)));
+    }
+
+    REQUIRE(session.DefineSymbolPtr("x", x.GetPtr()));
+
+    VCL::Float32VectorView o_tanh = (float*)session.Lookup("o_tanh");
+    VCL::Float32VectorView o_log2 = (float*)session.Lookup("o_log2");
+    VCL::Float32VectorView o_rsqrt = (float*)session.Lookup("o_rsqrt");
+    VCL::Float32VectorView o_rcp = (float*)session.Lookup("o_rcp");
+
+    void* main = session.Lookup("Main");
+    REQUIRE(main != nullptr);
+    ((void(*)())main)();
+
+    for (size_t i = 0; i < vectorWidth; ++i) {
+        INFO(std::format("lane={}, x={}", i, x[i]));
+        REQUIRE(IsWithinRelative(o_tanh[i], std::tanh((double)x[i]), 2e-5));
+        REQUIRE(std::abs(o_log2[i] - std::log2((double)x[i])) <= 2e-5 * std::max(std::abs(std::log2((double)x[i])), 1e-3));
+        REQUIRE(IsWithinRelative(o_rsqrt[i], 1.0 / std::sqrt((double)x[i]), 1e-6));
+        REQUIRE(IsWithinRelative(o_rcp[i], 1.0 / (double)x[i], 1e-6));
+    }
+}
+
+TEST_CASE("Vector Math Benchmark", "[Frontend][Math][.][!benchmark]") {
+    // Every tier on the same inputs, a call compute one vector.
+    for (VCL::MathAccuracy accuracy : { VCL::MathAccuracy::Libm, VCL::MathAccuracy::High, VCL::MathAccuracy::Fast }) {
+        ExpectedNoDiagnostic consumer{};
+        VCL::CompilerContext cc{};
+        cc.GetInvocation()->GetDiagnosticOptions().SetDiagnosticConsumer(&consumer);
+        cc.CreateDiagnosticEngine();
+        cc.CreateIdentifierTable();
+        cc.CreateAttributeTable();
+        cc.CreateDirectiveRegistry();
+        cc.CreateSourceManager();
+        cc.CreateTypeCache();
+        cc.CreateTarget();
+        cc.CreateLLVMContext();
+
+        VCL::Source* source = cc.GetSourceManager().LoadFromDisk("VCL/mathbenchmark.vcl");
+        REQUIRE(source != nullptr);
+
+        VCL::EmitLLVMAction act{};
+        act.SetMathAccuracy(accuracy);
+
+        std::shared_ptr<VCL::CompilerInstance> instance = cc.CreateInstance();
+        instance->BeginSource(source);
+        REQUIRE(instance->ExecuteAction(act));
+        instance->EndSource();
+
+        VCL::ExecutionSession session{};
+        session.DefineDefaultMathIntrinsic();
+        REQUIRE(session.SubmitModule(act.MoveModule()));
+
+        VCL::StorageManager storage{ cc.GetTarget() };
+        uint32_t vectorWidth = cc.GetTarget().GetVectorWidthInElement();
+
+        VCL::Float32VectorView x = storage.AllocateFloat32Vector();
+        VCL::Float32VectorView y = storage.AllocateFloat32Vector();
+        for (size_t i = 0; i < vectorWidth; ++i) {
+            x[i] = 0.5f + 7.5f * (float)i / (float)vectorWidth;
+            y[i] = -2.0f + 4.0f * (float)i / (float)vectorWidth;
+        }
+
+        REQUIRE(session.DefineSymbolPtr("x", x.GetPtr()));
+        REQUIRE(session.DefineSymbolPtr("y", y.GetPtr()));
+
+        for (llvm::StringRef name : { "Sin", "Cos", "Exp", "Log", "Pow" }) {
+            void* function = session.Lookup(name);
+            REQUIRE(function != nullptr);
+            BENCHMARK(std::format("{} {}", name.str(), VCL::GetMathAccuracyName(accuracy).str())) {
+                ((void(*)())function)();
+            };
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,113 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <VCL/Frontend/ExecutionSession.hpp>
+#include <VCL/Frontend/ObjectCache.hpp>
+
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+#include <llvm/ADT/SmallString.h>
+
+#include "../Common/ExpectedDiagnostic.hpp"
+#include "../Common/MakeModule.hpp"
+
+
+TEST_CASE("Object Cache", "[Frontend]") {
+    int32_t condition_value = 0;
+    int32_t loop_count = 0;
+    float scalar_f32 = 0.0f;
+    int32_t scalar_i32 = 0;
+
+    llvm::SmallString<128> directory{};
+    REQUIRE(!llvm::sys::fs::createUniqueDirectory("vcl-object-cache", directory));
+
+    SECTION("Hit After Miss") {
+        {
+            VCL::ExecutionSession session{};
+            REQUIRE(session.EnableObjectCache(directory, 64 * 1024 * 1024));
+            REQUIRE(session.SubmitModule(MakeModule("VCL/controlflow.vcl")));
+            REQUIRE(session.DefineSymbolPtr("condition_value", &condition_value));
+            REQUIRE(session.DefineSymbolPtr("loop_count", &loop_count));
+            REQUIRE(session.Lookup("Main") != nullptr);
+
+            REQUIRE(session.GetObjectCache()->GetHitCount() == 0);
+            REQUIRE(session.GetObjectCache()->GetMissCount() == 1);
+        }
+        {
+            VCL::ExecutionSession session{};
+            REQUIRE(session.EnableObjectCache(directory, 64 * 1024 * 1024));
+            REQUIRE(session.SubmitModule(MakeModule("VCL/controlflow.vcl")));
+            REQUIRE(session.DefineSymbolPtr("condition_value", &condition_value));
+            REQUIRE(session.DefineSymbolPtr("loop_count", &loop_count));
+            REQUIRE(session.Lookup("Main") != nullptr);
+
+            REQUIRE(session.GetObjectCache()->GetHitCount() == 1);
+            REQUIRE(session.GetObjectCache()->GetMissCount() == 0);
+        }
+    }
+
+    SECTION("Eviction") {
+        {
+            VCL::ExecutionSession session{};
+            REQUIRE(session.EnableObjectCache(directory, 1));
+            REQUIRE(session.SubmitModule(MakeModule("VCL/controlflow.vcl")));
+            REQUIRE(session.DefineSymbolPtr("condition_value", &condition_value));
+            REQUIRE(session.DefineSymbolPtr("loop_count", &loop_count));
+            REQUIRE(session.Lookup("Main") != nullptr);
+
+            REQUIRE(session.GetObjectCache()->GetEvictionCount() == 0);
+        }
+        {
+            VCL::ExecutionSession session{};
+            REQUIRE(session.EnableObjectCache(directory, 1));
+            REQUIRE(session.SubmitModule(MakeModule("VCL/splatexpr.vcl")));
+            REQUIRE(session.DefineSymbolPtr("scalar_f32", &scalar_f32));
+            REQUIRE(session.DefineSymbolPtr("scalar_i32", &scalar_i32));
+            REQUIRE(session.Lookup("Main") != nullptr);
+
+            REQUIRE(session.GetObjectCache()->GetEvictionCount() == 1);
+        }
+    }
+
+    SECTION("Evicted Before Submit") {
+        {
+            VCL::ExecutionSession session{};
+            REQUIRE(session.EnableObjectCache(directory, 64 * 1024 * 1024));
+            REQUIRE(session.SubmitModule(MakeModule("VCL/controlflow.vcl")));
+            REQUIRE(session.Lookup("Main") != nullptr);
+        }
+
+        VCL::ExecutionSession session{};
+        REQUIRE(session.EnableObjectCache(directory, 64 * 1024 * 1024));
+
+        ExpectedNoDiagnostic consumer{};
+        VCL::CompilerContext cc{};
+        cc.GetInvocation()->GetDiagnosticOptions().SetDiagnosticConsumer(&consumer);
+        cc.CreateDiagnosticEngine();
+        cc.CreateIdentifierTable();
+        cc.CreateAttributeTable();
+        cc.CreateDirectiveRegistry();
+        cc.CreateSourceManager();
+        cc.CreateTarget();
+        cc.CreateTypeCache();
+        cc.CreateLLVMContext();
+
+        VCL::Source* source = cc.GetSourceManager().LoadFromDisk("VCL/controlflow.vcl");
+        REQUIRE(source != nullptr);
+
+        VCL::EmitLLVMAction act{};
+        act.SetObjectCache(session.GetObjectCache());
+
+        std::shared_ptr<VCL::CompilerInstance> instance = cc.CreateInstance();
+        instance->BeginSource(source);
+        REQUIRE(instance->ExecuteAction(act));
+        instance->EndSource();
+        REQUIRE(act.IsCached());
+
+        // The empty module emitted for the cached object must not be compiled in its place.
+        session.GetObjectCache()->Clear();
+        REQUIRE(!session.SubmitModule(act.MoveModule()));
+        llvm::consumeError(session.ConsumeLastError());
+    }
+
+    llvm::sys::fs::remove_directories(directory);
+}
\ No newline at end of file
@@ -0,0 +1,78 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <VCL/Frontend/ExecutionSession.hpp>
+#include <VCL/Frontend/ParameterBlock.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include "../Common/ExpectedDiagnostic.hpp"
+#include "../Common/MakeModule.hpp"
+
+
+TEST_CASE("Parameter Block", "[Frontend]") {
+    struct Params {
+        float gain;
+        float offset;
+    };
+
+    SECTION("Latch At Block Boundary") {
+        VCL::Parameter<Params> params{ Params{ 1.0f, 0.0f } };
+        float value = 2.0f;
+        float result = 0.0f;
+
+        VCL::ExecutionSession session{};
+        REQUIRE(session.SubmitModule(MakeModule("VCL/parameter.vcl")));
+        REQUIRE(session.DefineParameterBlock("params", params));
+        REQUIRE(session.DefineSymbolPtr("value", &value));
+        REQUIRE(session.DefineSymbolPtr("result", &result));
+
+        void(*main)() = (void(*)())session.Lookup("Main");
+        REQUIRE(main != nullptr);
+
+        main();
+        REQUIRE(result == 2.0f);
+
+        // Nothing change for the kernel until the next latch.
+        params.Update([](Params& p) { p.gain = 3.0f; });
+        params.Update([](Params& p) { p.offset = 1.0f; });
+        main();
+        REQUIRE(result == 2.0f);
+
+        REQUIRE(params.Latch());
+        REQUIRE(!params.Latch());
+        main();
+        REQUIRE(result == 7.0f);
+    }
+
+    SECTION("No Torn Read") {
+        struct Wide {
+            uint64_t values[32];
+        };
+
+        VCL::Parameter<Wide> wide{};
+        std::atomic<bool> done = false;
+        std::thread writer{ [&]() {
+            for (uint64_t i = 1; i <= 100000; ++i)
+                wide.Update([i](Wide& w) { std::fill(std::begin(w.values), std::end(w.values), i); });
+            done = true;
+        } };
+
+        uint64_t last = 0;
+        bool consistent = true;
+        while (!done) {
+            wide.Latch();
+            Wide* bound = wide.GetBoundPtr();
+            for (uint64_t value : bound->values)
+                consistent &= value == bound->values[0];
+            consistent &= bound->values[0] >= last;
+            last = bound->values[0];
+        }
+        writer.join();
+        wide.Latch();
+
+        REQUIRE(consistent);
+        REQUIRE(wide.GetBoundPtr()->values[0] == 100000);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,150 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <VCL/Core/SourceManager.hpp>
+#include <VCL/Core/Source.hpp>
+#include <VCL/Frontend/CompilerContext.hpp>
+#include <VCL/Frontend/CompilerInstance.hpp>
+#include <VCL/Frontend/FrontendActions.hpp>
+#include <VCL/Frontend/Storage.hpp>
+#include <VCL/CodeGen/Reflection.hpp>
+
+#include "../Common/ExpectedDiagnostic.hpp"
+
+
+TEST_CASE("Storage Pool", "[Frontend]") {
+    ExpectedNoDiagnostic consumer{};
+    VCL::CompilerContext cc{};
+    cc.GetInvocation()->GetDiagnosticOptions().SetDiagnosticConsumer(&consumer);
+    cc.CreateDiagnosticEngine();
+    cc.CreateTarget();
+
+    VCL::StorageManager storage{ cc.GetTarget() };
+    uint32_t vectorWidthInByte = cc.GetTarget().GetVectorWidthInByte();
+
+    SECTION("Reuse Freed Blocks") {
+        VCL::Float32VectorView a = storage.AllocateFloat32Vector();
+        float* ptr = a.GetPtr();
+        REQUIRE((uintptr_t)ptr % vectorWidthInByte == 0);
+        storage.Free(a);
+        REQUIRE(storage.GetStats().pooledBytes == vectorWidthInByte);
+
+        // Same size class, same block.
+        VCL::Int32VectorView b = storage.AllocateInt32Vector();
+        REQUIRE((void*)b.GetPtr() == (void*)ptr);
+        REQUIRE(storage.GetStats().reuseCount == 1);
+        REQUIRE(storage.GetStats().pooledBytes == 0);
+    }
+
+    SECTION("Stable Usage") {
+        for (uint32_t i = 0; i < 64; ++i) {
+            VCL::Float64VectorView a = storage.AllocateFloat64Vector();
+            VCL::BoolVectorView b = storage.AllocateBoolVector();
+            storage.Free(a);
+            storage.Free(b);
+        }
+        uint64_t reservedBytes = storage.GetStats().reservedBytes;
+        for (uint32_t i = 0; i < 1024; ++i) {
+            VCL::Float64VectorView a = storage.AllocateFloat64Vector();
+            VCL::BoolVectorView b = storage.AllocateBoolVector();
+            storage.Free(a);
+            storage.Free(b);
+        }
+        REQUIRE(storage.GetStats().reservedBytes == reservedBytes);
+        REQUIRE(storage.GetStats().usedBytes == 0);
+        REQUIRE(storage.GetStats().allocationCount == storage.GetStats().freeCount);
+    }
+
+    SECTION("Large Blocks") {
+        size_t size = ((size_t)vectorWidthInByte << VCL::StorageManager::SizeClassCount) + 1;
+        void* ptr = storage.Allocate(size);
+        REQUIRE((uintptr_t)ptr % vectorWidthInByte == 0);
+        REQUIRE(storage.GetStats().usedBytes == size);
+        storage.Free(ptr, size);
+        REQUIRE(storage.GetStats().usedBytes == 0);
+        REQUIRE(storage.GetStats().pooledBytes == 0);
+    }
+
+    SECTION("Large Buffers") {
+        VCL::BufferPolicy policy{};
+        policy.numaAware = true;
+        uint64_t elementCount = 3 * 1024 * 1024 + 5;
+        VCL::BufferView buffer = storage.AllocateBuffer(elementCount, sizeof(float), policy);
+        REQUIRE(buffer.IsValid());
+        REQUIRE((uintptr_t)buffer.GetPtr() % vectorWidthInByte == 0);
+        REQUIRE(buffer.GetMappedSize() >= elementCount * sizeof(float));
+        REQUIRE(storage.GetStats().usedBytes == buffer.GetMappedSize());
+
+        // Regions cover every element in order, each starting on a whole vector.
+        REQUIRE(buffer.GetRegions().size() <= VCL::StorageManager::GetNodeCount());
+        uint64_t next = 0;
+        for (const VCL::BufferView::Region& region : buffer.GetRegions()) {
+            REQUIRE(region.firstElement == next);
+            REQUIRE((uintptr_t)buffer.GetPtr<float>(region) % vectorWidthInByte == 0);
+            next += region.elementCount;
+        }
+        REQUIRE(next == elementCount);
+
+        buffer.GetPtr<float>()[elementCount - 1] = 1.0f;
+        storage.Free(buffer);
+        REQUIRE(!buffer.IsValid());
+        REQUIRE(storage.GetStats().usedBytes == 0);
+    }
+
+    SECTION("Reset") {
+        storage.AllocateFloat32Vector();
+        storage.Free(storage.AllocateFloat32Vector());
+        storage.Reset();
+        REQUIRE(storage.GetStats().usedBytes == 0);
+        REQUIRE(storage.GetStats().pooledBytes == 0);
+        REQUIRE(storage.AllocateFloat32Vector().IsValid());
+    }
+}
+
+TEST_CASE("Storage Record", "[Frontend]") {
+    ExpectedNoDiagnostic consumer{};
+    VCL::CompilerContext cc{};
+    cc.GetInvocation()->GetDiagnosticOptions().SetDiagnosticConsumer(&consumer);
+    cc.CreateDiagnosticEngine();
+    cc.CreateIdentifierTable();
+    cc.CreateAttributeTable();
+    cc.CreateDirectiveRegistry();
+    cc.CreateSourceManager();
+    cc.CreateTarget();
+    cc.CreateTypeCache();
+    cc.CreateLLVMContext();
+
+    VCL::Source* source = cc.GetSourceManager().LoadFromDisk("VCL/reflection.vcl");
+    REQUIRE(source != nullptr);
+
+    VCL::EmitLLVMAction act{};
+
+    std::shared_ptr<VCL::CompilerInstance> instance = cc.CreateInstance();
+    instance->BeginSource(source);
+    REQUIRE(instance->ExecuteAction(act));
+    instance->EndSource();
+
+    std::optional<VCL::ModuleReflection> reflection = act.GetModule().withModuleDo([](llvm::Module& module) {
+        return VCL::ModuleReflection::Get(module);
+    });
+    REQUIRE(reflection.has_value());
+
+    VCL::StorageManager storage{ cc.GetTarget() };
+    uint32_t vectorWidth = cc.GetTarget().GetVectorWidthInElement();
+
+    const VCL::ModuleReflection::TypeInfo* type = reflection->GetSymbol("input")->type;
+    VCL::RecordView buffer = storage.AllocateRecord(*type);
+    REQUIRE(buffer.IsValid());
+    REQUIRE((uintptr_t)buffer.GetPtr() % type->alignment == 0);
+
+    float* left = buffer.GetPtr<float>("channels[0]");
+    float* right = buffer.GetPtr<float>("channels[1]");
+    REQUIRE(left == (float*)buffer.GetPtr());
+    REQUIRE(right == left + vectorWidth);
+    REQUIRE(buffer.GetPtr<float>("channels[2]") == nullptr);
+    for (uint32_t i = 0; i < 2 * vectorWidth; ++i)
+        REQUIRE(left[i] == 0.0f);
+
+    storage.Free(buffer);
+    REQUIRE(storage.GetStats().usedBytes == 0);
+    REQUIRE(storage.AllocateRecord(*type).GetPtr() == buffer.GetPtr());
+}
\ No newline at end of file
@@ -0,0 +1,45 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <VCL/Core/Target.hpp>
+#include <VCL/Core/TargetOptions.hpp>
+#include <VCL/Frontend/CompilerContext.hpp>
+
+#include <llvm/TargetParser/Host.h>
+
+#include "../Common/ExpectedDiagnostic.hpp"
+
+
+TEST_CASE("Target Options", "[Frontend]") {
+    VCL::TargetOptions options{};
+    std::string cpu = options.GetCPU().str();
+    std::string features = options.GetFeatures().str();
+
+    SECTION("Host Triple") {
+        std::string triple = llvm::sys::getProcessTriple();
+        options.SetTriple(triple);
+        REQUIRE(options.GetCPU() == cpu);
+        REQUIRE(options.GetFeatures() == features);
+    }
+
+    SECTION("Cross Triple") {
+        std::string triple = llvm::Triple{ llvm::sys::getProcessTriple() }.getArch() == llvm::Triple::aarch64 ?
+            "x86_64-unknown-linux-gnu" : "aarch64-unknown-linux-gnu";
+        options.SetTriple(triple);
+        REQUIRE(options.GetCPU() == "generic");
+        REQUIRE(options.GetFeatures().empty());
+    }
+}
+
+TEST_CASE("Invalid Target", "[Frontend]") {
+    ExpectedDiagnostic<VCL::Diagnostic::InvalidTarget> consumer{};
+    VCL::CompilerContext cc{};
+    cc.GetInvocation()->GetDiagnosticOptions().SetDiagnosticConsumer(&consumer);
+    cc.CreateDiagnosticEngine();
+    cc.CreateSourceManager();
+
+    std::string triple = "nonexistent-unknown-none";
+    cc.GetInvocation()->GetTargetOptions().SetTriple(triple);
+    REQUIRE(!cc.CreateTarget());
+    REQUIRE(!cc.HasTarget());
+    consumer.Require();
+}
\ No newline at end of file